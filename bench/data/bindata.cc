@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "data/bindata.h"
+
+#include "benchmark/benchmark.h"
+
+namespace veles {
+namespace data {
+
+namespace {
+
+const size_t k_slice_size = 4096;
+
+BinData makeBlob(size_t size) {
+  BinData res(8, size);
+  uint8_t* raw = res.rawData();
+  for (size_t i = 0; i < size; ++i) {
+    raw[i] = static_cast<uint8_t>(i * 37);
+  }
+  return res;
+}
+
+/** What copying used to cost: a fresh allocation and a full memcpy.  */
+BinData deepCopy(const BinData& src, size_t offset, size_t size) {
+  return BinData(src.width(), size, src.rawData(offset));
+}
+
+}  // namespace
+
+void BM_BinDataCopyShared(benchmark::State& state) {
+  const BinData blob = makeBlob(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    BinData copy(blob);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BinDataCopyShared)->Range(1 << 10, 1 << 26);
+
+void BM_BinDataCopyDeep(benchmark::State& state) {
+  const BinData blob = makeBlob(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    BinData copy = deepCopy(blob, 0, blob.size());
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BinDataCopyDeep)->Range(1 << 10, 1 << 26);
+
+void BM_BinDataSliceShared(benchmark::State& state) {
+  const BinData blob = makeBlob(static_cast<size_t>(state.range(0)));
+  size_t offset = 0;
+  for (auto _ : state) {
+    BinData slice = blob.data(offset, k_slice_size);
+    benchmark::DoNotOptimize(slice);
+    offset = (offset + k_slice_size) % (blob.size() - k_slice_size);
+  }
+  state.SetBytesProcessed(state.iterations() * k_slice_size);
+}
+BENCHMARK(BM_BinDataSliceShared)->Range(1 << 16, 1 << 26);
+
+void BM_BinDataSliceDeep(benchmark::State& state) {
+  const BinData blob = makeBlob(static_cast<size_t>(state.range(0)));
+  size_t offset = 0;
+  for (auto _ : state) {
+    BinData slice = deepCopy(blob, offset, k_slice_size);
+    benchmark::DoNotOptimize(slice);
+    offset = (offset + k_slice_size) % (blob.size() - k_slice_size);
+  }
+  state.SetBytesProcessed(state.iterations() * k_slice_size);
+}
+BENCHMARK(BM_BinDataSliceDeep)->Range(1 << 16, 1 << 26);
+
+void BM_BinDataCopyThenWrite(benchmark::State& state) {
+  const BinData blob = makeBlob(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    BinData copy(blob);
+    copy.setElement64(0, 0xff);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BinDataCopyThenWrite)->Range(1 << 10, 1 << 26);
+
+}  // namespace data
+}  // namespace veles
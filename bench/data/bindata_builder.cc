@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "benchmark/benchmark.h"
+#include "data/bindata_builder.h"
+
+namespace veles {
+namespace data {
+
+const size_t k_piece_size = 64;
+
+void BM_AppendConcat(benchmark::State& state) {
+  BinData piece(8, k_piece_size);
+  for (auto _ : state) {
+    BinData res(8, 0);
+    for (int64_t i = 0; i < state.range(0); i++) {
+      res = res + piece;
+    }
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * k_piece_size);
+}
+BENCHMARK(BM_AppendConcat)->Range(8, 1 << 12);
+
+void BM_AppendBuilder(benchmark::State& state) {
+  BinData piece(8, k_piece_size);
+  for (auto _ : state) {
+    BinDataBuilder builder(8);
+    for (int64_t i = 0; i < state.range(0); i++) {
+      builder.append(piece);
+    }
+    BinData res = builder.finish();
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * k_piece_size);
+}
+BENCHMARK(BM_AppendBuilder)->Range(8, 1 << 12);
+
+}  // namespace data
+}  // namespace veles
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "benchmark/benchmark.h"
+#include "data/bindata_view.h"
+
+namespace veles {
+namespace data {
+
+const size_t k_num_elements = 1 << 16;
+
+template <typename T>
+void BM_SumElement64(benchmark::State& state) {
+  BinData data(sizeof(T) * 8, k_num_elements);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+      sum += data.element64(i);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_elements);
+}
+BENCHMARK_TEMPLATE(BM_SumElement64, uint8_t);
+BENCHMARK_TEMPLATE(BM_SumElement64, uint16_t);
+BENCHMARK_TEMPLATE(BM_SumElement64, uint32_t);
+BENCHMARK_TEMPLATE(BM_SumElement64, uint64_t);
+
+template <typename T>
+void BM_SumView(benchmark::State& state) {
+  BinData data(sizeof(T) * 8, k_num_elements);
+  for (auto _ : state) {
+    BinDataView<T> view(data);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < view.size(); i++) {
+      sum += view[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_elements);
+}
+BENCHMARK_TEMPLATE(BM_SumView, uint8_t);
+BENCHMARK_TEMPLATE(BM_SumView, uint16_t);
+BENCHMARK_TEMPLATE(BM_SumView, uint32_t);
+BENCHMARK_TEMPLATE(BM_SumView, uint64_t);
+
+}  // namespace data
+}  // namespace veles
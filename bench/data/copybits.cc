@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "data/bindata.h"
+
+namespace veles {
+namespace data {
+
+void BM_CopyBitsAligned(benchmark::State& state) {
+  size_t bits = static_cast<size_t>(state.range(0));
+  std::vector<uint8_t> src(bits / 8 + 2, 0x5a);
+  std::vector<uint8_t> dst(bits / 8 + 2);
+  for (auto _ : state) {
+    BinData::copyBits(dst.data(), 0, src.data(), 0,
+                      static_cast<unsigned>(bits));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) / 8);
+}
+BENCHMARK(BM_CopyBitsAligned)->Range(64, 1 << 24);
+
+void BM_CopyBitsShifted(benchmark::State& state) {
+  size_t bits = static_cast<size_t>(state.range(0));
+  std::vector<uint8_t> src(bits / 8 + 2, 0x5a);
+  std::vector<uint8_t> dst(bits / 8 + 2);
+  for (auto _ : state) {
+    BinData::copyBits(dst.data(), 0, src.data(), 3,
+                      static_cast<unsigned>(bits));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) / 8);
+}
+BENCHMARK(BM_CopyBitsShifted)->Range(64, 1 << 24);
+
+void BM_CopyBitsBothShifted(benchmark::State& state) {
+  size_t bits = static_cast<size_t>(state.range(0));
+  std::vector<uint8_t> src(bits / 8 + 2, 0x5a);
+  std::vector<uint8_t> dst(bits / 8 + 2);
+  for (auto _ : state) {
+    BinData::copyBits(dst.data(), 5, src.data(), 2,
+                      static_cast<unsigned>(bits));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) / 8);
+}
+BENCHMARK(BM_CopyBitsBothShifted)->Range(64, 1 << 24);
+
+}  // namespace data
+}  // namespace veles
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "benchmark/benchmark.h"
+#include "data/repack.h"
+
+namespace veles {
+namespace data {
+
+void BM_Repack(benchmark::State& state, Endian endian, uint64_t from_width,
+               uint64_t to_width, uint64_t high_pad) {
+  size_t octets = static_cast<size_t>(state.range(0));
+  BinData src(from_width, octets * 8 / from_width);
+  Repacker format{endian, from_width, to_width, high_pad};
+  size_t num_elements = format.repackableSize(src.size());
+  for (auto _ : state) {
+    BinData res = format.repack(src, 0, num_elements);
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_Repack, Copy8To32Little, Endian::LITTLE, 8, 32, 0)
+    ->Range(1 << 10, 1 << 22);
+BENCHMARK_CAPTURE(BM_Repack, Swap8To32Big, Endian::BIG, 8, 32, 0)
+    ->Range(1 << 10, 1 << 22);
+BENCHMARK_CAPTURE(BM_Repack, Swap64To8Big, Endian::BIG, 64, 8, 0)
+    ->Range(1 << 10, 1 << 22);
+BENCHMARK_CAPTURE(BM_Repack, Split8To4Big, Endian::BIG, 8, 4, 0)
+    ->Range(1 << 10, 1 << 22);
+// Padded formats always take the generic path.
+BENCHMARK_CAPTURE(BM_Repack, Generic8To24Big, Endian::BIG, 8, 24, 8)
+    ->Range(1 << 10, 1 << 22);
+
+}  // namespace data
+}  // namespace veles
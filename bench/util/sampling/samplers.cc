@@ -0,0 +1,279 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "util/sampling/data_source.h"
+#include "util/sampling/entropy_sampler.h"
+#include "util/sampling/progressive_sampler.h"
+#include "util/sampling/sample_pyramid.h"
+#include "util/sampling/uniform_sampler.h"
+#include "util/stats/byte_stats.h"
+
+namespace veles {
+namespace util {
+
+namespace {
+
+/*****************************************************************************/
+/* Data */
+/*****************************************************************************/
+
+/** Bytes of a made up binary: regions of zero padding, code-like bytes,
+    text and compressed-like (random) data, of varying length.  */
+std::vector<char> benchData(size_t size) {
+  static const uint8_t k_opcodes[] = {0x48, 0x89, 0x8b, 0xe8, 0x00, 0xff};
+  std::mt19937_64 gen(1);
+  std::vector<char> res(size);
+  size_t pos = 0;
+  while (pos < size) {
+    size_t length = std::min<size_t>(size - pos, 4096 << (gen() % 10));
+    int kind = static_cast<int>(gen() % 4);
+    for (size_t i = pos; i < pos + length; ++i) {
+      uint64_t r = gen();
+      switch (kind) {
+        case 0:
+          res[i] = 0;
+          break;
+        case 1:
+          // Mostly a few common opcodes, some immediates.
+          res[i] = static_cast<char>(r % 4 != 0 ? k_opcodes[r % 6] : r >> 8);
+          break;
+        case 2:
+          res[i] = static_cast<char>(r % 6 == 0 ? ' ' : 'a' + (r >> 8) % 26);
+          break;
+        default:
+          res[i] = static_cast<char>(r);
+      }
+    }
+    pos += length;
+  }
+  return res;
+}
+
+/** Bench data of a given size, with histograms of all of it.  */
+struct Blob {
+  std::vector<char> data;
+  std::shared_ptr<const DataSource> source;
+  stats::ByteHistogram bytes;
+  std::vector<uint64_t> digrams;
+};
+
+const Blob& blob(size_t size) {
+  static std::map<size_t, std::unique_ptr<Blob>> blobs;
+  auto& res = blobs[size];
+  if (res == nullptr) {
+    res.reset(new Blob);
+    res->data = benchData(size);
+    res->source = std::make_shared<QByteArrayDataSource>(
+        QByteArray::fromRawData(res->data.data(), static_cast<int>(size)));
+    auto* bytes = reinterpret_cast<const uint8_t*>(res->data.data());
+    res->bytes = stats::histogram(bytes, size);
+    res->digrams.resize(256 * 256);
+    std::vector<uint64_t> sums(256 * 256);
+    stats::digramHistogram(bytes, size, res->digrams.data(), sums.data());
+  }
+  return *res;
+}
+
+/*****************************************************************************/
+/* Quality */
+/*****************************************************************************/
+
+/** Kullback-Leibler divergence (in bits) of sample histogram q from data
+    histogram p, of n buckets. q is smoothed by adding half an occurrence
+    to every bucket, so that buckets missing from the sample don't make it
+    infinite.  */
+double klDivergence(const uint64_t* p, const uint64_t* q, size_t n) {
+  double p_total = 0, q_total = 0;
+  for (size_t i = 0; i < n; ++i) {
+    p_total += static_cast<double>(p[i]);
+    q_total += static_cast<double>(q[i]) + 0.5;
+  }
+  double res = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (p[i] == 0) {
+      continue;
+    }
+    double pi = static_cast<double>(p[i]) / p_total;
+    double qi = (static_cast<double>(q[i]) + 0.5) / q_total;
+    res += pi * std::log2(pi / qi);
+  }
+  return res;
+}
+
+void reportQuality(benchmark::State& state, const Blob& blob,
+                   ISampler* sampler) {
+  size_t size = sampler->getSampleSize();
+  auto* sample = reinterpret_cast<const uint8_t*>(sampler->data());
+  auto bytes = stats::histogram(sample, size);
+  std::vector<uint64_t> digrams(256 * 256), sums(256 * 256);
+  stats::digramHistogram(sample, size, digrams.data(), sums.data());
+  state.counters["kl_bytes"] =
+      klDivergence(blob.bytes.data(), bytes.data(), bytes.size());
+  state.counters["kl_digrams"] =
+      klDivergence(blob.digrams.data(), digrams.data(), digrams.size());
+  state.counters["sample_size"] = static_cast<double>(size);
+}
+
+/*****************************************************************************/
+/* Samplers */
+/*****************************************************************************/
+
+enum class Sampler { UNIFORM, ENTROPY, PYRAMID, PROGRESSIVE };
+
+std::unique_ptr<ISampler> makeSampler(Sampler type, const Blob& blob,
+                                      size_t sample_size, size_t window_size) {
+  switch (type) {
+    case Sampler::UNIFORM: {
+      auto* sampler = new UniformSampler(blob.source);
+      sampler->setWindowSize(window_size);
+      return std::unique_ptr<ISampler>(sampler);
+    }
+    case Sampler::ENTROPY: {
+      auto* sampler = new EntropySampler(blob.source);
+      sampler->setWindowSize(window_size);
+      return std::unique_ptr<ISampler>(sampler);
+    }
+    case Sampler::PYRAMID: {
+      // Like the minimaps: level 0 is 8 times the sample. The window size
+      // is the pyramid's own.
+      auto pyramid = std::make_shared<SamplePyramid>(
+          blob.source, std::min(8 * sample_size, blob.data.size() / 2));
+      return std::unique_ptr<ISampler>(new PyramidSampler(pyramid));
+    }
+    case Sampler::PROGRESSIVE: {
+      // All data arrived.
+      auto source = std::make_shared<ProgressiveDataSource>(blob.data.size());
+      source->write(0, blob.data.data(), blob.data.size());
+      auto* sampler = new ProgressiveSampler(source);
+      sampler->setWindowSize(window_size);
+      return std::unique_ptr<ISampler>(sampler);
+    }
+  }
+  return nullptr;
+}
+
+// BM_ResampleRange samples this fraction of the data at a time.
+const int64_t k_range_fraction = 4;
+
+/** Data sizes x sample sizes x window sizes (0 is the default window,
+    square root of sample size). Samples as big as the sampled range
+    (data / range_fraction) are skipped, as no sampling happens then.  */
+void samplerArgs(benchmark::internal::Benchmark* b, bool window_sizes,
+                 int64_t range_fraction = 1) {
+  b->ArgNames({"data", "sample", "window"});
+  for (int64_t data : {1 << 20, 1 << 24, 1 << 27}) {
+    for (int64_t sample : {1 << 14, 1 << 18, 1 << 22}) {
+      if (sample >= data / range_fraction) {
+        continue;
+      }
+      if (!window_sizes) {
+        b->Args({data, sample, 0});
+        continue;
+      }
+      for (int64_t window : {0, 16, 4096}) {
+        b->Args({data, sample, window});
+      }
+    }
+  }
+}
+
+void samplerArgsWithWindows(benchmark::internal::Benchmark* b) {
+  samplerArgs(b, true);
+}
+
+void samplerArgsDefaultWindow(benchmark::internal::Benchmark* b) {
+  samplerArgs(b, false);
+}
+
+void samplerArgsRange(benchmark::internal::Benchmark* b) {
+  samplerArgs(b, false, k_range_fraction);
+}
+
+}  // namespace
+
+/** Time of a full resample, with quality of the resulting sample.  */
+void BM_Resample(benchmark::State& state, Sampler type) {
+  const auto& data = blob(static_cast<size_t>(state.range(0)));
+  auto sample_size = static_cast<size_t>(state.range(1));
+  auto sampler = makeSampler(type, data, sample_size,
+                             static_cast<size_t>(state.range(2)));
+  sampler->setSampleSize(sample_size);
+  for (auto _ : state) {
+    sampler->resample();
+    benchmark::DoNotOptimize(sampler->data());
+  }
+  state.SetBytesProcessed(state.iterations() * sampler->getSampleSize());
+  reportQuality(state, data, sampler.get());
+}
+
+/** Time of following a selection moving over the data, as minimaps do.  */
+void BM_ResampleRange(benchmark::State& state, Sampler type) {
+  const auto& data = blob(static_cast<size_t>(state.range(0)));
+  auto sample_size = static_cast<size_t>(state.range(1));
+  auto sampler = makeSampler(type, data, sample_size,
+                             static_cast<size_t>(state.range(2)));
+  sampler->setSampleSize(sample_size);
+  size_t size = data.data.size();
+  size_t step = 0;
+  for (auto _ : state) {
+    // A quarter of the data, moving by 1/64 of it.
+    size_t start = (step++ % 48) * (size / 64);
+    sampler->setRange(start, start + size / k_range_fraction);
+    benchmark::DoNotOptimize(sampler->data());
+  }
+}
+
+BENCHMARK_CAPTURE(BM_Resample, uniform, Sampler::UNIFORM)
+    ->Apply(samplerArgsWithWindows)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_Resample, entropy, Sampler::ENTROPY)
+    ->Apply(samplerArgsWithWindows)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_Resample, pyramid, Sampler::PYRAMID)
+    ->Apply(samplerArgsDefaultWindow)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_Resample, progressive, Sampler::PROGRESSIVE)
+    ->Apply(samplerArgsWithWindows)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(BM_ResampleRange, uniform, Sampler::UNIFORM)
+    ->Apply(samplerArgsRange)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_ResampleRange, entropy, Sampler::ENTROPY)
+    ->Apply(samplerArgsRange)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_ResampleRange, pyramid, Sampler::PYRAMID)
+    ->Apply(samplerArgsRange)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace util
+}  // namespace veles
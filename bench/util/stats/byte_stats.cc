@@ -0,0 +1,187 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "util/stats/byte_stats.h"
+
+namespace veles {
+namespace util {
+namespace stats {
+
+namespace {
+
+std::vector<uint8_t> benchData(size_t size) {
+  std::mt19937 gen(1);
+  std::vector<uint8_t> res(size);
+  for (auto& byte : res) {
+    // Text-like data: few distinct values with long runs make the naive
+    // histogram loop stall on repeated increments of the same counter.
+    byte = static_cast<uint8_t>(gen() % 8 == 0 ? gen() : 'a');
+  }
+  return res;
+}
+
+/*****************************************************************************/
+/* The loops the visualizations used before switching to util::stats */
+/*****************************************************************************/
+
+void oldHistogram(const uint8_t* data, size_t size, uint64_t* counts) {
+  memset(counts, 0, 256 * sizeof(*counts));
+  for (size_t i = 0; i < size; ++i) {
+    counts[data[i]] += 1;
+  }
+}
+
+void oldDigram(const uint8_t* data, size_t size, uint64_t* bigtab) {
+  memset(bigtab, 0, 256 * 256 * 2 * sizeof(*bigtab));
+  for (size_t i = 0; i < size - 1; i++) {
+    size_t index = data[i] * 512 + data[i + 1] * 2;
+    bigtab[index]++;
+    bigtab[index + 1] += i;
+  }
+}
+
+uint64_t oldSum(const uint8_t* data, size_t size) {
+  uint64_t point_sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    point_sum += data[i];
+  }
+  return point_sum;
+}
+
+}  // namespace
+
+void BM_HistogramOld(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  uint64_t counts[256];
+  for (auto _ : state) {
+    oldHistogram(data.data(), data.size(), counts);
+    benchmark::DoNotOptimize(counts);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HistogramOld)->Range(1 << 12, 1 << 26)->UseRealTime();
+
+void BM_Histogram(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto counts = histogram(data.data(), data.size());
+    benchmark::DoNotOptimize(counts);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Histogram)->Range(1 << 12, 1 << 26)->UseRealTime();
+
+void BM_DigramOld(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  std::vector<uint64_t> bigtab(256 * 256 * 2);
+  for (auto _ : state) {
+    oldDigram(data.data(), data.size(), bigtab.data());
+    benchmark::DoNotOptimize(bigtab.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DigramOld)->Range(1 << 16, 1 << 26)->UseRealTime();
+
+void BM_Digram(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  std::vector<uint64_t> counts(256 * 256);
+  std::vector<uint64_t> sums(256 * 256);
+  for (auto _ : state) {
+    digramHistogram(data.data(), data.size(), counts.data(), sums.data());
+    benchmark::DoNotOptimize(counts.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Digram)->Range(1 << 16, 1 << 26)->UseRealTime();
+
+void BM_SumOld(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(oldSum(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SumOld)->Range(1 << 12, 1 << 26)->UseRealTime();
+
+void BM_Sum(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sum(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sum)->Range(1 << 12, 1 << 26)->UseRealTime();
+
+void BM_MinMax(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(minMax(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MinMax)->Range(1 << 12, 1 << 26)->UseRealTime();
+
+// Entropy of a 257 byte window at every position, as the minimap's
+// sliding window mode evaluates it.
+
+void BM_SlidingEntropyOld(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  const size_t k = 257;
+  for (auto _ : state) {
+    SlidingHistogram window;
+    double res = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (i >= k) {
+        window.remove(data[i - k]);
+      }
+      window.add(data[i]);
+      res += window.entropy();
+    }
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SlidingEntropyOld)->Range(1 << 12, 1 << 20)->UseRealTime();
+
+void BM_SlidingEntropy(benchmark::State& state) {
+  auto data = benchData(static_cast<size_t>(state.range(0)));
+  const size_t k = 257;
+  for (auto _ : state) {
+    EntropyTable table(k);
+    SlidingEntropy window(&table);
+    double res = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (i >= k) {
+        window.remove(data[i - k]);
+      }
+      window.add(data[i]);
+      res += window.entropy();
+    }
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SlidingEntropy)->Range(1 << 12, 1 << 20)->UseRealTime();
+
+}  // namespace stats
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,10 @@
+# Google Benchmark
+
+find_package(benchmark QUIET)
+
+if(benchmark_FOUND)
+  set(BENCHMARK_LIBRARIES benchmark::benchmark)
+  if(NOT MSVC)
+    set(BENCHMARK_LIBRARIES ${BENCHMARK_LIBRARIES} pthread)
+  endif()
+endif()
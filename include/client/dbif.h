@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -45,7 +46,10 @@ class NCObjectHandle : public dbif::ObjectHandleBase {
   explicit NCObjectHandle(NCWrapper* nc = nullptr,
                           const data::NodeID& id = *data::NodeID::getNilId(),
                           dbif::ObjectType type = dbif::ObjectType::CHUNK);
+  NCObjectHandle(NCWrapper* nc, data::NodeHandle handle,
+                 dbif::ObjectType type);
   data::NodeID id();
+  data::NodeHandle handle() const { return handle_; }
 
   dbif::InfoPromise* getInfo(const dbif::PInfoRequest& req) override;
   dbif::InfoPromise* subInfo(const dbif::PInfoRequest& req) override;
@@ -57,6 +61,7 @@ class NCObjectHandle : public dbif::ObjectHandleBase {
  private:
   NCWrapper* nc_;
   data::NodeID id_;
+  data::NodeHandle handle_;
   dbif::ObjectType type_;
 };
 
@@ -68,7 +73,9 @@ struct ChunkDataItemQuery {
   ChunkDataItemQuery(uint64_t children_qid, uint64_t data_items_qid,
                      const QPointer<dbif::InfoPromise>& promise,
                      const data::NodeID& id, bool sub);
-  using ChildrenMap = std::map<data::NodeID, std::shared_ptr<proto::Node>>;
+  /** Ordered on handles, ie. on when each id was first interned, so
+   *  children come out in the same order in every reply. */
+  using ChildrenMap = std::map<data::NodeHandle, std::shared_ptr<proto::Node>>;
 
   bool ready();
 
@@ -92,10 +99,19 @@ class NCWrapper : public QObject {
   Q_OBJECT
 
  public:
-  using ChildrenMap = std::map<data::NodeID, NCObjectHandle>;
+  /** Ordered on handles, ie. on when each id was first interned, so
+   *  children come out in the same order in every reply. */
+  using ChildrenMap = std::map<data::NodeHandle, NCObjectHandle>;
   using MessageHandler = void (NCWrapper::*)(const msg_ptr&);
 
   explicit NCWrapper(NetworkClient* network_client, QObject* parent = nullptr);
+  data::NodeHandle internNodeId(const data::NodeID& id) {
+    return node_ids_.intern(id);
+  }
+  const data::NodeID& nodeId(data::NodeHandle handle) const {
+    return node_ids_.id(handle);
+  }
+
   static dbif::ObjectType typeFromTags(
       const std::shared_ptr<std::unordered_set<std::shared_ptr<std::string>>>&
           tags);
@@ -198,6 +214,7 @@ class NCWrapper : public QObject {
   void wrongMessageType(const QString& name, const QString& expected_type);
 
   NetworkClient* nc_;
+  data::NodeIDTable node_ids_;
 
   std::unordered_map<std::string, MessageHandler> message_handlers_;
   std::unordered_map<uint64_t, QPointer<dbif::InfoPromise>> promises_;
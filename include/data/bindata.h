@@ -16,17 +16,22 @@
  */
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <initializer_list>
+#include <new>
 
 #include <QString>
 
 namespace veles {
 namespace data {
 
+class BinDataBuilder;
+
 /** Represents all kinds of uniform-sized raw binary data.
 
     Conceptually, a BinData instance is an array of <size> <width>-bit sized
@@ -34,9 +39,13 @@ namespace data {
     thousand should be OK).  The data is stored as a big array of octets -
     each element is stored as ceil(width/8) octets in little-endian format.
 
-    This class has value semantics, but copying large instances may be
-    rather expensive - use references in this case, or extract a subrange
-    of in interesting data to pass around.  */
+    This class has value semantics, but the storage is implicitly shared:
+    copies and subranges returned by data() and operator[] refer to the same
+    reference-counted buffer until one of them is modified, at which point
+    the modified instance gets its own copy (copy-on-write).  Just like with
+    QByteArray, a pointer returned by non-const rawData() is only valid until
+    the instance is copied or destroyed - don't hold onto it while making
+    copies.  */
 
 class BinData {
  public:
@@ -47,7 +56,8 @@ class BinData {
       : width_(width), size_(size) {
     assert(width != 0);
     if (!isInline()) {
-      data_ = new uint8_t[octets()];
+      storage_ = Storage::create(octets());
+      data_ = storage_->data();
     }
     if (init_data != nullptr) {
       memcpy(rawData(), init_data, octets());
@@ -67,21 +77,32 @@ class BinData {
     }
   }
 
-  /** Constructs a BinData instance from another one.  */
-  BinData(const BinData& other)
-      : BinData(other.width(), other.size(), other.rawData()) {}
+  /** Constructs a BinData instance from another one.  The storage is shared
+      with the other instance until either of them is modified.  */
+  BinData(const BinData& other) : width_(other.width_), size_(other.size_) {
+    if (isInline()) {
+      memcpy(idata_, other.idata_, sizeof idata_);
+    } else {
+      storage_ = other.storage_->ref();
+      data_ = other.data_;
+    }
+  }
 
-  /** Deletes this instance's data and replaces it with that of another one.  */
+  /** Drops this instance's reference to its data and replaces it with that
+      of another one.  The storage is shared until either is modified.  */
   BinData& operator=(const BinData& other) {
-    if (!isInline()) {
-      delete[] data_;
+    if (this == &other) {
+      return *this;
     }
+    release();
     width_ = other.width_;
     size_ = other.size_;
-    if (!isInline()) {
-      data_ = new uint8_t[octets()];
+    if (isInline()) {
+      memcpy(idata_, other.idata_, sizeof idata_);
+    } else {
+      storage_ = other.storage_->ref();
+      data_ = other.data_;
     }
-    memcpy(rawData(), other.rawData(), octets());
     return *this;
   }
 
@@ -92,6 +113,7 @@ class BinData {
     if (isInline()) {
       memcpy(idata_, other.idata_, sizeof idata_);
     } else {
+      storage_ = other.storage_;
       data_ = other.data_;
       other.size_ = 0;
       other.width_ = 0;
@@ -100,16 +122,18 @@ class BinData {
 
   /** Assigns a BinData instance from another one, with move semantics.
       The internal data storage is moved from the other instance if necessary,
-      avoiding a new allocation and a copy.  The old data is destroyed.  */
+      avoiding a new allocation and a copy.  The old data is released.  */
   BinData& operator=(BinData&& other) noexcept {
-    if (!isInline()) {
-      delete[] data_;
+    if (this == &other) {
+      return *this;
     }
+    release();
     width_ = other.width_;
     size_ = other.size_;
     if (isInline()) {
       memcpy(idata_, other.idata_, sizeof idata_);
     } else {
+      storage_ = other.storage_;
       data_ = other.data_;
       other.size_ = 0;
       other.width_ = 0;
@@ -122,10 +146,7 @@ class BinData {
     if (width_ != other.width_ || size_ != other.size_) {
       return false;
     }
-    if (isInline()) {
-      return memcmp(idata_, other.idata_, octets()) == 0;
-    }
-    return memcmp(data_, other.data_, octets()) == 0;
+    return memcmp(rawData(), other.rawData(), octets()) == 0;
   }
 
   /** Creates a dummy BinData instance.  */
@@ -145,13 +166,46 @@ class BinData {
     return res;
   }
 
-  /** Destroys instance's storage, if necessary.  */
-  ~BinData() {
-    if (!isInline()) {
-      delete[] data_;
+  /** Constructs a BinData instance wrapping raw data owned by someone else,
+      without copying it.  The data must stay valid and unchanged until
+      `release` is called, which happens once no instance refers to it
+      anymore.  The data is treated as read-only: modifying the instance
+      makes a private copy first, like with shared storage.  */
+  static BinData fromExternal(uint32_t width, size_t size,
+                              const uint8_t* data,
+                              std::function<void()> release) {
+    BinData res(width, size, SharedView());
+    if (res.isInline()) {
+      memcpy(res.idata_, data, res.octets());
+      if (release) {
+        release();
+      }
+    } else {
+      res.storage_ =
+          Storage::createExternal(res.octets(), data, std::move(release));
+      res.data_ = res.storage_->data();
     }
+    return res;
   }
 
+  /** Files smaller than this are read by mapFile() instead of mapped.  */
+  static constexpr size_t k_map_min_size = 64 * 1024;
+
+  /** Returns the contents of a file as 8-bit data.  Files of at least
+      k_map_min_size bytes are backed by a read-only memory mapping of the
+      file - pages are only read from disk when accessed, and modifying the
+      result makes a private copy.  Smaller files, and files that can't be
+      mapped, are read whole.  Returns false if the file can't be read.
+
+      The mapping is not a snapshot: if another process truncates the file
+      while any instance sharing the mapping is alive, accessing the lost
+      pages raises SIGBUS.  Detach (or copy) the result if it has to
+      outlive changes to the file.  */
+  static bool mapFile(const QString& file_name, BinData* out);
+
+  /** Releases instance's storage, if necessary.  */
+  ~BinData() { release(); }
+
   /** Returns element width, in bits.  */
   uint32_t width() const { return width_; }
 
@@ -167,8 +221,11 @@ class BinData {
 
   /** Returns a pointer to the raw data, starting from a given element
       (or from element 0 if not given).  Elements are contiguous in memory,
-      with each element octetsPerElement() octets after the previous one.  */
+      with each element octetsPerElement() octets after the previous one.
+      If the storage is shared with other instances, it is detached first,
+      so writing through the returned pointer affects only this instance.  */
   uint8_t* rawData(size_t el = 0) {
+    detach();
     uint8_t* d = isInline() ? idata_ : data_;
     return d + el * octetsPerElement();
   }
@@ -183,10 +240,18 @@ class BinData {
 
   /** Returns a subrange of data, starting from `offset`.  `offset` is counted
    * in elements from start of the array.  `size` is counted in elements of the
-   * array.  The result has the same width as this instance.  */
+   * array.  The result has the same width as this instance and shares its
+   * storage (no data is copied unless the result is inline).  */
   BinData data(size_t offset, size_t size) const {
     assert(offset + size <= size_);
-    return BinData(width_, size, rawData(offset));
+    BinData res(width_, size, SharedView());
+    if (res.isInline()) {
+      memcpy(res.idata_, rawData(offset), res.octets());
+    } else {
+      res.storage_ = storage_->ref();
+      res.data_ = data_ + offset * octetsPerElement();
+    }
+    return res;
   }
 
   /** Returns a single element of data, as a single-element BinData
@@ -275,6 +340,26 @@ class BinData {
   /** Sets the 0th element as an uint64_t.  Width must be at most 64.  */
   void setElement64(uint64_t val) { setElement64(0, val); }
 
+  /** Returns true iff this instance doesn't share its storage with any other
+      instance, ie. it can be modified in place.  */
+  bool isDetached() const {
+    return isInline() ||
+           (!storage_->read_only &&
+            storage_->refs.load(std::memory_order_acquire) == 1);
+  }
+
+  /** Ensures this instance has its own, unshared copy of the raw data.  */
+  void detach() {
+    if (isDetached()) {
+      return;
+    }
+    Storage* copy = Storage::create(octets());
+    memcpy(copy->data(), data_, octets());
+    storage_->unref();
+    storage_ = copy;
+    data_ = copy->data();
+  }
+
   /** Create string of coma separated elements represented as hex values */
   QString toString(size_t maxElements = 0);
 
@@ -286,16 +371,101 @@ class BinData {
                        unsigned src_bit, unsigned num_bits);
 
  private:
+  friend class BinDataBuilder;
+
+  /** Reference-counted buffer backing non-inline instances.  Usually the
+      raw octets directly follow the header in the same allocation, but
+      a storage can also wrap external read-only memory (see fromExternal()),
+      in which case `release` is called when the last reference is dropped.
+      `octets` is the size of the buffer, which may be larger than what the
+      instances use.  */
+  struct Storage {
+    std::atomic<size_t> refs;
+    size_t octets;
+    uint8_t* bytes;
+    /** If set, the octets must not be modified even if unshared.  */
+    bool read_only;
+    std::function<void()> release;
+
+    static Storage* create(size_t octets) {
+      void* mem = ::operator new(sizeof(Storage) + octets);
+      auto* res = new (mem) Storage;
+      res->refs.store(1, std::memory_order_relaxed);
+      res->octets = octets;
+      res->bytes = reinterpret_cast<uint8_t*>(res + 1);
+      res->read_only = false;
+      return res;
+    }
+
+    static Storage* createExternal(size_t octets, const uint8_t* bytes,
+                                   std::function<void()> release) {
+      auto* res = create(0);
+      res->octets = octets;
+      res->bytes = const_cast<uint8_t*>(bytes);
+      res->read_only = true;
+      res->release = std::move(release);
+      return res;
+    }
+
+    uint8_t* data() { return bytes; }
+
+    Storage* ref() {
+      refs.fetch_add(1, std::memory_order_relaxed);
+      return this;
+    }
+
+    void unref() {
+      if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (release) {
+          release();
+        }
+        this->~Storage();
+        ::operator delete(this);
+      }
+    }
+  };
+
+  /** Tag for the private constructor that leaves the data uninitialized,
+      used to build views sharing another instance's storage.  */
+  struct SharedView {};
+  BinData(uint32_t width, size_t size, SharedView /*tag*/)
+      : width_(width), size_(size) {}
+
+  /** Constructs an instance taking over the (unshared) storage, which must
+      hold at least the required number of octets.  Used by BinDataBuilder
+      to hand over its buffer without copying.  */
+  BinData(uint32_t width, size_t size, Storage* storage)
+      : width_(width), size_(size) {
+    assert(storage->octets >= octets());
+    if (isInline()) {
+      memcpy(idata_, storage->data(), octets());
+      storage->unref();
+    } else {
+      storage_ = storage;
+      data_ = storage->data();
+    }
+  }
+
+  /** Drops this instance's reference to its storage, if any.  */
+  void release() {
+    if (!isInline()) {
+      storage_->unref();
+    }
+  }
+
   uint32_t width_;
   size_t size_;
+  /** Shared storage iff isInline() is false.  */
+  Storage* storage_;
   union {
-    /** Pointer to raw data iff isInline() is false.  */
+    /** Pointer to the first octet of this view within storage_ iff
+        isInline() is false.  */
     uint8_t* data_;
     /** The array containing raw data iff isInline() is true.  */
     uint8_t idata_[8];
   };
   /** Returns true iff this instance has inline data, ie. stores the raw data
-      directly in the instance (as opposed to new[]-allocated memory).  This
+      directly in the instance (as opposed to shared storage).  This
       is currently done for single-element arrays of up to 64-bit width.  */
   bool isInline() const { return size_ <= 1 && width_ <= (sizeof idata_ * 8); }
 };
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "data/bindata.h"
+
+namespace veles {
+namespace data {
+
+/** Accumulates elements into a growing buffer and turns it into a BinData.
+
+    Appending is amortized O(1) per element: the buffer grows geometrically,
+    like std::vector, and finish() hands the buffer over to the resulting
+    BinData without copying it.  Use this instead of repeatedly
+    concatenating BinData instances with operator+, which copies both
+    sides every time.
+
+    Besides whole elements, individual bits can be appended: they fill the
+    current element starting from its LSB, and once width bits have been
+    appended, the element is complete.  Appending whole elements while an
+    element is incomplete first pads it with zero high bits, so whole
+    elements always start on an element boundary.  */
+class BinDataBuilder {
+ public:
+  explicit BinDataBuilder(uint32_t width, size_t reserve_elements = 0);
+  BinDataBuilder(BinDataBuilder&& other) noexcept;
+  BinDataBuilder& operator=(BinDataBuilder&& other) noexcept;
+  BinDataBuilder(const BinDataBuilder&) = delete;
+  BinDataBuilder& operator=(const BinDataBuilder&) = delete;
+  ~BinDataBuilder();
+
+  uint32_t width() const { return width_; }
+
+  /** Returns the number of complete elements appended so far.  */
+  size_t size() const { return size_; }
+
+  /** Returns the number of elements that fit without reallocating.  */
+  size_t capacity() const { return capacity_; }
+
+  /** Returns true iff some bits of an incomplete element have been
+      appended.  */
+  bool hasPartialElement() const { return bit_pos_ != 0; }
+
+  /** Ensures there is room for at least num_elements elements in total.  */
+  void reserve(size_t num_elements);
+
+  /** Appends all elements of another BinData of the same width.  */
+  void append(const BinData& data);
+
+  /** Appends num_elements elements given as raw octets, in the same format
+      as BinData::rawData().  */
+  void appendRaw(const uint8_t* data, size_t num_elements);
+
+  /** Appends an element given as uint64_t.  Width must be at most 64.  */
+  void appendElement64(uint64_t val);
+
+  /** Appends num_bits bits starting at bit src_bit of src (in the format
+      used by BinData::copyBits()).  The bits may span several elements.  */
+  void appendBits(const uint8_t* src, unsigned src_bit, size_t num_bits);
+
+  /** Appends the num_bits LSBs of bits.  num_bits can be at most 64.  */
+  void appendBits64(uint64_t bits, unsigned num_bits);
+
+  /** Returns the accumulated data and leaves the builder empty.  An
+      incomplete last element is included, with its missing high bits
+      set to zero.  */
+  BinData finish();
+
+ private:
+  /** Makes room for num_elements more elements and returns a pointer to
+      the first of them.  */
+  uint8_t* grow(size_t num_elements);
+
+  uint32_t width_;
+  unsigned octets_per_element_;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  /** Number of bits already appended to element size_.  */
+  unsigned bit_pos_ = 0;
+  BinData::Storage* storage_ = nullptr;
+};
+
+}  // namespace data
+}  // namespace veles
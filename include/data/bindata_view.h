@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include <QtEndian>
+
+#include "data/bindata.h"
+
+namespace veles {
+namespace data {
+
+/** A read-only view of BinData elements as unsigned integers of type T.
+
+    Reading an element through a view is a single (unaligned, little-endian)
+    load, as opposed to BinData::element64() which goes through copyBits()
+    - so loops over views are cheap and can be vectorized.  A view can only
+    be made of data whose elements take exactly sizeof(T) octets, see
+    isCompatible().  Elements narrower than that (eg. 12-bit elements viewed
+    as uint16_t) are fine, since their unused high bits are always zero.
+
+    The view refers to the raw data of the viewed instance and has to be
+    treated like a pointer returned by BinData::rawData() const - it is
+    invalidated when the instance is modified or destroyed.  */
+template <typename T>
+class BinDataView {
+  static_assert(std::is_unsigned<T>::value && sizeof(T) <= 8,
+                "BinDataView element type must be an unsigned integer");
+
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = const T*;
+    using reference = T;
+
+    const_iterator() = default;
+    T operator*() const { return load(ptr_); }
+    T operator[](ptrdiff_t n) const { return load(ptr_ + n * sizeof(T)); }
+    const_iterator& operator++() {
+      ptr_ += sizeof(T);
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator res = *this;
+      ++*this;
+      return res;
+    }
+    const_iterator& operator--() {
+      ptr_ -= sizeof(T);
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator res = *this;
+      --*this;
+      return res;
+    }
+    const_iterator& operator+=(ptrdiff_t n) {
+      ptr_ += n * static_cast<ptrdiff_t>(sizeof(T));
+      return *this;
+    }
+    const_iterator& operator-=(ptrdiff_t n) { return *this += -n; }
+    const_iterator operator+(ptrdiff_t n) const {
+      return const_iterator(*this) += n;
+    }
+    const_iterator operator-(ptrdiff_t n) const {
+      return const_iterator(*this) -= n;
+    }
+    ptrdiff_t operator-(const const_iterator& other) const {
+      return (ptr_ - other.ptr_) / static_cast<ptrdiff_t>(sizeof(T));
+    }
+    bool operator==(const const_iterator& other) const {
+      return ptr_ == other.ptr_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return ptr_ != other.ptr_;
+    }
+    bool operator<(const const_iterator& other) const {
+      return ptr_ < other.ptr_;
+    }
+    bool operator>(const const_iterator& other) const {
+      return ptr_ > other.ptr_;
+    }
+    bool operator<=(const const_iterator& other) const {
+      return ptr_ <= other.ptr_;
+    }
+    bool operator>=(const const_iterator& other) const {
+      return ptr_ >= other.ptr_;
+    }
+
+   private:
+    friend class BinDataView;
+    explicit const_iterator(const uint8_t* ptr) : ptr_(ptr) {}
+    const uint8_t* ptr_ = nullptr;
+  };
+
+  /** Returns true iff a view of type T can be made of the given data.  */
+  static bool isCompatible(const BinData& data) {
+    return data.octetsPerElement() == sizeof(T);
+  }
+
+  explicit BinDataView(const BinData& data)
+      : data_(data.rawData()), size_(data.size()) {
+    assert(isCompatible(data));
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  T operator[](size_t el) const {
+    assert(el < size_);
+    return load(data_ + el * sizeof(T));
+  }
+
+  const_iterator begin() const { return const_iterator(data_); }
+  const_iterator end() const {
+    return const_iterator(data_ + size_ * sizeof(T));
+  }
+
+ private:
+  static T load(const uint8_t* ptr) {
+    return qFromLittleEndian<T>(reinterpret_cast<const uchar*>(ptr));
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+};
+
+}  // namespace data
+}  // namespace veles
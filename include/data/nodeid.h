@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include <msgpack.hpp>
@@ -51,11 +52,60 @@ class NodeID {
   bool operator!=(const NodeID& other) const;
   bool operator<(const NodeID& other) const;
   explicit operator bool() const;
+
+  friend struct NodeIDHash;
 };
 
 struct NodeIDHash {
   std::size_t operator()(const NodeID& id) const;
 };
 
+/** A compact 32-bit reference to a NodeID interned in a NodeIDTable.
+ *  Handles compare and hash as plain integers, so they are much cheaper
+ *  map keys than the 24-byte ids. Handles from different tables must not
+ *  be mixed. */
+class NodeHandle {
+ public:
+  NodeHandle() : index_(INVALID_INDEX) {}
+
+  uint32_t index() const { return index_; }
+  bool isValid() const { return index_ != INVALID_INDEX; }
+
+  bool operator==(NodeHandle other) const { return index_ == other.index_; }
+  bool operator!=(NodeHandle other) const { return index_ != other.index_; }
+  bool operator<(NodeHandle other) const { return index_ < other.index_; }
+
+ private:
+  static const uint32_t INVALID_INDEX = 0xffffffff;
+
+  explicit NodeHandle(uint32_t index) : index_(index) {}
+
+  uint32_t index_;
+
+  friend class NodeIDTable;
+};
+
+struct NodeHandleHash {
+  std::size_t operator()(NodeHandle handle) const { return handle.index(); }
+};
+
+/** Maps NodeIDs to NodeHandles. Each id is hashed once, when it is first
+ *  interned; the handle index then serves as its precomputed hash.
+ *  Interned ids are never removed. Not thread-safe. */
+class NodeIDTable {
+ public:
+  /** Returns the handle of `id`, adding it to the table if needed. */
+  NodeHandle intern(const NodeID& id);
+  /** Returns the handle of `id`, or an invalid handle if it was never
+   *  interned. */
+  NodeHandle find(const NodeID& id) const;
+  const NodeID& id(NodeHandle handle) const;
+  size_t size() const { return ids_.size(); }
+
+ private:
+  std::vector<NodeID> ids_;
+  std::unordered_map<NodeID, uint32_t, NodeIDHash> indices_;
+};
+
 }  // namespace data
 }  // namespace veles
@@ -16,6 +16,8 @@
  */
 #pragma once
 
+#include <functional>
+
 #include "data/bindata.h"
 #include "models.h"
 
@@ -68,6 +70,83 @@ class Repacker : public RepackerModel {
       can be determined by the repackSize() function.  It is an error if fewer
       elements than that are available in the source.  */
   BinData repack(const BinData& src, size_t start, size_t num_elements) const;
+
+  /** Like repack(), but writes the result into an existing BinData of
+      to_width elements, starting at element dst_pos, instead of allocating
+      a new one.  num_elements is clamped the same way as in repack(), and
+      the destination must have room for the clamped count.  Returns the
+      number of elements written.  */
+  size_t repackInto(const BinData& src, size_t start, size_t num_elements,
+                    BinData* dst, size_t dst_pos) const;
+
+ private:
+  /** Handles common unpadded formats (octet-multiple widths, and splitting
+      octets into 1, 2 or 4-bit elements) with specialized kernels.  Returns
+      false if the format needs the generic algorithm.  `num_elements` must
+      already be clamped to what the source can provide.  */
+  bool repackFast(const BinData& src, size_t start, size_t num_elements,
+                  uint8_t* dst) const;
+
+  /** The generic algorithm, going through a repack_unit-wide workspace.  */
+  void repackGeneric(const BinData& src, size_t start, size_t num_elements,
+                     uint8_t* dst) const;
+};
+
+/** Repacks a stream of source elements delivered in chunks, so that
+    arbitrarily large data can be repacked in constant memory.  Feeding
+    chunks with push() and then calling finish() produces the same elements
+    as a single repack() of the concatenated chunks with as many elements
+    as it can provide.
+
+    Source elements that do not form a whole repack unit are carried over
+    to the next push().  */
+class StreamRepacker {
+ public:
+  /** Receives consecutive pieces of the output.  */
+  using Sink = std::function<void(const BinData&)>;
+
+  /** Upper bound on the size of a single piece passed to a Sink.  */
+  static const size_t k_max_batch_elements = 1 << 16;
+
+  explicit StreamRepacker(const Repacker& format);
+
+  const Repacker& format() const { return format_; }
+
+  /** Returns the number of elements the next push() of a chunk with
+      src_size elements will produce.  */
+  size_t outputSize(size_t src_size) const;
+
+  /** Repacks a chunk of source elements into dst, starting at element
+      dst_pos.  dst must have at least outputSize(chunk.size()) elements
+      of room.  Returns the number of elements written.  */
+  size_t push(const BinData& chunk, BinData* dst, size_t dst_pos);
+
+  /** Repacks a chunk of source elements, passing the output to sink
+      in pieces of at most k_max_batch_elements (or one repack unit, if
+      larger) elements.  */
+  void push(const BinData& chunk, const Sink& sink);
+
+  /** Returns the number of elements finish() will produce.  */
+  size_t finishSize() const;
+
+  /** Repacks whatever is left of the incomplete last repack unit into dst
+      and resets the stream.  Returns the number of elements written.  */
+  size_t finish(BinData* dst, size_t dst_pos);
+
+  /** Like above, but passes the output to sink.  */
+  void finish(const Sink& sink);
+
+  /** Discards carried-over source elements.  */
+  void reset();
+
+  /** Number of source elements carried over to the next push().  */
+  size_t pending() const { return carry_.size(); }
+
+ private:
+  Repacker format_;
+  size_t src_per_unit_;
+  size_t dst_per_unit_;
+  BinData carry_;
 };
 
 }  // namespace data
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include <QString>
@@ -122,7 +123,7 @@ struct SetChunkParseRequest : MethodRequest {
   std::vector<data::ChunkDataItem> items;
   SetChunkParseRequest(uint64_t start, uint64_t end,
                        std::vector<data::ChunkDataItem> items)
-      : start(start), end(end), items(items) {}
+      : start(start), end(end), items(std::move(items)) {}
   using ReplyType = NullReply;
 };
 
@@ -16,6 +16,8 @@
  */
 #pragma once
 
+#include <utility>
+
 #include <QCoreApplication>
 #include <QObject>
 #include <QPointer>
@@ -91,21 +93,23 @@ class ObjectHandleBase {
   virtual ObjectType type() const = 0;
 
   template <typename Request, typename... Args>
-  QSharedPointer<typename Request::ReplyType> syncGetInfo(Args... args) {
-    PInfoReply res = baseSyncGetInfo(QSharedPointer<Request>::create(args...));
+  QSharedPointer<typename Request::ReplyType> syncGetInfo(Args&&... args) {
+    PInfoReply res = baseSyncGetInfo(
+        QSharedPointer<Request>::create(std::forward<Args>(args)...));
     return res.dynamicCast<typename Request::ReplyType>();
   }
 
   template <typename Request, typename... Args>
-  QSharedPointer<typename Request::ReplyType> syncRunMethod(Args... args) {
-    PMethodReply res =
-        baseSyncRunMethod(QSharedPointer<Request>::create(args...));
+  QSharedPointer<typename Request::ReplyType> syncRunMethod(Args&&... args) {
+    PMethodReply res = baseSyncRunMethod(
+        QSharedPointer<Request>::create(std::forward<Args>(args)...));
     return res.dynamicCast<typename Request::ReplyType>();
   }
 
   template <typename Request, typename... Args>
-  InfoPromise* asyncGetInfo(QObject* parent, Args... args) {
-    InfoPromise* res = getInfo(QSharedPointer<Request>::create(args...));
+  InfoPromise* asyncGetInfo(QObject* parent, Args&&... args) {
+    InfoPromise* res =
+        getInfo(QSharedPointer<Request>::create(std::forward<Args>(args)...));
     if (parent) {
       res->setParent(parent);
     }
@@ -113,8 +117,9 @@ class ObjectHandleBase {
   }
 
   template <typename Request, typename... Args>
-  InfoPromise* asyncSubInfo(QObject* parent, Args... args) {
-    InfoPromise* res = subInfo(QSharedPointer<Request>::create(args...));
+  InfoPromise* asyncSubInfo(QObject* parent, Args&&... args) {
+    InfoPromise* res =
+        subInfo(QSharedPointer<Request>::create(std::forward<Args>(args)...));
     if (parent) {
       res->setParent(parent);
     }
@@ -122,9 +127,9 @@ class ObjectHandleBase {
   }
 
   template <typename Request, typename... Args>
-  MethodResultPromise* asyncRunMethod(QObject* parent, Args... args) {
-    MethodResultPromise* res =
-        runMethod(QSharedPointer<Request>::create(args...));
+  MethodResultPromise* asyncRunMethod(QObject* parent, Args&&... args) {
+    MethodResultPromise* res = runMethod(
+        QSharedPointer<Request>::create(std::forward<Args>(args)...));
     if (parent) {
       res->setParent(parent);
     }
@@ -17,7 +17,10 @@
 #pragma once
 
 #include <cassert>
+#include <utility>
 
+#include "data/bindata_builder.h"
+#include "data/bindata_view.h"
 #include "data/repack.h"
 #include "dbif/info.h"
 #include "dbif/types.h"
@@ -43,10 +46,44 @@ class StreamParser {
   unsigned width_;
   size_t blob_size_;
 
+  // Blob data is fetched in windows of at least this many elements and
+  // fields are sliced out of the current window.  Slices share the window's
+  // storage, so a whole run of fields costs one blob request and one
+  // allocation, which is released once the last item referencing it is gone.
+  static constexpr uint64_t k_read_ahead_elements = 0x10000;
+  data::BinData window_;
+  uint64_t window_start_;
+
+  /** Returns blob elements in [start, end), clipped to the blob size.  */
+  data::BinData readBlob(uint64_t start, uint64_t end) {
+    if (end > blob_size_) {
+      end = blob_size_;
+    }
+    if (start >= end) {
+      return data::BinData(width_, 0);
+    }
+    if (start < window_start_ || end > window_start_ + window_.size()) {
+      uint64_t window_end = start + k_read_ahead_elements;
+      if (window_end < end) {
+        window_end = end;
+      }
+      if (window_end > blob_size_) {
+        window_end = blob_size_;
+      }
+      window_ = blob_->syncGetInfo<dbif::BlobDataRequest>(start, window_end)
+                    ->data;
+      window_start_ = start;
+    }
+    return window_.data(start - window_start_, end - start);
+  }
+
  public:
   StreamParser(dbif::ObjectHandle blob, uint64_t start,
                dbif::ObjectHandle parent_chunk = dbif::ObjectHandle())
-      : blob_(blob), parent_chunk_(parent_chunk), pos_(start) {
+      : blob_(blob),
+        parent_chunk_(parent_chunk),
+        pos_(start),
+        window_start_(0) {
     auto desc = blob_->syncGetInfo<dbif::DescriptionRequest>();
     width_ = desc.dynamicCast<dbif::BlobDescriptionReply>()->width;
     blob_size_ = desc.dynamicCast<dbif::BlobDescriptionReply>()->size;
@@ -69,7 +106,8 @@ class StreamParser {
   dbif::ObjectHandle endChunk() {
     auto& top = stack_.back();
     auto res = top.chunk;
-    res->syncRunMethod<dbif::SetChunkParseRequest>(top.start, pos_, top.items);
+    res->syncRunMethod<dbif::SetChunkParseRequest>(top.start, pos_,
+                                                   std::move(top.items));
     if (stack_.size() > 1) {
       stack_[stack_.size() - 2].items.push_back(
           data::ChunkDataItem::subchunk(top.start, pos_, top.name, top.chunk));
@@ -85,10 +123,9 @@ class StreamParser {
     if (pos_ >= blob_size_) {
       return data::BinData();
     }
-    auto data =
-        blob_->syncGetInfo<veles::dbif::BlobDataRequest>(pos_, pos_ + src_sz);
+    auto data = readBlob(pos_, pos_ + src_sz);
     pos_ += src_sz;
-    data::BinData res = repack.repack(data->data, 0, num_elements);
+    data::BinData res = repack.repack(data, 0, num_elements);
     stack_.back().items.push_back(data::ChunkDataItem::field(
         pos_ - src_sz, pos_, name, repack, num_elements, high_type, res));
     return res;
@@ -99,7 +136,7 @@ class StreamParser {
                              const data::FieldHighType& high_type,
                              bool include_termination = true) {
     assert(termination.size() == 1);
-    data::BinData res(repack.to_width, 0);
+    data::BinDataBuilder builder(repack.to_width);
     size_t num_elements = 1;
     size_t src_size = repack.repackSize(num_elements);
     size_t bytes_read = 0;
@@ -108,10 +145,7 @@ class StreamParser {
       if (pos_ + src_size > blob_size_) {
         src_size = blob_size_ - pos_;
       }
-      auto data = blob_
-                      ->syncGetInfo<veles::dbif::BlobDataRequest>(
-                          pos_ + bytes_read, pos_ + bytes_read + src_size)
-                      ->data;
+      auto data = readBlob(pos_ + bytes_read, pos_ + bytes_read + src_size);
 
       data = repack.repack(data, 0, num_elements);
 
@@ -126,13 +160,14 @@ class StreamParser {
         }
       }
 
-      res = res + data;
+      builder.append(data);
       num_elements *= 2;
       bytes_read += repack.repackSize(data.size());
       src_size = repack.repackSize(num_elements);
     }
 
     pos_ += bytes_read;
+    data::BinData res = builder.finish();
     stack_.back().items.push_back(data::ChunkDataItem::field(
         pos_ - bytes_read, pos_, name, repack, res.size(), high_type, res));
     return res;
@@ -233,11 +268,8 @@ class StreamParser {
 
   std::vector<uint8_t> getBytes(const QString& name, uint64_t len) {
     auto data = getData(name, data::Repacker(), len, data::FieldHighType());
-    std::vector<uint8_t> res;
-    for (size_t i = 0; i < data.size(); i++) {
-      res.push_back(static_cast<uint8_t>(data.element64(i)));
-    }
-    return res;
+    data::BinDataView<uint8_t> view(data);
+    return std::vector<uint8_t>(view.begin(), view.end());
   }
 
   std::vector<uint8_t> getBytesUntil(const QString& name, uint8_t termination,
@@ -245,11 +277,8 @@ class StreamParser {
     auto data = getDataUntil(name, data::Repacker(),
                              data::BinData::fromRawData(8, {termination}),
                              data::FieldHighType(), include_termination);
-    std::vector<uint8_t> res;
-    for (size_t i = 0; i < data.size(); i++) {
-      res.push_back(static_cast<uint8_t>(data.element64(i)));
-    }
-    return res;
+    data::BinDataView<uint8_t> view(data);
+    return std::vector<uint8_t>(view.begin(), view.end());
   }
 
   uint8_t getByte(const QString& name) {
@@ -262,13 +291,10 @@ class StreamParser {
 
   std::vector<uint16_t> get16(const QString& name, uint64_t num,
                               data::Endian endian) {
-    std::vector<uint16_t> res;
     auto data = getData(name, data::Repacker{endian, 8, 16}, num,
                         data::FieldHighType());
-    for (size_t i = 0; i < data.size(); i++) {
-      res.push_back(static_cast<uint16_t>(data.element64(i)));
-    }
-    return res;
+    data::BinDataView<uint16_t> view(data);
+    return std::vector<uint16_t>(view.begin(), view.end());
   }
 
   std::vector<uint16_t> getLe16(const QString& name, uint64_t num) {
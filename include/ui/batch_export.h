@@ -0,0 +1,41 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+namespace veles {
+namespace ui {
+
+/*
+ * Batch mode, which renders visualizations of files to PNG images without
+ * a GUI or an OpenGL context, eg. to make thumbnails on a headless server:
+ *
+ *   veles --export <directory> [--export-size <pixels>]
+ *         [--sample-size <bytes>] <files...>
+ *
+ * For every file it writes <name>.digram.png, <name>.trigram.png,
+ * <name>.minimap-value.png and <name>.minimap-entropy.png to the
+ * directory. Files are rendered in parallel.
+ */
+
+/** Returns true if the command line asks for batch mode.  */
+bool batchExportRequested(int argc, char* argv[]);
+
+/** Runs batch mode. Returns the exit code for the process.  */
+int runBatchExport(int argc, char* argv[]);
+
+}  // namespace ui
+}  // namespace veles
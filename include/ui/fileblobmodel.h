@@ -16,6 +16,10 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include <QAbstractItemModel>
 #include <QBuffer>
 #include <QByteArray>
@@ -26,6 +30,8 @@
 #include "data/bindata.h"
 #include "dbif/types.h"
 #include "ui/fileblobitem.h"
+#include "util/sampling/data_source.h"
+#include "util/sampling/sample_cache.h"
 
 namespace veles {
 namespace ui {
@@ -58,7 +64,33 @@ class FileBlobModel : public QAbstractItemModel {
   QModelIndex indexFromPos(uint64_t pos,
                            const QModelIndex& parent = QModelIndex());
 
+  /** Returns the blob data.  It's empty (but has the right width) until all
+      parts of it arrived.  */
   const data::BinData& binData() const { return binData_; }
+  /** Returns true once all parts of binData() arrived.  */
+  bool hasAllBinData() const { return bytesMissing_ == 0; }
+  /** Returns true if any of the data arrived, even if binData() is still
+      empty.  */
+  bool hasAnyBinData() const {
+    return binData_.size() > 0 ||
+           (partialBinData_ != nullptr && partialBinData_->availableSize() > 0);
+  }
+  /** Returns raw octets of the parts of the data that arrived so far, shared
+      by all views of this blob, or nullptr if binData() is complete.  Parts
+      are written in place as they arrive, nothing is copied on access.  */
+  std::shared_ptr<const util::ProgressiveDataSource> partialBinData() const {
+    return partialBinData_;
+  }
+  /** Returns binData() as a DataSource shared by all views of this blob, so
+      that they find each other's samples in sampleCache().  */
+  std::shared_ptr<const util::DataSource> binDataSource() const {
+    return binDataSource_;
+  }
+  /** Returns samples of binData() shared by all views of this blob. A new
+      cache is made whenever binData() changes.  */
+  std::shared_ptr<util::SampleCache> sampleCache() const {
+    return sampleCache_;
+  }
   bool isRemovable(const QModelIndex& index = QModelIndex());
   void uploadNewData(const data::BinData& bindata, uint64_t offset = 0);
   void parse(const QString& parser = "", qint64 offset = 0,
@@ -76,17 +108,29 @@ class FileBlobModel : public QAbstractItemModel {
   static const int COLUMN_INDEX_COMMENT = 2;
   static const int COLUMN_INDEX_POS = 3;
 
+  /** Blob data is requested in parts of this many elements, so that views
+      can show something before all of it arrives.  */
+  static const uint64_t BYTES_REQUEST_SIZE = 1024 * 1024;
+
  signals:
   void newBinData();
+  /** Emitted when elements [start, end) of the data arrive or change.
+      newBinData() follows once all of binData() is there.  */
+  void binDataReceived(uint64_t start, uint64_t end);
 
  private:
   FileBlobItem* item_;
   dbif::ObjectHandle fileBlob_;
-  dbif::InfoPromise* bytesPromise_;
+  std::vector<dbif::InfoPromise*> bytesPromises_;
+  std::vector<bool> bytesReceived_;
+  size_t bytesMissing_;
   size_t bytesCount_;
   QStringList path_;
 
   data::BinData binData_;
+  std::shared_ptr<util::ProgressiveDataSource> partialBinData_;
+  std::shared_ptr<const util::DataSource> binDataSource_;
+  std::shared_ptr<util::SampleCache> sampleCache_;
 
   QColor color(int colorIndex) const;
   FileBlobItem* itemFromIndex(const QModelIndex& index) const;
@@ -94,10 +138,12 @@ class FileBlobModel : public QAbstractItemModel {
   void emitDataChanged(FileBlobItem* item);
   QVariant positionColumnData(FileBlobItem* item, int role) const;
   QVariant valueColumnData(FileBlobItem* item, int role) const;
+  /** Makes a new binDataSource() and sampleCache() for binData().  */
+  void resetSamples();
 
  private slots:
   void gotDescriptionResponse(const veles::dbif::PInfoReply& reply);
-  void gotBytesResponse(const veles::dbif::PInfoReply& reply);
+  void gotBytesResponse(uint64_t start, const veles::dbif::PInfoReply& reply);
 };
 
 }  // namespace ui
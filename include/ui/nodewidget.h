@@ -63,7 +63,6 @@ class NodeWidget : public IconAwareView {
   QSharedPointer<QItemSelectionModel> selection_model_;
 
   util::UniformSampler* sampler_;
-  QByteArray sampler_data_;
 };
 
 }  // namespace ui
@@ -16,6 +16,8 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -55,6 +57,36 @@ void mockTopic(const std::string& topic);
  */
 SchedulingResult runTask(const std::string& topic, const Task& t);
 
+/**
+ * Run func(chunk) for every chunk in [0, num_chunks) and return once all of
+ * them are done. The calls are spread over the calling thread and a pool of
+ * helper threads (parallelism() threads in total), started on first use and
+ * kept for the whole process. Topic workers are not used, so this is safe to
+ * call from within a task without risking a deadlock.
+ *
+ * Calls made from within func (eg. a parallel kernel called from a parallel
+ * loop) run all their chunks on the calling thread, so nesting doesn't
+ * multiply the number of threads.
+ *
+ * If func throws, the remaining chunks are skipped and the first exception
+ * is rethrown here once the chunks already running are done.
+ */
+void parallelFor(size_t num_chunks, const std::function<void(size_t)>& func);
+
+/**
+ * Same as parallelFor() above, except that all chunks run on the calling
+ * thread if `work` - the total amount of work, in bytes read or written or a
+ * comparable unit - is too small to pay for handing chunks to helpers.
+ */
+void parallelFor(size_t num_chunks, uint64_t work,
+                 const std::function<void(size_t)>& func);
+
+/**
+ * Return the number of threads parallelFor() spreads chunks over, the
+ * calling one included. Always at least 1.
+ */
+size_t parallelism();
+
 }  // namespace threadpool
 }  // namespace util
 }  // namespace veles
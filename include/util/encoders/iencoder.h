@@ -28,11 +28,8 @@ class IEncoder {
   virtual ~IEncoder() {}
   virtual QString encode(const QByteArray& data) = 0;
   virtual QString encode(const uint8_t* data, size_t size) {
-    QByteArray bytes{};
-    for (size_t i = 0; i < size; i++) {
-      bytes.append(static_cast<char>(data[i]));
-    }
-    return encode(bytes);
+    return encode(QByteArray(reinterpret_cast<const char*>(data),
+                             static_cast<int>(size)));
   }
   virtual QString encodingDisplayName() = 0;
 };
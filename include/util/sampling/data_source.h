@@ -0,0 +1,225 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "data/bindata.h"
+
+namespace veles {
+namespace util {
+
+/**
+ * Read-only, random access source of bytes to be sampled.
+ * Offsets and sizes are 64-bit and the data does not have to be contiguous
+ * in memory, so a source can represent a blob much larger than a single Qt
+ * container.
+ *
+ * Resampling runs on worker threads, so all implementations must allow
+ * concurrent calls to read().
+ */
+class DataSource {
+ public:
+  virtual ~DataSource() {}
+
+  /** Returns the number of bytes in the source.  */
+  virtual uint64_t size() const = 0;
+
+  /**
+   * Copies `size` bytes starting at `offset` to `out`.  The range must be
+   * within the source.
+   */
+  virtual void read(uint64_t offset, uint64_t size, char* out) const = 0;
+
+  /**
+   * Returns a pointer to the whole source if it is contiguous in memory,
+   * or nullptr if it can only be accessed with read().
+   */
+  virtual const char* contiguousData() const { return nullptr; }
+
+  /** Returns a single byte.  Prefer read() for anything bigger.  */
+  char byteAt(uint64_t offset) const;
+};
+
+/** A DataSource over a QByteArray, which is shared rather than copied.  */
+class QByteArrayDataSource : public DataSource {
+ public:
+  explicit QByteArrayDataSource(const QByteArray& data) : data_(data) {}
+
+  uint64_t size() const override;
+  void read(uint64_t offset, uint64_t size, char* out) const override;
+  const char* contiguousData() const override;
+
+ private:
+  QByteArray data_;
+};
+
+/** A DataSource over the raw octets of a BinData, which is shared rather
+ *  than copied.  */
+class BinDataSource : public DataSource {
+ public:
+  explicit BinDataSource(const data::BinData& data);
+
+  uint64_t size() const override;
+  void read(uint64_t offset, uint64_t size, char* out) const override;
+  const char* contiguousData() const override;
+
+ private:
+  data::BinData data_;
+};
+
+/**
+ * A DataSource that fetches fixed-size pages on demand (eg. from a remote
+ * blob, or a file that can't be mapped) and keeps the most recently used
+ * ones in memory.  The fetcher may be called from several threads at once,
+ * for different pages.
+ */
+class PagedDataSource : public DataSource {
+ public:
+  /**
+   * Fills `out` with `size` bytes starting at `offset`.  Called with
+   * page-aligned ranges, which are only shorter than a page at the end of
+   * the source.
+   */
+  using PageFetcher =
+      std::function<void(uint64_t offset, uint64_t size, char* out)>;
+
+  static const uint64_t k_default_page_size = 64 * 1024;
+  static const size_t k_default_max_pages = 256;
+
+  PagedDataSource(uint64_t size, const PageFetcher& fetcher,
+                  uint64_t page_size = k_default_page_size,
+                  size_t max_pages = k_default_max_pages);
+
+  uint64_t size() const override;
+  void read(uint64_t offset, uint64_t size, char* out) const override;
+
+ private:
+  using PageData = std::shared_ptr<const std::vector<char>>;
+
+  struct Page {
+    // nullptr while being fetched.
+    PageData data;
+    std::list<uint64_t>::iterator lru;
+  };
+
+  /**
+   * Returns the page with a given index, fetching it if needed.  The
+   * fetcher is called without holding mutex_, so reads of cached pages
+   * (and fetches of other pages) don't wait for it; threads asking for the
+   * same page wait for the first fetch instead of repeating it.
+   */
+  PageData page(uint64_t index) const;
+
+  uint64_t size_;
+  PageFetcher fetcher_;
+  uint64_t page_size_;
+  size_t max_pages_;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable fetched_;
+  mutable std::unordered_map<uint64_t, Page> pages_;
+  /** Indices of fetched pages, most recently used first.  */
+  mutable std::list<uint64_t> lru_;
+};
+
+/**
+ * A DataSource over a file on disk.  The file is memory-mapped, so only the
+ * pages actually sampled are read.  If the file can't be mapped, it is read
+ * through a PagedDataSource instead.
+ */
+class MappedFileDataSource : public DataSource {
+ public:
+  explicit MappedFileDataSource(const QString& path);
+
+  /** Returns false if the file couldn't be opened.  The source is then
+   *  empty.  */
+  bool isOpen() const { return file_.isOpen(); }
+
+  uint64_t size() const override;
+  void read(uint64_t offset, uint64_t size, char* out) const override;
+  const char* contiguousData() const override;
+
+ private:
+  /** Fetches pages of an unmapped file.  */
+  void readFile(uint64_t offset, uint64_t size, char* out) const;
+
+  mutable QFile file_;
+  /** Guards file_ position when the file is not mapped.  */
+  mutable std::mutex mutex_;
+  uint64_t size_;
+  const char* map_;
+  std::unique_ptr<PagedDataSource> pages_;
+};
+
+/**
+ * A DataSource whose bytes arrive over time (eg. a blob downloaded in
+ * chunks).  The size is known up front; bytes that haven't arrived yet
+ * read as zeros.  Samplers which know about it (see ProgressiveSampler)
+ * only take bytes from the ranges that already arrived.
+ */
+class ProgressiveDataSource : public DataSource {
+ public:
+  explicit ProgressiveDataSource(uint64_t size);
+
+  /** Stores `size` bytes that arrived, starting at `offset`.  May be called
+   *  while other threads read, but not once the source is complete.  */
+  void write(uint64_t offset, const char* data, uint64_t size);
+
+  /** Returns the number of bytes that arrived so far.  */
+  uint64_t availableSize() const;
+
+  /** Returns true if all bytes arrived.  */
+  bool isComplete() const;
+
+  /**
+   * Returns the maximal ranges of bytes that arrived, clipped to
+   * [start, end), as ordered (begin, end) pairs.
+   */
+  std::vector<std::pair<uint64_t, uint64_t>> availableRanges(
+      uint64_t start, uint64_t end) const;
+
+  uint64_t size() const override;
+  void read(uint64_t offset, uint64_t size, char* out) const override;
+  /** Returns all bytes once they arrived, nullptr until then.  */
+  const char* contiguousData() const override;
+
+ private:
+  uint64_t size_;
+  std::unique_ptr<char[]> data_;
+
+  mutable std::mutex mutex_;
+  /** Ranges that arrived, begin -> end.  They never touch or overlap.  */
+  std::map<uint64_t, uint64_t> ranges_;
+  uint64_t available_;
+};
+
+}  // namespace util
+}  // namespace veles
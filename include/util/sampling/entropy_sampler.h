@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "util/sampling/isampler.h"
+
+namespace veles {
+namespace util {
+
+/**
+ * Sampler which spends its budget where the information is.
+ *
+ * The range is split into up to k_max_blocks blocks and the entropy of
+ * each block is estimated from a few short probes. Windows are then
+ * assigned to blocks in proportion to their entropy (plus a small floor,
+ * so that no part of the range disappears from the sample), and placed
+ * uniformly within each block. Long runs of padding get only a few
+ * windows, leaving the rest for code and data.
+ *
+ * Windows never overlap and are ordered by file offset, so
+ * getFileOffset() and getSampleOffset() are exact, like in UniformSampler.
+ */
+class EntropySampler : public ISampler {
+ public:
+  explicit EntropySampler(const QByteArray& data);
+  explicit EntropySampler(std::shared_ptr<const DataSource> source);
+
+  void setWindowSize(size_t size);
+
+  /**
+   * Set the seed used to place windows within blocks. The same seed, data
+   * and config always produce the same sample. Default seed is 0.
+   */
+  void setSeed(uint64_t seed);
+
+  /**
+   * Return the estimated entropy (in bits per byte) of each block of the
+   * current range, in order. Block boundaries are those of the current
+   * sample.
+   */
+  std::vector<double> getBlockEntropy();
+
+  static const size_t k_max_blocks = 1024;
+  static const size_t k_probes_per_block = 4;
+  static const size_t k_probe_size = 1024;
+  // Weight of a block is its entropy plus this, so that blocks with no
+  // information at all (eg. zero padding) still get a few windows.
+  static constexpr double k_entropy_floor = 0.25;
+
+ private:
+  /** A complete sample, never modified once published.  */
+  struct Sample : public WindowSample {
+    size_t memorySize() const override;
+
+    std::vector<double> block_entropy;
+  };
+
+  struct EntropySamplerResampleData : public ResampleData {
+    std::shared_ptr<const Sample> sample;
+  };
+
+  EntropySampler(const EntropySampler& other);
+  char getSampleByte(size_t index) const override;
+  const char* getData() const override;
+  size_t getRealSampleSize() const override;
+  size_t getFileOffsetImpl(size_t index) const override;
+  size_t getSampleOffsetImpl(size_t address) const override;
+  ResampleData* prepareResample(SamplerConfig* sc) override;
+  void applyResample(ResampleData* rd) override;
+  void cleanupResample(ResampleData* rd) override;
+  EntropySampler* cloneImpl() const override;
+
+  /** Compute the sample for sc, or return nullptr if cancelled.  */
+  std::shared_ptr<const Sample> computeSample(SamplerConfig* sc,
+                                              size_t window_size) const;
+  /** Estimate entropy of each block of size block_size.  */
+  std::vector<double> blockEntropy(size_t block_size, size_t blocks,
+                                   SamplerConfig* sc) const;
+
+  uint64_t seed_;
+  size_t window_size_;
+  bool use_default_window_size_;
+  std::shared_ptr<const Sample> sample_;
+};
+
+}  // namespace util
+}  // namespace veles
@@ -16,6 +16,9 @@
  */
 #pragma once
 
+#include <memory>
+#include <utility>
+
 #include "util/sampling/isampler.h"
 
 namespace veles {
@@ -23,7 +26,8 @@ namespace util {
 
 class FakeSampler : public ISampler {
  public:
-  explicit FakeSampler(const QByteArray& data) : ISampler(data) {}
+  explicit FakeSampler(const QByteArray& data);
+  explicit FakeSampler(std::shared_ptr<const DataSource> source);
 
  protected:
   size_t getRealSampleSize() const override;
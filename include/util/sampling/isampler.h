@@ -21,14 +21,97 @@
 #include <functional>
 #include <future>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 #include <QByteArray>
 
+#include "util/sampling/data_source.h"
+#include "util/sampling/sample_cache.h"
+
 namespace veles {
 namespace util {
 
+/**
+ * Sample made of windows of input data, the form all samplers here
+ * produce. Like other cached samples it's never modified once published,
+ * so it can be shared by samplers, their snapshots and the sample cache.
+ */
+struct WindowSample : public CachedSample {
+  size_t memorySize() const override;
+
+  /** Return the size of the sample, in bytes.  */
+  size_t size() const { return window_size * windows.size(); }
+
+  /** Return the offset (relative to the range) of index-th byte.  */
+  size_t fileOffset(size_t index) const;
+
+  /**
+   * Return the index of the byte at (range relative) address, or of the
+   * last byte of the closest window before it.
+   */
+  size_t sampleOffset(size_t address) const;
+
+  size_t window_size = 0;
+  // Window offsets, relative to the start of the range, sorted and not
+  // overlapping.
+  std::vector<size_t> windows;
+  std::unique_ptr<char[]> data;
+};
+
+/**
+ * Immutable view of a sample and the config it was taken with, as of one
+ * finished resample. Methods mean the same as their ISampler counterparts.
+ *
+ * A snapshot is obtained with ISampler::snapshot() without taking the
+ * sampler lock, and can then be read from any thread without any locking.
+ * It keeps the sample alive (and unchanged) however the sampler is
+ * resampled or deleted later.
+ */
+class SampleSnapshot {
+ public:
+  std::pair<size_t, size_t> getRange() const {
+    return std::make_pair(start_, end_);
+  }
+  size_t getSampleSize() const { return size_; }
+  size_t getFileOffset(size_t index) const;
+  size_t getSampleOffset(size_t address) const;
+  char operator[](size_t index) const { return data_[index]; }
+  const char* data() const { return data_; }
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * The sample is made of getWindowCount() windows of input data, all of
+   * getWindowSize() bytes. Bytes of index-th window start at
+   * data() + index * getWindowSize() in the sample and at (absolute)
+   * getWindowOffset(index) in the input. Windows are sorted and don't
+   * overlap. A sample which is the input range itself is a single window.
+   */
+  size_t getWindowCount() const;
+  size_t getWindowSize() const;
+  size_t getWindowOffset(size_t index) const;
+
+  /** Return the data the sample was taken from.  */
+  const std::shared_ptr<const DataSource>& getSource() const {
+    return source_;
+  }
+
+ private:
+  friend class ISampler;
+  SampleSnapshot(std::shared_ptr<const DataSource> source, size_t start,
+                 size_t end, size_t requested_size);
+
+  std::shared_ptr<const DataSource> source_;
+  size_t start_, end_, requested_size_, size_;
+  const char* data_;
+  // nullptr if the sample is the input data itself.
+  std::shared_ptr<const WindowSample> sample_;
+  // Keeps data_ alive when it doesn't belong to sample_.
+  std::shared_ptr<const void> data_owner_;
+};
+
 using SamplerMutex = std::recursive_mutex;
 using SamplerConditionVariable = std::condition_variable_any;
 using ResampleCallback = std::function<void()>;
@@ -37,7 +120,8 @@ using ResampleCallbackId = int;
 /**
  * Abstract interface for Sampler classes.
  * The idea is that any Sampler wraps a byte stream and performs sampling
- * to return a small, representative sample.
+ * to return a small, representative sample. The bytes are read through
+ * a DataSource, so they don't need to fit in a single QByteArray.
  * Specific sample size can be requested by user, but this is only treated
  * as a suggestion and the implementation may return a sample of different
  * size.
@@ -49,10 +133,11 @@ using ResampleCallbackId = int;
  * is performed in a separate thread and a set of registered callbacks is
  * called once it's done.
  *
- * When working in asynchronous mode it is recommended to perform any
- * operations on the data while keeping the mutex returned by sampler.lock().
- * Otherwise the sample we're looking at can suddenly change leading to
- * inconsistencies.
+ * When working in asynchronous mode it is recommended to read the data
+ * through snapshot(), which never blocks and can't change under the
+ * reader. The other way is to perform any operations on the data while
+ * keeping the mutex returned by sampler.lock(). Otherwise the sample we're
+ * looking at can suddenly change leading to inconsistencies.
  *
  * Example usage:
  * MySampler sampler(some_data);
@@ -64,6 +149,7 @@ using ResampleCallbackId = int;
 class ISampler {
  public:
   explicit ISampler(const QByteArray& data);
+  explicit ISampler(std::shared_ptr<const DataSource> source);
   virtual ~ISampler() {}
 
   /**
@@ -155,6 +241,15 @@ class ISampler {
    */
   bool empty() const;
 
+  /**
+   * Return the latest finished sample. This never waits for the sampler
+   * lock (and so for resampling in progress), which makes it the preferred
+   * way to read the sample from the GUI thread. Samplers which don't
+   * publish windows (see setWindowSample()) are treated as FakeSampler -
+   * their snapshot is the whole range of input data.
+   */
+  std::shared_ptr<const SampleSnapshot> snapshot() const;
+
   /**
    * Get lock protecting sampler data.
    * As long as the lock is held no resampling will happen, meaning all methods
@@ -167,7 +262,9 @@ class ISampler {
   /**
    * Wait until sampler has finished resampling.
    * This waits until all resample operations are done, including those
-   * scheduled after the wait has started!
+   * scheduled after the wait has started! Outdated ones are waited for
+   * too, so once it returns no task uses the sampler anymore and it can be
+   * deleted.
    */
   void wait();
 
@@ -187,11 +284,12 @@ class ISampler {
   /**
    * Register a callback that will be called when resampling is finished.
    * There is no guarantee in which thread the callback will be called.
-   * Thread calling callbacks will keep sampler lock() while doing so,
-   * so it's prefered if they're reasonably cheap.
+   * Callbacks are called after the new snapshot() is published and without
+   * holding sampler lock, so they don't block readers or configuration
+   * changes. They do block adding and removing callbacks.
    * If multiple callbacks are registered they will be called in reverse
    * registration order (stack).
-   * This method needs to acquire sampler lock, so it may block.
+   * This method needs to wait for callbacks being called, so it may block.
    * Returned value is callback id, that can be later used to remove this
    * callback.
    */
@@ -204,7 +302,7 @@ class ISampler {
 
   /**
    * Remove all registered resample callbacks.
-   * This method needs to acquire sampler lock, so it may block.
+   * This method needs to wait for callbacks being called, so it may block.
    */
   void clearResampleCallbacks();
 
@@ -227,6 +325,15 @@ class ISampler {
    */
   void allowAsynchronousResampling(bool allow);
 
+  /**
+   * Share samples with other samplers of the same data through `cache`.
+   * Samplers which support it then compute a sample only if no sampler
+   * using the cache has done so for an equal config. Clones use the same
+   * cache. Set it before the first resample, nullptr (default) disables
+   * sharing.
+   */
+  void setSampleCache(std::shared_ptr<SampleCache> cache);
+
  protected:
   /**
    * Derive this struct if you want to pass any data between resample and
@@ -241,6 +348,8 @@ class ISampler {
    */
   struct SamplerConfig {
     size_t start, end, sample_size;
+    // Version of the resample this config is used for (asynchronous mode).
+    int version;
   };
 
   /**
@@ -262,6 +371,40 @@ class ISampler {
    */
   char getDataByte(size_t index, SamplerConfig* sc = nullptr) const;
 
+  /**
+   * Copy `size` bytes of input data, starting from `index`, to `out`.
+   * Indexing is the same as in getDataByte(). This is the preferred way
+   * of reading input data, as it works for any DataSource.
+   */
+  void readData(size_t index, size_t size, char* out,
+                SamplerConfig* sc = nullptr) const;
+
+  /**
+   * Return true if the resample using sc has been superseded by a newer
+   * one, so its result would be thrown away anyway. prepareResample()
+   * should poll this in its long loops and return nullptr once it's true.
+   * Always false in synchronous mode.
+   */
+  bool isCancelled(const SamplerConfig* sc) const;
+
+  /**
+   * Return the sample for `key` from the sample cache, calling `compute`
+   * only if it's not there. Without a cache this just calls `compute`.
+   * Like `compute`, may return nullptr if the resample was cancelled.
+   */
+  std::shared_ptr<const CachedSample> cachedSample(
+      const SampleKey& key, const SampleCache::Compute& compute) const;
+
+  /** Return the sample for `key` if it's in the sample cache, or nullptr.  */
+  std::shared_ptr<const CachedSample> findCachedSample(
+      const SampleKey& key) const;
+
+  /**
+   * Publish `sample` as the current sample for snapshots. Window based
+   * samplers should call this in applyResample().
+   */
+  void setWindowSample(std::shared_ptr<const WindowSample> sample);
+
   /**
    * Return the size of sample requested by user (with setSampleSize).
    */
@@ -278,6 +421,10 @@ class ISampler {
    * Return the input data as simple array. Size of array is getDataSize().
    * If sc is provided it uses the range represented by sc instead of this
    * stored by sampler.
+   * If the DataSource is not contiguous in memory, the range is copied to
+   * a buffer owned by the sampler, which is only valid until the next call.
+   * Such calls must not be made concurrently, so use readData() in
+   * prepareResample().
    */
   const char* getRawData(SamplerConfig* sc = nullptr) const;
 
@@ -315,6 +462,9 @@ class ISampler {
    * later be passed to applyResample method.
    * Any call to method accepting SamplerConfig (getDataSize(),
    * getRawData(), etc) should pass the provided SamplerConfig.
+   * If isCancelled(sc) becomes true, the implementation may stop early and
+   * return nullptr. Neither applyResample nor cleanupResample is called
+   * then.
    */
   virtual ResampleData* prepareResample(SamplerConfig* sc) = 0;
 
@@ -345,9 +495,17 @@ class ISampler {
   bool samplingRequired(SamplerConfig* sc = nullptr);
   void applySamplerConfig(SamplerConfig* sc);
   void runResample(SamplerConfig* sc);
+  /** Runs on the thread pool: runResampleTask(), then marks the task as
+      done for wait().  */
   void resampleAsync(int target_version, SamplerConfig* sc);
-
-  const QByteArray& data_;
+  void runResampleTask(int target_version, SamplerConfig* sc);
+  /** Make a snapshot of the current state. Requires sampler lock.  */
+  void publishSnapshot();
+  void runCallbacks();
+
+  std::shared_ptr<const DataSource> source_;
+  std::shared_ptr<SampleCache> cache_;
+  mutable std::vector<char> raw_copy_;
   size_t start_, end_, sample_size_;
   bool allow_async_;
 
@@ -355,6 +513,15 @@ class ISampler {
   SamplerConditionVariable sampler_condition_;
   SamplerConfig last_config_;
   std::atomic<int> current_version_, requested_version_;
+  // Resample tasks scheduled on the thread pool and not done yet, even if
+  // they're outdated. Requires sampler lock.
+  int queued_resamples_;
+  std::shared_ptr<const WindowSample> window_sample_;
+  // Only accessed with std::atomic_load and std::atomic_store.
+  std::shared_ptr<const SampleSnapshot> snapshot_;
+
+  // Held while calling callbacks, so they can't be removed meanwhile.
+  SamplerMutex callbacks_mutex_;
   ResampleCallbackId next_cb_id_;
   std::map<ResampleCallbackId, ResampleCallback> callbacks_;
 };
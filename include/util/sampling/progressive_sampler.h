@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "util/sampling/data_source.h"
+#include "util/sampling/isampler.h"
+
+namespace veles {
+namespace util {
+
+/**
+ * Sampler for data that is still arriving.
+ *
+ * Windows are only taken from the ranges of the ProgressiveDataSource that
+ * already arrived, spread over them uniformly, so the sample is usable
+ * (if coarse) long before all data is there. Call refine() when new data
+ * arrives - it resamples once enough of it accumulated, and the new sample
+ * is announced through the usual resample callbacks.
+ *
+ * Until enough data arrives the sample can be smaller than requested, or
+ * even empty. Offsets are exact, like in UniformSampler.
+ */
+class ProgressiveSampler : public ISampler {
+ public:
+  explicit ProgressiveSampler(
+      std::shared_ptr<const ProgressiveDataSource> source);
+
+  void setWindowSize(size_t size);
+
+  /**
+   * Resample if enough data arrived since the last resample: the available
+   * data doubled, grew by 1/k_refine_steps of the whole, or is complete.
+   * Returns true if resampling was started.
+   */
+  bool refine();
+
+  static const uint64_t k_refine_steps = 16;
+
+ private:
+  struct ProgressiveSamplerResampleData : public ResampleData {
+    std::shared_ptr<const WindowSample> sample;
+  };
+
+  ProgressiveSampler(const ProgressiveSampler& other);
+  char getSampleByte(size_t index) const override;
+  const char* getData() const override;
+  size_t getRealSampleSize() const override;
+  size_t getFileOffsetImpl(size_t index) const override;
+  size_t getSampleOffsetImpl(size_t address) const override;
+  ResampleData* prepareResample(SamplerConfig* sc) override;
+  void applyResample(ResampleData* rd) override;
+  void cleanupResample(ResampleData* rd) override;
+  ProgressiveSampler* cloneImpl() const override;
+
+  std::shared_ptr<const ProgressiveDataSource> progressive_source_;
+  // Available data size when resampling was last requested.
+  uint64_t refined_size_;
+  size_t window_size_;
+  bool use_default_window_size_;
+  std::shared_ptr<const WindowSample> sample_;
+};
+
+}  // namespace util
+}  // namespace veles
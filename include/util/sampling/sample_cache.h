@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "util/sampling/data_source.h"
+
+namespace veles {
+namespace util {
+
+class SamplePyramid;
+
+/**
+ * Base of samples kept in a SampleCache. A sample is never modified once
+ * it's in the cache, so it can be shared by any number of samplers.
+ */
+struct CachedSample {
+  virtual ~CachedSample() {}
+  /** Return the number of bytes the sample takes.  */
+  virtual size_t memorySize() const = 0;
+};
+
+/**
+ * Everything that determines a sample. Samplers of different kinds use
+ * different method names, so they never get each other's samples.
+ */
+struct SampleKey {
+  std::string method;
+  // Absolute range of input data.
+  size_t start, end;
+  size_t sample_size, window_size;
+  uint64_t seed;
+};
+
+bool operator<(const SampleKey& a, const SampleKey& b);
+
+/**
+ * Samples shared between all samplers of one blob.
+ *
+ * A sample is computed by the first sampler asking for it and returned to
+ * everyone else asking with an equal key, also while it's still being
+ * computed - they wait for it instead of doing the same work again. The
+ * least recently used samples are dropped once they take more than the
+ * capacity, samplers holding them keep them alive.
+ *
+ * The cache doesn't know the data, so it must only be used by samplers of
+ * one blob, and replaced with a new one when the blob changes.
+ */
+class SampleCache {
+ public:
+  using Compute = std::function<std::shared_ptr<const CachedSample>()>;
+
+  explicit SampleCache(size_t capacity = k_default_capacity);
+
+  /**
+   * Return the sample for `key`, calling `compute` to get it if it's not in
+   * the cache. If `compute` returns nullptr (eg. because the resample was
+   * cancelled) nothing is cached and nullptr is returned; samplers waiting
+   * for the same key then compute it themselves. The same happens if
+   * `compute` throws, and the exception is passed on to the caller.
+   */
+  std::shared_ptr<const CachedSample> get(const SampleKey& key,
+                                          const Compute& compute);
+
+  /**
+   * Return the sample for `key` like get() if it's already computed, or
+   * nullptr without waiting or computing it. Doesn't count as a miss.
+   */
+  std::shared_ptr<const CachedSample> find(const SampleKey& key);
+
+  /**
+   * Return the pyramid of `source` with given finest level size and seed,
+   * building it on first use. Like get(), callers asking for a pyramid
+   * which is being built wait for it, and the cache isn't locked meanwhile.
+   */
+  std::shared_ptr<const SamplePyramid> pyramid(
+      const std::shared_ptr<const DataSource>& source, size_t finest_size,
+      uint64_t seed = 0);
+
+  /**
+   * Return the pyramid like pyramid() if it's already built, or nullptr
+   * without waiting or building it.
+   */
+  std::shared_ptr<const SamplePyramid> findPyramid(
+      const std::shared_ptr<const DataSource>& source, size_t finest_size,
+      uint64_t seed = 0);
+
+  /** Drop all samples and pyramids.  */
+  void clear();
+
+  /** Total size of cached samples, in bytes.  */
+  size_t memorySize();
+
+  /** Number of get() calls which had to compute the sample.  */
+  size_t misses();
+
+  static const size_t k_default_capacity = 256 * 1024 * 1024;
+
+ private:
+  struct Entry {
+    // nullptr while being computed.
+    std::shared_ptr<const CachedSample> sample;
+    std::list<SampleKey>::iterator lru;
+  };
+
+  // The source of a pyramid lives as long as the pyramid, so its address
+  // can't be reused by another source while it's a key.
+  using PyramidKey = std::tuple<const DataSource*, size_t, uint64_t>;
+
+  void evict();
+
+  size_t capacity_;
+  size_t memory_size_;
+  size_t misses_;
+  std::map<SampleKey, Entry> entries_;
+  // Keys of computed samples, most recently used first.
+  std::list<SampleKey> lru_;
+  // nullptr while being built.
+  std::map<PyramidKey, std::shared_ptr<const SamplePyramid>> pyramids_;
+  std::mutex mutex_;
+  std::condition_variable computed_;
+};
+
+}  // namespace util
+}  // namespace veles
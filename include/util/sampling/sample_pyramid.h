@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "util/sampling/data_source.h"
+#include "util/sampling/isampler.h"
+
+namespace veles {
+namespace util {
+
+/**
+ * Precomputed samples of a whole blob at several resolutions, like texture
+ * mipmaps.
+ *
+ * Level 0 is a uniform sample of finest_size bytes, made of windows of
+ * sqrt(finest_size) bytes. Each next level keeps every other window of the
+ * previous one, so it has half the size, and all levels together take less
+ * than twice as much memory as level 0. Every level stores its windows
+ * contiguously.
+ *
+ * The pyramid is immutable once built and can be shared between samplers
+ * (and threads).
+ */
+class SamplePyramid {
+ public:
+  SamplePyramid(std::shared_ptr<const DataSource> source, size_t finest_size,
+                uint64_t seed = 0);
+
+  const std::shared_ptr<const DataSource>& source() const { return source_; }
+  size_t windowSize() const { return window_size_; }
+  size_t levels() const { return levels_.size(); }
+
+  /** Absolute offsets of windows of a given level, sorted.  */
+  const std::vector<size_t>& windows(size_t level) const;
+
+  /** Bytes of windows of a given level, one after another.  */
+  const char* data(size_t level) const;
+
+  /** Total size of all levels, in bytes.  */
+  size_t memorySize() const;
+
+  /**
+   * Find the coarsest level with at least min_windows windows lying
+   * entirely within [start, end). Returns false if even level 0 doesn't
+   * have that many. Otherwise sets *level and the range of its windows
+   * [*first, *last) within [start, end).
+   */
+  bool findLevel(size_t start, size_t end, size_t min_windows, size_t* level,
+                 size_t* first, size_t* last) const;
+
+  // Levels with fewer windows than this are not kept.
+  static const size_t k_min_level_windows = 64;
+
+ private:
+  struct Level {
+    std::vector<size_t> windows;
+    std::unique_ptr<char[]> data;
+  };
+
+  std::shared_ptr<const DataSource> source_;
+  size_t window_size_;
+  std::vector<Level> levels_;
+};
+
+/**
+ * Sampler serving samples from a SamplePyramid.
+ *
+ * For a given range it uses the coarsest level that has at least as many
+ * windows in the range as the requested sample size needs, and takes
+ * windows evenly from the part of that level within the range - no input
+ * data is read. Only when zoomed in deeper than level 0 allows, windows
+ * are drawn from input data like in UniformSampler.
+ */
+class PyramidSampler : public ISampler {
+ public:
+  explicit PyramidSampler(std::shared_ptr<const SamplePyramid> pyramid);
+
+ private:
+  struct PyramidSamplerResampleData : public ResampleData {
+    std::shared_ptr<const WindowSample> sample;
+  };
+
+  PyramidSampler(const PyramidSampler& other);
+  char getSampleByte(size_t index) const override;
+  const char* getData() const override;
+  size_t getRealSampleSize() const override;
+  size_t getFileOffsetImpl(size_t index) const override;
+  size_t getSampleOffsetImpl(size_t address) const override;
+  ResampleData* prepareResample(SamplerConfig* sc) override;
+  void applyResample(ResampleData* rd) override;
+  void cleanupResample(ResampleData* rd) override;
+  PyramidSampler* cloneImpl() const override;
+
+  std::shared_ptr<const SamplePyramid> pyramid_;
+  std::shared_ptr<const WindowSample> sample_;
+};
+
+}  // namespace util
+}  // namespace veles
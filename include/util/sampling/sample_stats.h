@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <memory>
+
+#include "util/sampling/isampler.h"
+#include "util/stats/ngram_stats.h"
+
+namespace veles {
+namespace util {
+
+/**
+ * N-gram statistics of the latest of a series of snapshots (usually of one
+ * sampler), updated incrementally from the previous one.
+ *
+ * This pays off when consecutive samples share most of their windows:
+ * unsampled data whose range moves a bit at a time (eg. a minimap
+ * selection being dragged), or a UniformSampler with incremental
+ * resampling. Otherwise the statistics are counted from scratch.
+ *
+ * Not thread safe.
+ */
+class SampleStats {
+ public:
+  /** Count n-grams of up to max_order bytes, see stats::NgramStats.  */
+  explicit SampleStats(int max_order = 3) : stats_(max_order) {}
+
+  /**
+   * Make the statistics those of `snapshot`. Returns true if they were
+   * updated incrementally.
+   */
+  bool update(std::shared_ptr<const SampleSnapshot> snapshot);
+
+  const stats::NgramStats& stats() const { return stats_; }
+
+  /** Return the snapshot the statistics are of.  */
+  const std::shared_ptr<const SampleSnapshot>& snapshot() const {
+    return snapshot_;
+  }
+
+ private:
+  stats::NgramStats stats_;
+  // Keeps data of the windows counted in stats_ alive.
+  std::shared_ptr<const SampleSnapshot> snapshot_;
+};
+
+}  // namespace util
+}  // namespace veles
@@ -16,6 +16,8 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "util/sampling/isampler.h"
@@ -26,15 +28,45 @@ namespace util {
 class UniformSampler : public ISampler {
  public:
   explicit UniformSampler(const QByteArray& data);
-  ~UniformSampler() override;
+  explicit UniformSampler(std::shared_ptr<const DataSource> source);
 
   void setWindowSize(size_t size);
 
+  /**
+   * Set the seed used to pick windows. The same seed, data and config
+   * always produce the same sample, however many threads take part.
+   * Default seed is 0.
+   */
+  void setSeed(uint64_t seed);
+
+  /**
+   * Set if resampling after a range change should reuse the current sample.
+   * Windows of the current sample that still fit in the new range are kept
+   * (thinned out if the range grew), and only the missing ones are drawn
+   * and read from the data. This makes following a moving selection (eg.
+   * a minimap drag) much cheaper, at the cost of the sample depending on
+   * the history of ranges rather than only on the seed and current config.
+   * With a sample cache, a cached sample for the same config is still
+   * preferred over an incremental one, and incremental samples aren't put
+   * in the cache.
+   * Default value is false.
+   */
+  void setIncrementalResampling(bool incremental);
+
  private:
+  /**
+   * A complete sample. Once published in sample_ (or the sample cache)
+   * it's never modified, so prepareResample can read the previous one
+   * without holding the lock for long.
+   */
+  struct Sample : public WindowSample {
+    uint64_t seed;
+    // Absolute range of input data the sample was taken from.
+    size_t start, end;
+  };
+
   struct UniformSamplerResampleData : public ResampleData {
-    size_t window_size, windows_count;
-    std::vector<size_t> windows;
-    char* data;
+    std::shared_ptr<const Sample> sample;
   };
 
   UniformSampler(const UniformSampler& other);
@@ -48,10 +80,36 @@ class UniformSampler : public ISampler {
   void cleanupResample(ResampleData* rd) override;
   UniformSampler* cloneImpl() const override;
 
+  /** Compute the sample for sc, or return nullptr if cancelled.  */
+  std::shared_ptr<const Sample> computeSample(SamplerConfig* sc,
+                                              size_t window_size,
+                                              size_t windows_count);
+  /** Draw all windows of `sample` from scratch.  */
+  void drawWindows(size_t windows_count, SamplerConfig* sc,
+                   Sample* sample) const;
+  /**
+   * Draw windows of `sample` reusing those of `previous`. Sets
+   * reused[i] to the index of the window in `previous` that the i-th
+   * window is a copy of, or to SIZE_MAX for new windows. Returns false if
+   * `previous` can't be reused.
+   */
+  bool reuseWindows(const Sample& previous, size_t windows_count,
+                    SamplerConfig* sc, Sample* sample,
+                    std::vector<size_t>* reused) const;
+  /** Fill sample data, copying reused windows from `previous`.  */
+  void copyWindows(const Sample* previous, const std::vector<size_t>& reused,
+                   SamplerConfig* sc, Sample* sample) const;
+
+  // Windows are drawn, and then copied, in blocks of this many windows.
+  // Each block has its own random engine, seeded with the seed and block
+  // index, so blocks can be processed in parallel deterministically.
+  static const size_t k_windows_per_block = 1024;
+
+  uint64_t seed_;
   size_t window_size_, windows_count_;
   bool use_default_window_size_;
-  std::vector<size_t> windows_;
-  char* buffer_;
+  bool incremental_;
+  std::shared_ptr<const Sample> sample_;
 };
 
 }  // namespace util
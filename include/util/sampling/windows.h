@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace veles {
+namespace util {
+
+/** Helpers for samplers which take windows from several separate parts
+    of the data (blocks of a range, ranges of data that already arrived,
+    etc).  */
+
+/**
+ * Split windows_count windows between parts in proportion to weights,
+ * without giving any part more than its capacity. Rounding is done with
+ * the largest remainder method. If the capacities sum up to less than
+ * windows_count, every part gets its full capacity.
+ */
+std::vector<size_t> allocateWindows(size_t windows_count,
+                                    const std::vector<double>& weights,
+                                    const std::vector<size_t>& capacities);
+
+/**
+ * Draw `count` non-overlapping windows of window_size bytes, uniformly
+ * from [0, length), and write their sorted offsets to `out`.
+ * count * window_size must not exceed length.
+ */
+void drawWindows(size_t length, size_t count, size_t window_size,
+                 std::mt19937_64* generator, size_t* out);
+
+// drawWindows() in two steps, for drawing many windows of one range in
+// parallel: offsets can be drawn in blocks, each with its own generator,
+// and then spread all together.
+
+/** Draw `count` numbers from {0 ... max_offset}, with repetitions.  */
+void drawWindowOffsets(size_t max_offset, size_t count,
+                       std::mt19937_64* generator, size_t* out);
+/** Turn `count` drawn numbers into sorted offsets of non-overlapping
+    windows of window_size bytes.  */
+void spreadWindows(size_t count, size_t window_size, size_t* out);
+
+/** Return a random engine seeded with the sampler seed and up to two
+    values identifying what it's used for (eg. the part of data).  */
+std::mt19937_64 windowsGenerator(uint64_t seed, uint64_t part,
+                                 uint64_t subpart = 0);
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace veles {
+namespace util {
+namespace stats {
+
+/** Kernels computing statistics of byte spans, shared by visualizations.
+
+    The kernels are tuned for large inputs: histograms are counted into
+    several interleaved sub-histograms (so that runs of equal bytes don't
+    serialize on a single counter), sums and extremes use SIMD where
+    available, and inputs of several megabytes are split between threads.
+    Results don't depend on how the work was split.  */
+
+/** Number of occurrences of each byte value.  */
+using ByteHistogram = std::array<uint64_t, 256>;
+
+/** Adds the counts of byte values in data to hist.  */
+void accumulateHistogram(const uint8_t* data, size_t size,
+                         ByteHistogram* hist);
+
+/** Returns the counts of byte values in data.  */
+ByteHistogram histogram(const uint8_t* data, size_t size);
+
+/** Counts pairs of consecutive bytes: counts[a * 256 + b] is the number
+    of positions i such that data[i] == a and data[i + 1] == b.  If
+    position_sums is not null, position_sums[a * 256 + b] is the sum of
+    these positions.  Both arrays must have 256 * 256 elements, which are
+    overwritten.  */
+void digramHistogram(const uint8_t* data, size_t size, uint64_t* counts,
+                     uint64_t* position_sums = nullptr);
+
+/** Returns Shannon entropy, in bits per byte (so in [0, 8]), of bytes
+    with the given histogram and total count.  Returns 0 if total is 0.  */
+double entropy(const ByteHistogram& hist, uint64_t total);
+
+/** Returns Shannon entropy of data, in bits per byte.  */
+double entropy(const uint8_t* data, size_t size);
+
+/** Returns the sum of all bytes in data.  */
+uint64_t sum(const uint8_t* data, size_t size);
+
+/** Returns the mean byte value, or 0 for empty data.  */
+double mean(const uint8_t* data, size_t size);
+
+struct MinMax {
+  uint8_t min;
+  uint8_t max;
+};
+
+/** Returns the smallest and largest byte value.  data must not be
+    empty.  */
+MinMax minMax(const uint8_t* data, size_t size);
+
+/** A histogram of a window moving over the data - bytes are added at one
+    end and removed at the other one.  */
+class SlidingHistogram {
+ public:
+  SlidingHistogram() { counts_.fill(0); }
+
+  void add(uint8_t byte) {
+    counts_[byte]++;
+    total_++;
+  }
+
+  void remove(uint8_t byte) {
+    counts_[byte]--;
+    total_--;
+  }
+
+  void clear() {
+    counts_.fill(0);
+    total_ = 0;
+  }
+
+  const ByteHistogram& counts() const { return counts_; }
+  uint64_t total() const { return total_; }
+
+  /** Returns entropy of the current window, in bits per byte.  */
+  double entropy() const { return stats::entropy(counts_, total_); }
+
+ private:
+  ByteHistogram counts_;
+  uint64_t total_ = 0;
+};
+
+/** A table of n * log2(n) for counts n up to a maximum window size, which
+    evaluates entropy of windows of at most that many bytes with table
+    lookups instead of a division and a log2 per byte value.
+
+    Entropy of a window of N bytes with counts c_i is
+    (N * log2(N) - sum(c_i * log2(c_i))) / N.  Terms are kept in fixed
+    point, so a sum of terms updated as bytes enter and leave a window is
+    exact and doesn't drift, however long the window slides.  */
+class EntropyTable {
+ public:
+  /** Builds the table for windows of up to max_size bytes.  Takes
+      max_size + 1 log2 calls, so it pays off when evaluating many windows
+      of similar size.  */
+  explicit EntropyTable(uint64_t max_size);
+
+  uint64_t maxSize() const { return terms_.size() - 1; }
+
+  /** Returns n * log2(n) in fixed point, for n <= maxSize().  */
+  int64_t term(uint64_t n) const { return terms_[n]; }
+
+  /** Returns entropy, in bits per byte, of a window of total bytes whose
+      counts have the given sum of term()s.  total must be at most
+      maxSize().  Returns 0 if total is 0.  */
+  double entropy(int64_t term_sum, uint64_t total) const {
+    if (total == 0) {
+      return 0.0;
+    }
+    return static_cast<double>(terms_[total] - term_sum) /
+           (static_cast<double>(total) * k_term_scale);
+  }
+
+  /** Same as stats::entropy(), for total of at most maxSize().  */
+  double entropy(const ByteHistogram& hist, uint64_t total) const;
+
+ private:
+  static constexpr double k_term_scale = 1 << 24;
+  std::vector<int64_t> terms_;
+};
+
+/** A SlidingHistogram which also keeps the entropy of the window up to
+    date, in O(1) per byte added or removed.  The window must never be
+    longer than the table's maxSize().  */
+class SlidingEntropy {
+ public:
+  /** The table must outlive this.  */
+  explicit SlidingEntropy(const EntropyTable* table) : table_(table) {
+    counts_.fill(0);
+  }
+
+  void add(uint8_t byte) {
+    uint64_t& count = counts_[byte];
+    term_sum_ += table_->term(count + 1) - table_->term(count);
+    count++;
+    total_++;
+  }
+
+  void remove(uint8_t byte) {
+    uint64_t& count = counts_[byte];
+    term_sum_ += table_->term(count - 1) - table_->term(count);
+    count--;
+    total_--;
+  }
+
+  void clear() {
+    counts_.fill(0);
+    total_ = 0;
+    term_sum_ = 0;
+  }
+
+  const ByteHistogram& counts() const { return counts_; }
+  uint64_t total() const { return total_; }
+
+  /** Returns entropy of the current window, in bits per byte.  */
+  double entropy() const { return table_->entropy(term_sum_, total_); }
+
+ private:
+  const EntropyTable* table_;
+  ByteHistogram counts_;
+  uint64_t total_ = 0;
+  int64_t term_sum_ = 0;
+};
+
+}  // namespace stats
+}  // namespace util
+}  // namespace veles
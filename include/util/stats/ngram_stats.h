@@ -0,0 +1,187 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "util/stats/byte_stats.h"
+
+namespace veles {
+namespace util {
+namespace stats {
+
+/** Byte, digram and (coarse) trigram statistics of a set of windows of
+    some data, which follow the windows as they change.
+
+    Only n-grams lying entirely within a window are counted - a window is
+    a contiguous piece of the data, and bytes of different windows aren't
+    next to each other in it.  Windows are identified by their offsets in
+    the data, so an n-gram at a given offset is assumed to be the same in
+    every set of windows it's in.  When the windows change, only n-grams
+    that appeared or disappeared are counted, eg. for a single window moved
+    by a few bytes, only the bytes at its ends are.  If that would take
+    longer than counting everything again (eg. the window jumped far away),
+    everything is counted again, split between threads.
+
+    Only n-grams up to a given length are counted, as users rarely need all
+    of them, and trigrams cost more than bytes and digrams together.  */
+class NgramStats {
+ public:
+  struct Window {
+    /** Offset of the first byte in the data.  */
+    uint64_t offset;
+    const uint8_t* data;
+    size_t size;
+  };
+
+  /** An exact sum of offsets, as a 128-bit integer - sums of offsets in
+      large data would overflow 64 bits, and doubles would drift as offsets
+      are added and subtracted over and over.  Like the counts, it wraps
+      around while n-grams are subtracted.  */
+  struct OffsetSum {
+    uint64_t low, high;
+
+    void add(uint64_t value) {
+      low += value;
+      high += low < value ? 1 : 0;
+    }
+    void subtract(uint64_t value) {
+      high -= low < value ? 1 : 0;
+      low -= value;
+    }
+    void add(const OffsetSum& other) {
+      add(other.low);
+      high += other.high;
+    }
+    /** Adds (or subtracts, if negative is set) count * value.  */
+    void addProduct(uint64_t count, uint64_t value, bool negative);
+
+    double toDouble() const {
+      return static_cast<double>(high) * 18446744073709551616.0 +
+             static_cast<double>(low);
+    }
+
+    bool operator==(const OffsetSum& other) const {
+      return low == other.low && high == other.high;
+    }
+  };
+
+  /** Trigrams are counted on a grid of k_trigram_grid_size ^ 3 cells, each
+      byte value falling into one of k_trigram_grid_size ranges.  */
+  static const int k_trigram_grid_bits = 6;
+  static const size_t k_trigram_grid_size = size_t(1) << k_trigram_grid_bits;
+
+  /** Counts n-grams of up to max_order (1 to 3) bytes.  Statistics of
+      longer ones are empty.  */
+  explicit NgramStats(int max_order = 3);
+
+  int maxOrder() const { return max_order_; }
+
+  /** Makes the statistics those of an empty set of windows.  */
+  void clear();
+
+  /** Makes the statistics those of the given windows, which must be sorted
+      by offset and not overlap.  Data of the previous windows must still be
+      valid when this is called, as n-grams that disappeared are read from
+      it.  Returns true if the statistics were updated incrementally, false
+      if they were counted from scratch.  */
+  bool setWindows(const std::vector<Window>& windows);
+
+  /** Total number of bytes in the windows.  */
+  uint64_t size() const { return size_; }
+
+  /** Number of occurrences of each byte value.  */
+  const ByteHistogram& bytes() const { return counts_.bytes; }
+
+  /** Number of occurrences of each pair of consecutive bytes, indexed by
+      first * 256 + second.  Empty if maxOrder() < 2.  */
+  const std::vector<uint64_t>& digrams() const { return counts_.digrams; }
+
+  /** Sums of offsets (in the data) of the pairs of bytes counted in
+      digrams().  */
+  const std::vector<OffsetSum>& digramOffsetSums() const {
+    return counts_.digram_offset_sums;
+  }
+
+  /** Number of occurrences of each triple of consecutive bytes, by grid
+      cell - see trigramCell().  Empty if maxOrder() < 3.  */
+  const std::vector<uint64_t>& trigrams() const { return counts_.trigrams; }
+
+  /** Returns the index in trigrams() of the cell a triple falls into.  */
+  static size_t trigramCell(uint8_t a, uint8_t b, uint8_t c) {
+    const int shift = 8 - k_trigram_grid_bits;
+    return ((size_t(a >> shift) * k_trigram_grid_size + (b >> shift)) *
+            k_trigram_grid_size) +
+           (c >> shift);
+  }
+
+ private:
+  /** Starts of n-grams (by offset in the data) taken from a window.  */
+  struct Starts {
+    uint64_t begin, end;
+    const Window* window;
+  };
+
+  /** Starts of all n-grams of length n lying entirely within windows.  */
+  static std::vector<Starts> ngramStarts(const std::vector<Window>& windows,
+                                         size_t n);
+  /** Starts in a which are not in b.  Both must be sorted and disjoint.  */
+  static std::vector<Starts> subtract(const std::vector<Starts>& a,
+                                      const std::vector<Starts>& b);
+  /** Starts number [first, last) of all starts, counting from the first
+      start of the first element of starts.  */
+  static std::vector<Starts> slice(const std::vector<Starts>& starts,
+                                   uint64_t first, uint64_t last);
+
+  struct Counts {
+    explicit Counts(int max_order);
+
+    void clear();
+    void add(const Counts& other);
+
+    ByteHistogram bytes;
+    std::vector<uint64_t> digrams;
+    std::vector<OffsetSum> digram_offset_sums;
+    std::vector<uint64_t> trigrams;
+  };
+
+  /** Count n-grams starting within added[n - 1] (for each maintained
+      n) into counts_, which must be clear.  Windows are split between
+      threads, counting into their own tables added up at the end.  */
+  void countAll(const std::vector<Starts>* added);
+
+  /** Add (or subtract) n-grams starting within given starts.  */
+  static void countBytes(const Starts& starts, bool subtract,
+                         Counts* counts);
+  static void countDigrams(const Starts& starts, bool subtract,
+                           Counts* counts);
+  static void countTrigrams(const Starts& starts, bool subtract,
+                            Counts* counts);
+  static void count(size_t n, const Starts& starts, bool subtract,
+                    Counts* counts);
+
+  int max_order_;
+  std::vector<Window> windows_;
+  uint64_t size_;
+  Counts counts_;
+};
+
+}  // namespace stats
+}  // namespace util
+}  // namespace veles
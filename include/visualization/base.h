@@ -18,6 +18,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 
 #include <QBoxLayout>
 #include <QMainWindow>
@@ -73,24 +74,44 @@ class VisualizationWidget : public QOpenGLWidget,
 
   /**
    * This will be called in worker thread when new sample is ready.
-   * Derive this method to do some additional processing in worker thread.
-   * Keep in mind that this method will be executed while holding sampler
-   * lock, so doing very expensive stuff here might hurt your performance.
+   * Derive this method to do some additional processing of the new sample
+   * in worker thread. It doesn't hold sampler lock, but it delays other
+   * resample callbacks, so keep it reasonably cheap.
    * Return value of this method will be passed along with resampled() signal
-   * and in particular will be passed to refresh().
+   * and in particular will be passed to refresh(), while getSnapshot()
+   * returns `snapshot`.
    */
-  virtual AdditionalResampleData* onAsyncResample() { return nullptr; }
+  virtual AdditionalResampleData* onAsyncResample(
+      const std::shared_ptr<const util::SampleSnapshot>& /*snapshot*/) {
+    return nullptr;
+  }
 
+  // These read the snapshot shown by the last refreshVisualization().  The
+  // pointer returned by getData() is valid until the next one.
+
+  std::shared_ptr<const util::SampleSnapshot> getSnapshot();
   size_t getDataSize();
   const char* getData();
+  /** Returns 0 past the end of the sample.  */
   char getByte(size_t index);
 
  private:
+  /**
+   * What resampleCallback() passes on to refreshVisualization(): the result
+   * of onAsyncResample() and the snapshot it was computed from.
+   */
+  struct ResampleResult : public AdditionalResampleData {
+    std::shared_ptr<const util::SampleSnapshot> snapshot;
+    AdditionalResampleDataPtr data;
+  };
+
   bool initialized_ = false;
   bool gl_initialized_ = false;
   bool gl_broken_ = false;
   bool error_message_set_ = false;
   util::ISampler* sampler_ = nullptr;
+  std::mutex snapshot_mutex_;
+  std::shared_ptr<const util::SampleSnapshot> snapshot_;
   util::ResampleCallbackId resample_cb_id_;
 };
 
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include <QOpenGLBuffer>
@@ -27,6 +29,7 @@
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLWidget>
 
+#include "util/sampling/sample_stats.h"
 #include "visualization/base.h"
 
 namespace veles {
@@ -39,6 +42,19 @@ class DigramWidget : public VisualizationWidget {
   explicit DigramWidget(QWidget* parent = nullptr);
   ~DigramWidget() override;
 
+  /**
+   * Texture of a sample, ready for upload: for every pair of bytes, its
+   * count relative to the sample size, times its mean position relative
+   * to the range.
+   */
+  struct DigramData : public AdditionalResampleData {
+    // [256][256][2], represented as single block.
+    std::vector<float> table;
+  };
+
+  /** Compute the texture of the sample `stats` are of, owned by caller.  */
+  static DigramData* computeDigramData(const util::SampleStats& stats);
+
  protected:
   void refresh(const AdditionalResampleDataPtr& ad) override;
   bool initializeVisualizationGL() override;
@@ -46,11 +62,22 @@ class DigramWidget : public VisualizationWidget {
   void resizeGLImpl(int w, int h) override;
   void paintGLImpl() override;
 
+  AdditionalResampleData* onAsyncResample(
+      const std::shared_ptr<const util::SampleSnapshot>& snapshot) override;
+
   void initShaders();
-  void initTextures();
+  void initTextures(const DigramData& data);
   void initGeometry();
 
+  /** Return texture of the current snapshot, counted from scratch.  */
+  DigramData* currentDigramData();
+
  private:
+  // Statistics of the latest asynchronous resample. As a range is dragged
+  // over the data, only the bytes that entered or left it are counted.
+  util::SampleStats sample_stats_{2};
+  std::mutex sample_stats_mutex_;
+
   QOpenGLShaderProgram program_;
   QOpenGLTexture* texture_ = nullptr;
 
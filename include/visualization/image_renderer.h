@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <QColor>
+#include <QImage>
+
+#include "util/sampling/isampler.h"
+#include "util/sampling/sample_stats.h"
+#include "visualization/minimap.h"
+
+namespace veles {
+namespace visualization {
+
+/*
+ * CPU renderers of visualizations, which don't need an OpenGL context (eg.
+ * to make thumbnails on a headless server). They use the same statistics
+ * as the OpenGL widgets, and color them the way the widgets' shaders do.
+ */
+
+/**
+ * Render the digram heat map of the sample `stats` are of, 256 x 256
+ * pixels: the first byte of a pair goes up, the second one right.
+ */
+QImage renderDigram(const util::SampleStats& stats);
+
+/**
+ * Render a minimap strip of the whole sample, width x height pixels, read
+ * row by row from the top.
+ */
+QImage renderMinimap(const util::SampleSnapshot& snapshot,
+                     VisualizationMinimap::MinimapMode mode,
+                     VisualizationMinimap::MinimapColor color, int width,
+                     int height);
+
+/**
+ * Render the trigram cube of the sample, size x size pixels, in a fixed
+ * orthographic projection seen from above one of its corners. Points are
+ * colored from color_begin to color_end by their position in the sample,
+ * and lit like in the trigram widget with the given brightness (see
+ * TrigramWidget::suggestBrightness()).
+ */
+QImage renderTrigram(const util::SampleSnapshot& snapshot, int size,
+                     int brightness, const QColor& color_begin,
+                     const QColor& color_end);
+
+}  // namespace visualization
+}  // namespace veles
@@ -16,6 +16,11 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <QMouseEvent>
 #include <QOpenGLBuffer>
 #include <QOpenGLFunctions_3_2_Core>
@@ -27,6 +32,7 @@
 #include <QWheelEvent>
 
 #include "util/sampling/isampler.h"
+#include "visualization/minimap_texels.h"
 
 namespace veles {
 namespace visualization {
@@ -38,7 +44,7 @@ class VisualizationMinimap : public QOpenGLWidget,
  public:
   enum class MinimapColor { RED = 0, GREEN, BLUE };
 
-  enum class MinimapMode { VALUE, ENTROPY };
+  using MinimapMode = visualization::MinimapMode;
 
   explicit VisualizationMinimap(QWidget* parent = nullptr);
   ~VisualizationMinimap() override;
@@ -47,13 +53,21 @@ class VisualizationMinimap : public QOpenGLWidget,
   void setRange(size_t start, size_t end, bool reset_selection = true);
   QPair<size_t, size_t> getSelectedRange();
   void setSelectedRange(size_t start_address, size_t end_address);
-  void refresh(bool has_context = false);
+
+  /**
+   * Start calculating the texture of the current sample. The calculation
+   * runs on the visualization thread pool, and the texture is uploaded
+   * once it's done. Until then the previous texture is shown.
+   */
+  void refresh();
 
   void setMinimapColor(MinimapColor color);
   void setMinimapMode(MinimapMode mode);
 
  signals:
   void selectionChanged(size_t start, size_t end);
+  /** Emitted from a worker thread when a texture is ready for upload.  */
+  void textureCalculated();
 
  protected:
   void mouseMoveEvent(QMouseEvent* event) override;
@@ -71,6 +85,7 @@ class VisualizationMinimap : public QOpenGLWidget,
   void initShaders();
   void initTextures();
   void initGeometry();
+  void uploadTexture();
 
  private:
   struct ScalingInfo {
@@ -90,28 +105,41 @@ class VisualizationMinimap : public QOpenGLWidget,
   size_t lineToOffset(float line_position);
   float offsetToLine(size_t offset);
 
-  static float* calculateAverageValueTexture(const uint8_t* sample,
-                                             size_t sample_size,
-                                             size_t texture_size,
-                                             double point_size);
-  static float* calculateEntropyTexture(const uint8_t* sample,
-                                        size_t sample_size, size_t texture_size,
-                                        double point_size);
-
-  static float* calculateEntropyTexturePerPixel(const uint8_t* sample,
-                                                size_t sample_size,
-                                                size_t texture_size,
-                                                double point_size);
-  static float* calculateEntropyTextureSlidingWindow(const uint8_t* sample,
-                                                     size_t sample_size,
-                                                     size_t texture_size,
-                                                     double point_size);
-  static float* calculateEntropyTextureSingleWindow(const uint8_t* sample,
-                                                    size_t sample_size,
-                                                    size_t texture_size,
-                                                    double point_size);
-  static float calculateEntropyValue(const uint64_t* bytes_counts,
-                                     uint64_t total_count);
+  /** Texture calculated on a worker thread.  */
+  struct Texture {
+    uint64_t version;
+    size_t rows, cols;
+    std::vector<float> texels;
+  };
+
+  /**
+   * State shared between the minimap and its texture calculations, which
+   * may still be running after the minimap is deleted.
+   */
+  struct TextureJobs {
+    std::mutex mutex;
+    // nullptr once the minimap is deleted.
+    VisualizationMinimap* minimap;
+    // Incremented by every refresh(). Calculations that haven't started
+    // before a newer one was requested are skipped.
+    uint64_t version = 0;
+    // Version of the uploaded texture. Textures calculated later but of
+    // older versions are dropped.
+    uint64_t uploaded = 0;
+    // Newest calculated texture, waiting for upload.
+    std::unique_ptr<Texture> ready;
+    // Texels of uploaded or dropped textures, reused by the next
+    // calculation instead of allocating a new buffer every refresh().
+    std::vector<float> spare;
+
+    /** Keep the bigger of `texels` and spare. Requires mutex.  */
+    void recycle(std::vector<float>* texels);
+  };
+
+  static void calculateTexture(
+      const std::shared_ptr<TextureJobs>& jobs, uint64_t version,
+      const std::shared_ptr<const util::SampleSnapshot>& snapshot,
+      MinimapMode mode, size_t rows, size_t cols);
 
   bool empty();
 
@@ -122,7 +150,6 @@ class VisualizationMinimap : public QOpenGLWidget,
   const MinimapMode k_default_mode = MinimapMode::VALUE;
   const float k_line_selection_epsilon = 0.003f;
   const float k_minimum_line_distance = 0.02f;
-  static const size_t k_minimum_entropy_window = 256;
   const int k_bar_height = 7;
   const int k_bar_texture_width = 100;
   const float k_line_comparison_epsilon = 0.1f;
@@ -154,6 +181,8 @@ class VisualizationMinimap : public QOpenGLWidget,
 
   QOpenGLBuffer square_vertex_;
   QOpenGLVertexArrayObject vao_;
+
+  std::shared_ptr<TextureJobs> texture_jobs_;
 };
 
 }  //  namespace visualization
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "util/sampling/isampler.h"
+#include "util/stats/byte_stats.h"
+
+namespace veles {
+namespace visualization {
+
+enum class MinimapMode { VALUE, ENTROPY };
+
+/*
+ * Texels of minimap textures, calculated on the CPU so that they don't need
+ * a widget or an OpenGL context.  Pixel `index` of a texture shows sample
+ * bytes [pixelStart(index), pixelStart(index + 1)).
+ */
+namespace minimap {
+
+// Pixels of up to this many bytes get entropy of a window of this many
+// bytes around them instead of entropy of their own bytes.
+const size_t k_minimum_entropy_window = 256;
+// Per pixel entropy is evaluated with a util::stats::EntropyTable for
+// pixels of up to this many bytes, and with log2 calls above that.
+const size_t k_maximum_entropy_table_size = 1 << 20;
+// Texture calculation is split between threads in segments of at least
+// this many sample bytes.
+const size_t k_minimum_segment_size = 256 * 1024;
+
+/** What a texture is calculated from.  */
+struct TextureInput {
+  const uint8_t* sample;
+  size_t sample_size;
+  size_t texture_size;
+  double point_size;
+};
+
+/**
+ * Shrink a rows x cols texture, keeping its aspect ratio, so that it
+ * doesn't have more pixels than the sample has bytes.
+ */
+void fitTextureToSample(size_t sample_size, size_t* rows, size_t* cols);
+
+/**
+ * Calculate the texels of a texture of texture_size pixels of the whole
+ * sample, row by row, the way the minimap shows it. Runs on the calling
+ * thread, helped by parallelFor if the sample is big enough.
+ */
+void calculateTexels(const util::SampleSnapshot& snapshot, MinimapMode mode,
+                     size_t texture_size, std::vector<float>* texels);
+
+/** Returns input of a texture of texture_size pixels of the whole sample.  */
+TextureInput textureInput(const uint8_t* sample, size_t sample_size,
+                          size_t texture_size);
+
+/**
+ * Call func(first, last) for segments of pixels [first, last) covering
+ * the whole texture, in parallel if the sample is big enough.
+ */
+void forSegments(const TextureInput& in,
+                 const std::function<void(size_t, size_t)>& func);
+
+/** Calculate all texels of an entropy texture.  */
+void calculateEntropyTexture(const TextureInput& in, float* texels);
+
+// These calculate pixels [first, last) of the texture. Entropy is
+// calculated in one of three ways, picked by calculateEntropyTexture()
+// from the sizes of the sample and the pixels.
+
+void calculateAverageValueTexture(const TextureInput& in, size_t first,
+                                  size_t last, float* texels);
+
+/** Entropy of bytes of each pixel. table is nullptr if pixels are too big
+    for a table.  */
+void calculateEntropyTexturePerPixel(const TextureInput& in,
+                                     const util::stats::EntropyTable* table,
+                                     size_t first, size_t last, float* texels);
+/** Entropy of a k_minimum_entropy_window window around the first byte of
+    each pixel.  */
+void calculateEntropyTextureSlidingWindow(
+    const TextureInput& in, const util::stats::EntropyTable& table,
+    size_t first, size_t last, float* texels);
+/** Average information content of bytes of each pixel, with probabilities
+    of byte values taken from the whole sample.  */
+void calculateEntropyTextureSingleWindow(const TextureInput& in,
+                                         const float* surprisal, size_t first,
+                                         size_t last, float* texels);
+
+/** Returns the first sample offset belonging to the pixel with the given
+    index, or sample_size for index == texture_size.  */
+size_t pixelStart(size_t index, double point_size, size_t sample_size,
+                  size_t texture_size);
+/** Returns the texel value of entropy in bits per byte.  */
+float entropyTexel(double entropy);
+
+}  // namespace minimap
+
+}  // namespace visualization
+}  // namespace veles
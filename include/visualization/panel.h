@@ -16,7 +16,10 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 
 #include <QAction>
 #include <QBoxLayout>
@@ -27,10 +30,14 @@
 #include <QWidget>
 #include <QWidgetAction>
 
+#include "data/bindata.h"
 #include "ui/dockwidget.h"
 #include "ui/fileblobmodel.h"
 #include "ui/mainwindowwithdetachabledockwidgets.h"
 #include "ui/nodetreewidget.h"
+#include "util/sampling/data_source.h"
+#include "util/sampling/progressive_sampler.h"
+#include "util/sampling/sample_cache.h"
 #include "visualization/base.h"
 #include "visualization/minimap_panel.h"
 #include "visualization/samplingmethoddialog.h"
@@ -48,13 +55,24 @@ class VisualizationPanel : public ui::IconAwareView {
       QWidget* parent = nullptr);
   ~VisualizationPanel() override;
 
-  void setData(const QByteArray& data);
+  /** Visualizes the complete data of the model.  The samplers read it in
+      place without copying and share samples with other views of it.  */
+  void setData();
+  /** Visualizes data of the model while it's still arriving.  Samples are
+      taken from the parts that already arrived (see
+      FileBlobModel::partialBinData()) and refined as more of it comes in,
+      until the complete data replaces them.  */
+  void setProgressiveData();
   void setRange(size_t start, size_t end);
   bool eventFilter(QObject* watched, QEvent* event) override;
 
  public slots:
   void visibilityChanged(bool visibility);
 
+ signals:
+  /** Emitted (from any thread) once a minimap pyramid is built.  */
+  void pyramidBuilt();
+
  private slots:
   void setSamplingMethod(const QString& name);
   void setSampleSize(size_t size);
@@ -63,9 +81,12 @@ class VisualizationPanel : public ui::IconAwareView {
   void showLayeredDigramVisualization();
   void minimapSelectionChanged(size_t start, size_t end);
   void showMoreOptions();
+  void binDataReceived(uint64_t start, uint64_t end);
+  void newBinData();
+  void usePyramid();
 
  private:
-  enum class ESampler { NO_SAMPLER, UNIFORM_SAMPLER };
+  enum class ESampler { NO_SAMPLER, UNIFORM_SAMPLER, ENTROPY_SAMPLER };
   enum class EVisualization { DIGRAM, TRIGRAM, LAYERED_DIGRAM };
 
   static const std::map<QString, ESampler> k_sampler_map;
@@ -73,24 +94,46 @@ class VisualizationPanel : public ui::IconAwareView {
   static const EVisualization k_default_visualization = EVisualization::TRIGRAM;
   static const int k_max_sample_size = 128 * 1024 * 1024;
   static const int k_minimap_sample_size = 4 * 1024 * 1024;
+  // Minimaps zoomed in up to 8 times are served from the sample pyramid.
+  static const int k_minimap_pyramid_size = 8 * k_minimap_sample_size;
 
-  static util::ISampler* getSampler(ESampler type, const QByteArray& data,
-                                    qint64 sample_size);
+  static util::ISampler* getSampler(
+      ESampler type, const std::shared_ptr<const util::DataSource>& data,
+      const std::shared_ptr<util::SampleCache>& cache, qint64 sample_size);
   VisualizationWidget* getVisualization(EVisualization type,
                                         QWidget* parent = nullptr);
   static QString prepareAddressString(size_t start, size_t end);
 
+  struct PyramidJobs {
+    std::mutex mutex;
+    // nullptr once the panel is deleted.
+    VisualizationPanel* panel;
+  };
+
+  void resetSamplers();
+  /** Delete a sampler once its queued resamples are done.  */
+  static void deleteSampler(util::ISampler* sampler);
+  void buildPyramid();
   void setVisualization(EVisualization type);
   void refreshVisualization();
   void initLayout();
   void initOptionsPanel();
   void prepareVisualizationOptions();
 
-  QByteArray data_;
+  std::shared_ptr<const util::DataSource> data_;
+  // Set while data of the model is still arriving.
+  std::shared_ptr<const util::ProgressiveDataSource> progressive_data_;
+  // Samples shared with other panels of the blob, once all data is there.
+  std::shared_ptr<util::SampleCache> sample_cache_;
   ESampler sampler_type_;
   EVisualization visualization_type_;
   size_t sample_size_;
   util::ISampler *sampler_, *minimap_sampler_;
+  // sampler_ and minimap_sampler_ while progressive_data_ is set.
+  util::ProgressiveSampler *progressive_sampler_, *progressive_minimap_sampler_;
+  // Set once minimap_sampler_ is served from the sample pyramid.
+  bool minimap_from_pyramid_;
+  std::shared_ptr<PyramidJobs> pyramid_jobs_;
   MinimapPanel* minimap_;
   VisualizationWidget* visualization_;
   QMainWindow* visualization_root_;
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include <QAction>
@@ -33,7 +35,9 @@
 #include <QTime>
 #include <QToolBar>
 
+#include "util/sampling/sample_stats.h"
 #include "util/settings/shortcuts.h"
+#include "util/stats/byte_stats.h"
 #include "visualization/base.h"
 #include "visualization/manipulator.h"
 
@@ -112,6 +116,10 @@ class TrigramWidget : public VisualizationWidget {
     int brightness;
   };
 
+  /** Heuristic brightness for a sample with the given byte counts.  */
+  static int suggestBrightness(util::stats::ByteHistogram counts,
+                               uint64_t size);
+
  public slots:
   void brightnessSliderMoved(int value);
 
@@ -125,7 +133,8 @@ class TrigramWidget : public VisualizationWidget {
   void resizeGLImpl(int w, int h) override;
   void paintGLImpl() override;
 
-  AdditionalResampleData* onAsyncResample() override;
+  AdditionalResampleData* onAsyncResample(
+      const std::shared_ptr<const util::SampleSnapshot>& snapshot) override;
 
   void paintLabels(const QMatrix4x4& scene_mp, const QMatrix4x4& scene_m);
   void paintLabel(const LabelPositionMixer& mixer,
@@ -164,9 +173,14 @@ class TrigramWidget : public VisualizationWidget {
   int brightness_;  // has to be set through setBrightness()
   void setBrightness(int value);
 
-  int suggestBrightness();  // heuristic
+  int suggestBrightness(const uint8_t* data, size_t size);  // heuristic
   void autoSetBrightness();
 
+  // Statistics of the latest asynchronous resample, for the brightness
+  // heuristic - which only needs bytes.
+  util::SampleStats sample_stats_{1};
+  std::mutex sample_stats_mutex_;
+
   QBasicTimer timer_;
   QOpenGLShaderProgram program_;
   QOpenGLTexture* texture_ = nullptr;
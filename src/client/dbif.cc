@@ -37,7 +37,14 @@ namespace client {
 
 NCObjectHandle::NCObjectHandle(NCWrapper* nc, const data::NodeID& id,
                                dbif::ObjectType type)
-    : nc_(nc), id_(id), type_(type) {}
+    : nc_(nc),
+      id_(id),
+      handle_(nc != nullptr ? nc->internNodeId(id) : data::NodeHandle()),
+      type_(type) {}
+
+NCObjectHandle::NCObjectHandle(NCWrapper* nc, data::NodeHandle handle,
+                               dbif::ObjectType type)
+    : nc_(nc), id_(nc->nodeId(handle)), handle_(handle), type_(type) {}
 
 data::NodeID NCObjectHandle::id() { return id_; }
 
@@ -57,6 +64,9 @@ dbif::MethodResultPromise* NCObjectHandle::runMethod(
 dbif::ObjectType NCObjectHandle::type() const { return type_; }
 
 bool NCObjectHandle::operator==(const NCObjectHandle& other) {
+  if (nc_ == other.nc_ && handle_.isValid()) {
+    return handle_ == other.handle_;
+  }
   return id_ == other.id_;
 }
 
@@ -276,12 +286,13 @@ void NCWrapper::handleGetChildrenListReply(
   }
 
   for (const auto& child : *reply->objs) {
-    (*children_map)[*child->id] =
-        NCObjectHandle(this, *child->id, typeFromTags(child->tags));
+    auto handle = node_ids_.intern(*child->id);
+    (*children_map)[handle] =
+        NCObjectHandle(this, handle, typeFromTags(child->tags));
   }
 
   for (const auto& child_gone : *reply->gone) {
-    children_map->erase(*child_gone);
+    children_map->erase(node_ids_.find(*child_gone));
   }
 
   std::vector<dbif::ObjectHandle> objects;
@@ -763,14 +774,15 @@ dbif::MethodResultPromise* NCWrapper::handleRootCreateFileBlobFromDataRequest(
     auto data = std::make_shared<std::unordered_map<
         std::string, std::shared_ptr<messages::MsgpackObject>>>();
 
+    // Read through a const reference, so the data doesn't get detached.
+    const data::BinData& file_data = create_file_blob_request->data;
     auto bindata = std::make_shared<std::unordered_map<
         std::string, std::shared_ptr<std::vector<uint8_t>>>>();
     bindata->insert(
         std::pair<std::string, std::shared_ptr<std::vector<uint8_t>>>(
             "data", std::make_shared<std::vector<uint8_t>>(
-                        create_file_blob_request->data.rawData(),
-                        create_file_blob_request->data.rawData() +
-                            create_file_blob_request->data.size())));
+                        file_data.rawData(),
+                        file_data.rawData() + file_data.size())));
 
     auto triggers =
         std::make_shared<std::unordered_set<std::shared_ptr<std::string>>>();
@@ -918,14 +930,14 @@ dbif::MethodResultPromise* NCWrapper::handleChunkCreateSubBlobRequest(
     auto data = std::make_shared<std::unordered_map<
         std::string, std::shared_ptr<messages::MsgpackObject>>>();
 
+    const data::BinData& subblob_data = chunk_create_subblob_request->data;
     auto bindata = std::make_shared<std::unordered_map<
         std::string, std::shared_ptr<std::vector<uint8_t>>>>();
     bindata->insert(
         std::pair<std::string, std::shared_ptr<std::vector<uint8_t>>>(
             "data", std::make_shared<std::vector<uint8_t>>(
-                        chunk_create_subblob_request->data.rawData(),
-                        chunk_create_subblob_request->data.rawData() +
-                            chunk_create_subblob_request->data.size())));
+                        subblob_data.rawData(),
+                        subblob_data.rawData() + subblob_data.size())));
 
     auto triggers =
         std::make_shared<std::unordered_set<std::shared_ptr<std::string>>>();
@@ -1042,9 +1054,9 @@ dbif::MethodResultPromise* NCWrapper::handleChangeDataRequest(
                      << endl;
     }
 
+    const data::BinData& new_data = change_data_request->data;
     auto bindata = std::make_shared<std::vector<uint8_t>>(
-        change_data_request->data.rawData(),
-        change_data_request->data.rawData() + change_data_request->data.size());
+        new_data.rawData(), new_data.rawData() + new_data.size());
 
     auto operation = std::make_shared<proto::OperationSetBinData>(
         std::make_shared<data::NodeID>(id),
@@ -1373,11 +1385,11 @@ void NCWrapper::updateChildrenDataItems(
     const std::shared_ptr<std::vector<std::shared_ptr<veles::data::NodeID>>>&
         gone) {
   for (const auto& child : *children) {
-    query->children_map[*child->id] = child;
+    query->children_map[node_ids_.intern(*child->id)] = child;
   }
 
   for (const auto& child_gone : *gone) {
-    query->children_map.erase(*child_gone);
+    query->children_map.erase(node_ids_.find(*child_gone));
   }
 
   query->children_loaded = true;
@@ -1417,7 +1429,7 @@ std::vector<data::ChunkDataItem> NCWrapper::resultDataItems(
         !item.ref.empty()) {
       auto handle = item.ref[0].dynamicCast<NCObjectHandle>();
       if (!handle.isNull() &&
-          query.children_map.find(handle->id()) != query.children_map.end()) {
+          query.children_map.count(handle->handle()) != 0) {
         continue;
       }
     }
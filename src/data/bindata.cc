@@ -19,43 +19,259 @@
 #include <algorithm>
 #include <cassert>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include <QFile>
 #include <QtGlobal>
 
 namespace veles {
 namespace data {
 
+namespace {
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VELES_COPYBITS_X86 1
+#endif
+
+/** Reads a little-endian 64-bit word from an arbitrarily aligned pointer.
+    Compilers turn this into a single load on little-endian targets.  */
+inline uint64_t load64Le(const uint8_t* p) {
+  uint64_t res = 0;
+  for (int i = 0; i < 8; i++) {
+    res |= static_cast<uint64_t>(p[i]) << (8 * i);
+  }
+  return res;
+}
+
+inline void store64Le(uint8_t* p, uint64_t val) {
+  for (int i = 0; i < 8; i++) {
+    p[i] = static_cast<uint8_t>(val >> (8 * i));
+  }
+}
+
+/** Copies up to 8 bits at a time, for the unaligned head and tail of
+    a copy.  Pointers and bit indices are advanced past the copied bits.  */
+void copyBitsSlow(uint8_t*& dst, unsigned& dst_bit, const uint8_t*& src,
+                  unsigned& src_bit, size_t num_bits) {
+  while (num_bits > 0) {
+    unsigned cur_bits = static_cast<unsigned>(
+        std::min<size_t>({8 - src_bit, 8 - dst_bit, num_bits}));
+    uint8_t mask = (1 << cur_bits) - 1;
+    uint8_t bits = (*src >> src_bit) & mask;
+    *dst &= ~(mask << dst_bit);
+    *dst |= bits << dst_bit;
+    src_bit += cur_bits;
+    dst_bit += cur_bits;
+    num_bits -= cur_bits;
+    if (src_bit == 8) {
+      src++;
+      src_bit = 0;
+    }
+    if (dst_bit == 8) {
+      dst++;
+      dst_bit = 0;
+    }
+  }
+}
+
+/** Copies whole 64-bit words from a source shifted right by `shift` bits
+    (1..7) into an octet-aligned destination.  Returns the number of words
+    copied.  Each word reads 9 source octets, so the caller must guarantee
+    that `words * 64 + shift` bits of source are readable.  */
+size_t copyShiftedWords(uint8_t* dst, const uint8_t* src, unsigned shift,
+                        size_t words) {
+  for (size_t i = 0; i < words; i++) {
+    uint64_t lo = load64Le(src);
+    uint64_t hi = src[8];
+    store64Le(dst, (lo >> shift) | (hi << (64 - shift)));
+    dst += 8;
+    src += 8;
+  }
+  return words;
+}
+
+#ifdef VELES_COPYBITS_X86
+
+/** SSE2 variant of copyShiftedWords: 128 bits per iteration.  Each iteration
+    reads 24 source octets.  Returns the number of 64-bit words copied, which
+    may be less than requested; the rest is left to the scalar loop.  */
+size_t copyShiftedWordsSse2(uint8_t* dst, const uint8_t* src, unsigned shift,
+                            size_t words) {
+  const __m128i right = _mm_cvtsi32_si128(static_cast<int>(shift));
+  const __m128i left = _mm_cvtsi32_si128(static_cast<int>(64 - shift));
+  size_t done = 0;
+  // One word of look-ahead is needed for the high part of the last lane.
+  for (; done + 3 <= words; done += 2) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+    __m128i res =
+        _mm_or_si128(_mm_srl_epi64(lo, right), _mm_sll_epi64(hi, left));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), res);
+    dst += 16;
+    src += 16;
+  }
+  return done;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VELES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VELES_TARGET_AVX2
+#endif
+
+/** AVX2 variant of copyShiftedWords: 256 bits per iteration.  Each iteration
+    reads 40 source octets.  */
+VELES_TARGET_AVX2 size_t copyShiftedWordsAvx2(uint8_t* dst, const uint8_t* src,
+                                              unsigned shift, size_t words) {
+  const __m128i right = _mm_cvtsi32_si128(static_cast<int>(shift));
+  const __m128i left = _mm_cvtsi32_si128(static_cast<int>(64 - shift));
+  size_t done = 0;
+  for (; done + 5 <= words; done += 4) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 8));
+    __m256i res = _mm256_or_si256(_mm256_srl_epi64(lo, right),
+                                  _mm256_sll_epi64(hi, left));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), res);
+    dst += 32;
+    src += 32;
+  }
+  return done;
+}
+
+bool cpuHasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  // OSXSAVE and AVX, then check the OS saves YMM state.
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 ||
+      (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return false;
+#endif
+}
+
+#endif  // VELES_COPYBITS_X86
+
+using ShiftedWordsKernel = size_t (*)(uint8_t*, const uint8_t*, unsigned,
+                                      size_t);
+
+/** Picks the widest kernel supported by the CPU we're running on.  */
+ShiftedWordsKernel selectShiftedWordsKernel() {
+#ifdef VELES_COPYBITS_X86
+  if (cpuHasAvx2()) {
+    return copyShiftedWordsAvx2;
+  }
+  return copyShiftedWordsSse2;
+#else
+  return copyShiftedWords;
+#endif
+}
+
+/** Below this many 64-bit words the vector kernels aren't worth a call.  */
+const size_t k_vector_min_words = 8;
+
+}  // namespace
+
 void BinData::copyBits(uint8_t* dst, unsigned dst_bit, const uint8_t* src,
                        unsigned src_bit, unsigned num_bits) {
   dst += dst_bit >> 3;
   src += src_bit >> 3;
   dst_bit &= 7;
   src_bit &= 7;
-  while (num_bits > 0) {
-    if (src_bit == 0 && dst_bit == 0 && num_bits >= 8) {
-      unsigned cur_bytes = num_bits >> 3;
-      memcpy(dst, src, cur_bytes);
-      dst += cur_bytes;
-      src += cur_bytes;
-      num_bits -= cur_bytes << 3;
-    } else {
-      unsigned cur_bits = std::min({8 - src_bit, 8 - dst_bit, num_bits});
-      uint8_t mask = (1 << cur_bits) - 1;
-      uint8_t bits = (*src >> src_bit) & mask;
-      *dst &= ~(mask << dst_bit);
-      *dst |= bits << dst_bit;
-      src_bit += cur_bits;
-      dst_bit += cur_bits;
-      num_bits -= cur_bits;
-      if (src_bit == 8) {
-        src++;
-        src_bit = 0;
-      }
-      if (dst_bit == 8) {
-        dst++;
-        dst_bit = 0;
-      }
+  if (src_bit == dst_bit) {
+    // Equal alignment - only the first and last octets need masking.
+    if (dst_bit != 0) {
+      size_t head = std::min<size_t>(8 - dst_bit, num_bits);
+      copyBitsSlow(dst, dst_bit, src, src_bit, head);
+      num_bits -= static_cast<unsigned>(head);
     }
+    size_t cur_bytes = num_bits >> 3;
+    memcpy(dst, src, cur_bytes);
+    dst += cur_bytes;
+    src += cur_bytes;
+    num_bits -= static_cast<unsigned>(cur_bytes << 3);
+    copyBitsSlow(dst, dst_bit, src, src_bit, num_bits);
+    return;
+  }
+
+  // Different alignment - first make the destination octet-aligned, then
+  // move whole words shifted by the remaining source bit offset.
+  if (dst_bit != 0) {
+    size_t head = std::min<size_t>(8 - dst_bit, num_bits);
+    copyBitsSlow(dst, dst_bit, src, src_bit, head);
+    num_bits -= static_cast<unsigned>(head);
+  }
+  if (src_bit == 0) {
+    size_t cur_bytes = num_bits >> 3;
+    memcpy(dst, src, cur_bytes);
+    dst += cur_bytes;
+    src += cur_bytes;
+    num_bits -= static_cast<unsigned>(cur_bytes << 3);
+  } else {
+    // The ninth octet read for each word holds src_bit bits which are still
+    // part of the copied range, so all reads stay within the source.
+    size_t words = num_bits / 64;
+    size_t done = 0;
+    if (words >= k_vector_min_words) {
+      static const ShiftedWordsKernel kernel = selectShiftedWordsKernel();
+      done = kernel(dst, src, src_bit, words);
+    }
+    done += copyShiftedWords(dst + done * 8, src + done * 8, src_bit,
+                             words - done);
+    dst += done * 8;
+    src += done * 8;
+    num_bits -= static_cast<unsigned>(done * 64);
+  }
+  copyBitsSlow(dst, dst_bit, src, src_bit, num_bits);
+}
+
+constexpr size_t BinData::k_map_min_size;
+
+bool BinData::mapFile(const QString& file_name, BinData* out) {
+  auto* file = new QFile(file_name);
+  if (!file->open(QIODevice::ReadOnly)) {
+    delete file;
+    return false;
+  }
+  auto size = static_cast<size_t>(file->size());
+  if (size == 0) {
+    delete file;
+    *out = BinData(8, 0);
+    return true;
+  }
+  // Small files are cheaper to read than to map, and a copy can't fault if
+  // the file is truncated later.
+  const uint8_t* mapped =
+      size >= k_map_min_size ? file->map(0, file->size()) : nullptr;
+  if (mapped != nullptr) {
+    // The mapping lives as long as the QFile.
+    *out = fromExternal(8, size, mapped, [file]() { delete file; });
+    return true;
+  }
+  // Small or not mappable (eg. a pipe or a special file), read it instead.
+  QByteArray bytes = file->readAll();
+  delete file;
+  if (static_cast<size_t>(bytes.size()) != size) {
+    return false;
   }
+  *out = BinData(8, size, reinterpret_cast<const uint8_t*>(bytes.data()));
+  return true;
 }
 
 QString BinData::toString(size_t maxElements) {
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "data/bindata_builder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace veles {
+namespace data {
+
+namespace {
+
+/** Minimal number of elements allocated on first growth.  */
+const size_t k_min_capacity = 16;
+
+}  // namespace
+
+BinDataBuilder::BinDataBuilder(uint32_t width, size_t reserve_elements)
+    : width_(width), octets_per_element_((width + 7) / 8) {
+  assert(width != 0);
+  if (reserve_elements > 0) {
+    reserve(reserve_elements);
+  }
+}
+
+BinDataBuilder::BinDataBuilder(BinDataBuilder&& other) noexcept
+    : width_(other.width_),
+      octets_per_element_(other.octets_per_element_),
+      size_(other.size_),
+      capacity_(other.capacity_),
+      bit_pos_(other.bit_pos_),
+      storage_(other.storage_) {
+  other.size_ = 0;
+  other.capacity_ = 0;
+  other.bit_pos_ = 0;
+  other.storage_ = nullptr;
+}
+
+BinDataBuilder& BinDataBuilder::operator=(BinDataBuilder&& other) noexcept {
+  if (this != &other) {
+    if (storage_ != nullptr) {
+      storage_->unref();
+    }
+    width_ = other.width_;
+    octets_per_element_ = other.octets_per_element_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    bit_pos_ = other.bit_pos_;
+    storage_ = other.storage_;
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.bit_pos_ = 0;
+    other.storage_ = nullptr;
+  }
+  return *this;
+}
+
+BinDataBuilder::~BinDataBuilder() {
+  if (storage_ != nullptr) {
+    storage_->unref();
+  }
+}
+
+void BinDataBuilder::reserve(size_t num_elements) {
+  if (num_elements <= capacity_) {
+    return;
+  }
+  size_t octets = num_elements * octets_per_element_;
+  assert(octets / octets_per_element_ == num_elements);
+  BinData::Storage* storage = BinData::Storage::create(octets);
+  if (storage_ != nullptr) {
+    // Include the partial element, if any.
+    size_t used = std::min(size_ + 1, capacity_) * octets_per_element_;
+    memcpy(storage->data(), storage_->data(), used);
+    storage_->unref();
+  }
+  storage_ = storage;
+  capacity_ = num_elements;
+}
+
+uint8_t* BinDataBuilder::grow(size_t num_elements) {
+  if (bit_pos_ != 0) {
+    // Pad the partial element with zero bits.  appendBits() made sure it
+    // fits, and it is already zeroed past bit_pos_.
+    size_++;
+    bit_pos_ = 0;
+  }
+  size_t needed = size_ + num_elements;
+  if (needed > capacity_) {
+    reserve(std::max(needed, std::max(k_min_capacity, capacity_ * 2)));
+  }
+  uint8_t* res = storage_->data() + size_ * octets_per_element_;
+  size_ = needed;
+  return res;
+}
+
+void BinDataBuilder::append(const BinData& data) {
+  assert(data.width() == width_);
+  if (data.size() > 0) {
+    memcpy(grow(data.size()), data.rawData(), data.octets());
+  }
+}
+
+void BinDataBuilder::appendRaw(const uint8_t* data, size_t num_elements) {
+  if (num_elements > 0) {
+    memcpy(grow(num_elements), data, num_elements * octets_per_element_);
+  }
+}
+
+void BinDataBuilder::appendElement64(uint64_t val) {
+  assert(width_ <= 64);
+  uint8_t* dst = grow(1);
+  for (unsigned i = 0; i < octets_per_element_; i++) {
+    dst[i] = static_cast<uint8_t>(val >> (8 * i));
+  }
+}
+
+void BinDataBuilder::appendBits(const uint8_t* src, unsigned src_bit,
+                                size_t num_bits) {
+  while (num_bits > 0) {
+    if (bit_pos_ == 0) {
+      // Start a new, zeroed element.  It is not counted in size_ until
+      // complete.
+      if (size_ == capacity_) {
+        reserve(std::max(size_ + 1, std::max(k_min_capacity, capacity_ * 2)));
+      }
+      memset(storage_->data() + size_ * octets_per_element_, 0,
+             octets_per_element_);
+    }
+    size_t chunk = std::min<size_t>(num_bits, width_ - bit_pos_);
+    BinData::copyBits(storage_->data() + size_ * octets_per_element_,
+                      bit_pos_, src, src_bit, static_cast<unsigned>(chunk));
+    src += (src_bit + chunk) / 8;
+    src_bit = (src_bit + chunk) % 8;
+    num_bits -= chunk;
+    bit_pos_ += static_cast<unsigned>(chunk);
+    if (bit_pos_ == width_) {
+      bit_pos_ = 0;
+      size_++;
+    }
+  }
+}
+
+void BinDataBuilder::appendBits64(uint64_t bits, unsigned num_bits) {
+  assert(num_bits <= 64);
+  uint8_t octets[8];
+  for (int i = 0; i < 8; i++) {
+    octets[i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  appendBits(octets, 0, num_bits);
+}
+
+BinData BinDataBuilder::finish() {
+  size_t size = size_ + (bit_pos_ != 0 ? 1 : 0);
+  BinData::Storage* storage = storage_;
+  storage_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+  bit_pos_ = 0;
+  if (storage == nullptr) {
+    return BinData(width_, 0);
+  }
+  return BinData(width_, size, storage);
+}
+
+}  // namespace data
+}  // namespace veles
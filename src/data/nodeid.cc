@@ -81,9 +81,31 @@ NodeID::operator bool() const {
 std::size_t NodeIDHash::operator()(const NodeID& id) const {
   static_assert(sizeof(std::size_t) <= NodeID::WIDTH, "Wrong NodeID::WIDTH");
   std::size_t hash;
-  memcpy(&hash, id.asStdVector().data(), sizeof(std::size_t));
+  memcpy(&hash, id.value, sizeof(std::size_t));
   return hash;
 }
 
+NodeHandle NodeIDTable::intern(const NodeID& id) {
+  auto res = indices_.emplace(id, static_cast<uint32_t>(ids_.size()));
+  if (res.second) {
+    assert(ids_.size() < NodeHandle::INVALID_INDEX);
+    ids_.push_back(id);
+  }
+  return NodeHandle(res.first->second);
+}
+
+NodeHandle NodeIDTable::find(const NodeID& id) const {
+  auto it = indices_.find(id);
+  if (it == indices_.end()) {
+    return NodeHandle();
+  }
+  return NodeHandle(it->second);
+}
+
+const NodeID& NodeIDTable::id(NodeHandle handle) const {
+  assert(handle.index() < ids_.size());
+  return ids_[handle.index()];
+}
+
 }  // namespace data
 }  // namespace veles
@@ -16,7 +16,9 @@
  */
 #include "data/repack.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 #include "util/math.h"
 
@@ -25,6 +27,103 @@ using veles::util::math::gcd;
 namespace veles {
 namespace data {
 
+namespace {
+
+/*****************************************************************************/
+/* Specialized repacking kernels */
+/*****************************************************************************/
+
+// The kernels below handle the common unpadded formats without going
+// through the bit-granular workspace.
+
+#if defined(__GNUC__)
+inline uint16_t byteSwap(uint16_t val) { return __builtin_bswap16(val); }
+inline uint32_t byteSwap(uint32_t val) { return __builtin_bswap32(val); }
+inline uint64_t byteSwap(uint64_t val) { return __builtin_bswap64(val); }
+#elif defined(_MSC_VER)
+inline uint16_t byteSwap(uint16_t val) { return _byteswap_ushort(val); }
+inline uint32_t byteSwap(uint32_t val) { return _byteswap_ulong(val); }
+inline uint64_t byteSwap(uint64_t val) { return _byteswap_uint64(val); }
+#else
+template <typename T>
+inline T byteSwap(T val) {
+  T res = 0;
+  for (unsigned i = 0; i < sizeof(T); i++) {
+    res = static_cast<T>(res << 8) | static_cast<uint8_t>(val >> (8 * i));
+  }
+  return res;
+}
+#endif
+
+/** Reverses the order of octets in each consecutive group of sizeof(T)
+    octets.  This is big-endian repacking between 8 and 8*sizeof(T) bit
+    elements, in either direction.  */
+template <typename T>
+void reverseOctetGroups(const uint8_t* src, uint8_t* dst, size_t groups) {
+  // memcpy is the portable unaligned access, compiled to a plain load.
+  for (size_t i = 0; i < groups; i++) {
+    T val;
+    memcpy(&val, src + i * sizeof(T), sizeof(T));
+    val = byteSwap(val);
+    memcpy(dst + i * sizeof(T), &val, sizeof(T));
+  }
+}
+
+/** Splits octets into Bits-wide elements (Bits divides 8).  For BIG endian
+    the most significant bits of an octet come first.  */
+template <unsigned Bits, bool Big>
+void splitOctets(const uint8_t* src, uint8_t* dst, size_t num_elements) {
+  const unsigned per_octet = 8 / Bits;
+  const uint8_t mask = (1u << Bits) - 1;
+  size_t whole = num_elements / per_octet;
+  for (size_t i = 0; i < whole; i++) {
+    uint8_t octet = src[i];
+    for (unsigned j = 0; j < per_octet; j++) {
+      unsigned shift = Big ? 8 - Bits - j * Bits : j * Bits;
+      dst[i * per_octet + j] = (octet >> shift) & mask;
+    }
+  }
+  for (unsigned j = 0; j < num_elements % per_octet; j++) {
+    unsigned shift = Big ? 8 - Bits - j * Bits : j * Bits;
+    dst[whole * per_octet + j] = (src[whole] >> shift) & mask;
+  }
+}
+
+using RepackKernel = void (*)(const uint8_t*, uint8_t*, size_t);
+
+/** Returns a kernel splitting octets into to_width-bit elements, or nullptr
+    if there is none.  */
+RepackKernel findSplitKernel(Endian endian, uint64_t to_width) {
+  bool big = endian == Endian::BIG;
+  switch (to_width) {
+    case 1:
+      return big ? splitOctets<1, true> : splitOctets<1, false>;
+    case 2:
+      return big ? splitOctets<2, true> : splitOctets<2, false>;
+    case 4:
+      return big ? splitOctets<4, true> : splitOctets<4, false>;
+    default:
+      return nullptr;
+  }
+}
+
+/** Returns a kernel reversing octets within group_width-bit groups, or
+    nullptr if there is none.  */
+RepackKernel findReverseKernel(uint64_t group_width) {
+  switch (group_width) {
+    case 16:
+      return reverseOctetGroups<uint16_t>;
+    case 32:
+      return reverseOctetGroups<uint32_t>;
+    case 64:
+      return reverseOctetGroups<uint64_t>;
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace
+
 unsigned Repacker::repackUnit() const {
   unsigned res = paddedWidth() / gcd(paddedWidth(), from_width) * from_width;
   // Ensure no overflow.
@@ -44,18 +143,94 @@ size_t Repacker::repackableSize(size_t src_size) const {
   return bits / paddedWidth();
 }
 
+bool Repacker::repackFast(const BinData& src, size_t start,
+                          size_t num_elements, uint8_t* dst) const {
+  if (high_pad != 0 || low_pad != 0) {
+    return false;
+  }
+  const uint8_t* src_data = src.rawData(start);
+  if (from_width % 8 == 0 && to_width % 8 == 0) {
+    // Elements are whole octets.
+    size_t octets = num_elements * (to_width / 8);
+    if (endian == Endian::LITTLE || from_width == to_width) {
+      memcpy(dst, src_data, octets);
+      return true;
+    }
+    uint64_t group_width = 0;
+    if (from_width == 8) {
+      group_width = to_width;
+    } else if (to_width == 8) {
+      group_width = from_width;
+    }
+    RepackKernel kernel = findReverseKernel(group_width);
+    if (kernel == nullptr) {
+      return false;
+    }
+    size_t group_octets = group_width / 8;
+    size_t groups = octets / group_octets;
+    kernel(src_data, dst, groups);
+    // The last group may be only partially extracted.
+    size_t tail = groups * group_octets;
+    for (size_t i = tail; i < octets; i++) {
+      dst[i] = src_data[tail + group_octets - 1 - (i - tail)];
+    }
+    return true;
+  }
+  if (from_width == 8) {
+    RepackKernel kernel = findSplitKernel(endian, to_width);
+    if (kernel == nullptr) {
+      return false;
+    }
+    kernel(src_data, dst, num_elements);
+    return true;
+  }
+  return false;
+}
+
 BinData Repacker::repack(const BinData& src, size_t start,
                          size_t num_elements) const {
-  unsigned repack_unit = repackUnit();
-  unsigned src_per_unit = repack_unit / from_width;
-  unsigned dst_per_unit = repack_unit / paddedWidth();
   assert(src.width() == from_width);
-  BinData workspace(repack_unit, 1);
   assert(start <= src.size());
   num_elements = std::min(num_elements, repackableSize(src.size() - start));
+  if (from_width == to_width && high_pad == 0 && low_pad == 0) {
+    // Nothing to do, share the source storage.
+    return src.data(start, num_elements);
+  }
   BinData res(to_width, num_elements);
+  repackInto(src, start, num_elements, &res, 0);
+  return res;
+}
+
+size_t Repacker::repackInto(const BinData& src, size_t start,
+                            size_t num_elements, BinData* dst,
+                            size_t dst_pos) const {
+  assert(src.width() == from_width);
+  assert(dst->width() == to_width);
+  assert(start <= src.size());
+  num_elements = std::min(num_elements, repackableSize(src.size() - start));
+  assert(dst_pos + num_elements <= dst->size());
+  if (num_elements == 0) {
+    return 0;
+  }
+  uint8_t* dst_data = dst->rawData(dst_pos);
+  if (!repackFast(src, start, num_elements, dst_data)) {
+    repackGeneric(src, start, num_elements, dst_data);
+  }
+  return num_elements;
+}
+
+void Repacker::repackGeneric(const BinData& src, size_t start,
+                             size_t num_elements, uint8_t* dst) const {
+  unsigned repack_unit = repackUnit();
+  unsigned src_per_unit = repack_unit / from_width;
+  unsigned dst_per_unit = repack_unit / paddedWidth();
+  size_t dst_octets = (to_width + 7) / 8;
+  BinData workspace(repack_unit, 1);
   size_t src_end = start + repackSize(num_elements);
   assert(src_end <= src.size());
+  // copyBits() leaves the unused high bits of destination elements alone,
+  // and they may hold garbage in caller-provided buffers.
+  memset(dst, 0, num_elements * dst_octets);
   for (size_t dst_pos = 0, src_pos = start; dst_pos < num_elements;) {
     for (unsigned i = 0; i < src_per_unit && src_pos < src_end;
          i++, src_pos++) {
@@ -86,12 +261,95 @@ BinData Repacker::repack(const BinData& src, size_t start,
         default:
           abort();
       }
-      BinData::copyBits(res.rawData(dst_pos), 0, workspace.rawData(), work_pos,
-                        to_width);
+      BinData::copyBits(dst + dst_pos * dst_octets, 0, workspace.rawData(),
+                        work_pos, to_width);
     }
   }
-  return res;
 }
 
+/*****************************************************************************/
+/* StreamRepacker */
+/*****************************************************************************/
+
+const size_t StreamRepacker::k_max_batch_elements;
+
+StreamRepacker::StreamRepacker(const Repacker& format)
+    : format_(format),
+      src_per_unit_(format.repackUnit() / format.from_width),
+      dst_per_unit_(format.repackUnit() / format.paddedWidth()),
+      carry_(format.from_width, 0) {}
+
+size_t StreamRepacker::outputSize(size_t src_size) const {
+  return (carry_.size() + src_size) / src_per_unit_ * dst_per_unit_;
+}
+
+size_t StreamRepacker::push(const BinData& chunk, BinData* dst,
+                            size_t dst_pos) {
+  assert(chunk.width() == format_.from_width);
+  assert(dst_pos + outputSize(chunk.size()) <= dst->size());
+  size_t written = 0;
+  size_t pos = 0;
+  if (carry_.size() > 0) {
+    // Complete the repack unit left over from the previous chunk.
+    pos = std::min(src_per_unit_ - carry_.size(), chunk.size());
+    carry_ = carry_ + chunk.data(0, pos);
+    if (carry_.size() < src_per_unit_) {
+      return 0;
+    }
+    written += format_.repackInto(carry_, 0, dst_per_unit_, dst, dst_pos);
+    carry_ = BinData(format_.from_width, 0);
+  }
+  size_t units = (chunk.size() - pos) / src_per_unit_;
+  written += format_.repackInto(chunk, pos, units * dst_per_unit_, dst,
+                                dst_pos + written);
+  pos += units * src_per_unit_;
+  // Deep copy, so that the carry does not keep the whole chunk alive.
+  carry_ = BinData(format_.from_width, chunk.size() - pos,
+                   chunk.size() > pos ? chunk.rawData(pos) : nullptr);
+  return written;
+}
+
+void StreamRepacker::push(const BinData& chunk, const Sink& sink) {
+  assert(chunk.width() == format_.from_width);
+  // Bound the temporary output buffer by repacking large chunks in batches
+  // of whole units.
+  size_t batch_units =
+      std::max<size_t>(1, k_max_batch_elements / dst_per_unit_);
+  size_t batch = batch_units * src_per_unit_;
+  BinData buf(format_.to_width, 0);
+  for (size_t pos = 0; pos < chunk.size(); pos += batch) {
+    BinData part = chunk.data(pos, std::min(batch, chunk.size() - pos));
+    size_t out_size = outputSize(part.size());
+    if (buf.size() < out_size) {
+      buf = BinData(format_.to_width, out_size);
+    }
+    size_t written = push(part, &buf, 0);
+    if (written > 0) {
+      sink(buf.data(0, written));
+    }
+  }
+}
+
+size_t StreamRepacker::finishSize() const {
+  return format_.repackableSize(carry_.size());
+}
+
+size_t StreamRepacker::finish(BinData* dst, size_t dst_pos) {
+  size_t written =
+      format_.repackInto(carry_, 0, finishSize(), dst, dst_pos);
+  reset();
+  return written;
+}
+
+void StreamRepacker::finish(const Sink& sink) {
+  BinData res = format_.repack(carry_, 0, finishSize());
+  reset();
+  if (res.size() > 0) {
+    sink(res);
+  }
+}
+
+void StreamRepacker::reset() { carry_ = BinData(format_.from_width, 0); }
+
 }  // namespace data
 }  // namespace veles
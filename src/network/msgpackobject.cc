@@ -485,10 +485,11 @@ std::shared_ptr<MsgpackObject> toMsgpackObject(
 
 std::shared_ptr<MsgpackObject> toMsgpackObject(
     const std::shared_ptr<data::BinData>& val_ptr) {
+  const data::BinData& bindata = *val_ptr;
   auto data = std::make_shared<std::vector<uint8_t>>(4, 0);
-  util::intToBytesLe(val_ptr->width(), 4, data->data());
-  data->insert(data->end(), val_ptr->rawData(),
-               val_ptr->rawData() + val_ptr->octets());
+  util::intToBytesLe(bindata.width(), 4, data->data());
+  data->insert(data->end(), bindata.rawData(),
+               bindata.rawData() + bindata.octets());
   return std::make_shared<MsgpackObject>(static_cast<int>(proto::EXT_BINDATA),
                                          data);
 }
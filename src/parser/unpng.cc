@@ -21,22 +21,23 @@
 
 #include <zlib.h>
 
+#include "data/bindata_builder.h"
 #include "parser/stream.h"
 #include "parser/utils.h"
 
 namespace veles {
 namespace parser {
 
-std::vector<uint8_t> do_inflate(const std::vector<uint8_t>& d) {
-  std::vector<uint8_t> res;
+data::BinData do_inflate(const data::BinData& d) {
+  data::BinDataBuilder res(8);
   z_stream strm;
   strm.zalloc = Z_NULL;
   strm.zfree = Z_NULL;
   strm.opaque = Z_NULL;
   strm.avail_in = static_cast<uInt>(d.size());
-  strm.next_in = const_cast<uint8_t*>(d.data());
+  strm.next_in = const_cast<uint8_t*>(d.rawData());
   if (inflateInit(&strm) != Z_OK) {
-    return res;
+    return data::BinData(8, 0);
   }
   const unsigned BUFSZ = 0x4000;
   uint8_t buf[BUFSZ];
@@ -51,17 +52,17 @@ std::vector<uint8_t> do_inflate(const std::vector<uint8_t>& d) {
       case Z_NEED_DICT:
         // :(
         inflateEnd(&strm);
-        return std::vector<uint8_t>();
+        return data::BinData(8, 0);
     }
-    res.insert(res.end(), buf, buf + BUFSZ - strm.avail_out);
+    res.appendRaw(buf, BUFSZ - strm.avail_out);
     if (ret == Z_STREAM_END) {
       inflateEnd(&strm);
-      return res;
+      return res.finish();
     }
     if (strm.avail_out > 0) {
       // buffer not completely filled, but we have no more input stream - oops.
       inflateEnd(&strm);
-      return std::vector<uint8_t>();
+      return data::BinData(8, 0);
     }
   }
 }
@@ -73,7 +74,7 @@ void unpngFileBlob(const dbif::ObjectHandle& blob, uint64_t start,
   parser.startChunk("png_header", "header");
   parser.getBytes("sig", 8);
   parser.endChunk();
-  std::vector<uint8_t> jointIdats;
+  data::BinDataBuilder idats_builder(8);
   for (unsigned idx = 0; !parser.eof(); idx++) {
     parser.startChunk("png_chunk", QString("chunks[%1]").arg(idx));
     uint32_t len = parser.getBe32("length");
@@ -82,19 +83,18 @@ void unpngFileBlob(const dbif::ObjectHandle& blob, uint64_t start,
     parser.getBe32("crc32");
     parser.endChunk();
     if (type[0] == 'I' && type[1] == 'D' && type[2] == 'A' && type[3] == 'T') {
-      jointIdats.insert(jointIdats.end(), d.begin(), d.end());
+      idats_builder.appendRaw(d.data(), d.size());
     }
     if (type[0] == 'I' && type[1] == 'E' && type[2] == 'N' && type[3] == 'D') {
       break;
     }
   }
   auto png = parser.endChunk();
-  makeSubBlob(png, "deflated_data",
-              data::BinData(8, jointIdats.size(), jointIdats.data()));
-  auto decompressed = do_inflate(jointIdats);
-  if (!decompressed.empty()) {
-    makeSubBlob(png, "inflated_data",
-                data::BinData(8, decompressed.size(), decompressed.data()));
+  data::BinData joint_idats = idats_builder.finish();
+  makeSubBlob(png, "deflated_data", joint_idats);
+  auto decompressed = do_inflate(joint_idats);
+  if (decompressed.size() != 0) {
+    makeSubBlob(png, "inflated_data", decompressed);
   }
 }
 
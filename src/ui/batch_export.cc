@@ -0,0 +1,216 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "ui/batch_export.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QColor>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include "util/sampling/data_source.h"
+#include "util/sampling/sample_stats.h"
+#include "util/sampling/uniform_sampler.h"
+#include "util/settings/visualization.h"
+#include "util/version.h"
+#include "visualization/image_renderer.h"
+#include "visualization/minimap.h"
+#include "visualization/trigram.h"
+
+namespace veles {
+namespace ui {
+
+namespace {
+
+using visualization::VisualizationMinimap;
+
+// Same as the minimap sample size of VisualizationPanel.
+const size_t k_minimap_sample_size = 4 * 1024 * 1024;
+
+struct ExportOptions {
+  QDir directory;
+  int size;
+  size_t sample_size;
+  // -1 to use TrigramWidget::suggestBrightness().
+  int brightness;
+  QColor color_begin;
+  QColor color_end;
+};
+
+/** Render images of one file and write them to the export directory.  */
+bool exportFile(const QString& path, const ExportOptions& options,
+                QString* error) {
+  auto source = std::make_shared<util::MappedFileDataSource>(path);
+  if (!source->isOpen()) {
+    *error = QObject::tr("can't open the file");
+    return false;
+  }
+  if (source->size() == 0) {
+    *error = QObject::tr("the file is empty");
+    return false;
+  }
+
+  util::UniformSampler sampler(source);
+  sampler.setSampleSize(options.sample_size);
+  auto snapshot = sampler.snapshot();
+  // Bytes for the brightness, digrams for the digram.
+  util::SampleStats stats(2);
+  stats.update(snapshot);
+
+  util::UniformSampler minimap_sampler(source);
+  minimap_sampler.setSampleSize(k_minimap_sample_size);
+  auto minimap_snapshot = minimap_sampler.snapshot();
+
+  int brightness = options.brightness;
+  if (brightness < 0) {
+    brightness = visualization::TrigramWidget::suggestBrightness(
+        stats.stats().bytes(), stats.stats().size());
+  }
+  // Minimap strips are tall and narrow, like the minimap.
+  int strip_width = std::max(1, options.size / 4);
+
+  std::vector<std::pair<QString, QImage>> images;
+  images.emplace_back(".digram.png",
+                      visualization::renderDigram(stats).scaled(
+                          options.size, options.size, Qt::IgnoreAspectRatio,
+                          Qt::FastTransformation));
+  images.emplace_back(
+      ".trigram.png",
+      visualization::renderTrigram(*snapshot, options.size, brightness,
+                                   options.color_begin, options.color_end));
+  images.emplace_back(".minimap-value.png",
+                      visualization::renderMinimap(
+                          *minimap_snapshot,
+                          VisualizationMinimap::MinimapMode::VALUE,
+                          VisualizationMinimap::MinimapColor::GREEN,
+                          strip_width, options.size));
+  images.emplace_back(".minimap-entropy.png",
+                      visualization::renderMinimap(
+                          *minimap_snapshot,
+                          VisualizationMinimap::MinimapMode::ENTROPY,
+                          VisualizationMinimap::MinimapColor::GREEN,
+                          strip_width, options.size));
+
+  QString base = options.directory.filePath(QFileInfo(path).fileName());
+  for (const auto& image : images) {
+    if (!image.second.save(base + image.first, "PNG")) {
+      *error = QObject::tr("can't write %1").arg(base + image.first);
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool batchExportRequested(int argc, char* argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--export") == 0 ||
+        std::strncmp(argv[i], "--export=", std::strlen("--export=")) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int runBatchExport(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("Veles");
+  QCoreApplication::setOrganizationName("CodiSec");
+  QCoreApplication::setApplicationVersion(util::version::string);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      QObject::tr("Renders visualizations of files to PNG images."));
+  parser.addHelpOption();
+  parser.addVersionOption();
+  QCommandLineOption export_option(
+      "export", QObject::tr("Write images of the files to <directory>."),
+      QObject::tr("directory"));
+  QCommandLineOption size_option(
+      "export-size", QObject::tr("Size of the images in pixels."),
+      QObject::tr("pixels"), "512");
+  QCommandLineOption sample_size_option(
+      "sample-size",
+      QObject::tr("Number of bytes sampled from each file for the digram "
+                  "and the trigram."),
+      QObject::tr("bytes"), QString::number(1024 * 1024));
+  parser.addOption(export_option);
+  parser.addOption(size_option);
+  parser.addOption(sample_size_option);
+  parser.addPositionalArgument("files", QObject::tr("Files to render."),
+                               QObject::tr("<files...>"));
+  parser.process(app);
+
+  QTextStream err(stderr);
+  auto report = [&err](const QString& message) {
+    err << message << '\n';
+    err.flush();
+  };
+  ExportOptions options;
+  bool size_ok, sample_size_ok;
+  options.size = parser.value(size_option).toInt(&size_ok);
+  options.sample_size = parser.value(sample_size_option).toULongLong(
+      &sample_size_ok);
+  if (!size_ok || options.size <= 0 || !sample_size_ok ||
+      options.sample_size == 0) {
+    report(QObject::tr("Image and sample sizes must be positive numbers."));
+    return 1;
+  }
+  options.directory = QDir(parser.value(export_option));
+  if (!options.directory.mkpath(".")) {
+    report(QObject::tr("Can't create directory %1.")
+               .arg(parser.value(export_option)));
+    return 1;
+  }
+  options.brightness = util::settings::visualization::autoBrightness()
+                           ? -1
+                           : util::settings::visualization::brightness();
+  options.color_begin = util::settings::visualization::colorBegin();
+  options.color_end = util::settings::visualization::colorEnd();
+
+  const QStringList files = parser.positionalArguments();
+  if (files.isEmpty()) {
+    report(QObject::tr("No files to render."));
+    return 1;
+  }
+  // One file after another - rendering a file already runs the samplers
+  // and the texture calculations in parallel.
+  int failed = 0;
+  for (const QString& file : files) {
+    QString error;
+    if (!exportFile(file, options, &error)) {
+      report(file + ": " + error);
+      ++failed;
+    }
+  }
+  return failed == 0 ? 0 : 1;
+}
+
+}  // namespace ui
+}  // namespace veles
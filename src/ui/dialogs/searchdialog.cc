@@ -16,11 +16,32 @@
  */
 #include "ui/dialogs/searchdialog.h"
 
+#include <vector>
+
+#include "data/bindata_view.h"
 #include "ui_searchdialog.h"
 
 namespace veles {
 namespace ui {
 
+namespace {
+
+/** Reads all pattern elements up front, so that the search loops don't
+    go through BinData::element64() on every comparison.  */
+std::vector<uint64_t> patternValues(const data::BinData& pattern) {
+  if (data::BinDataView<uint8_t>::isCompatible(pattern)) {
+    data::BinDataView<uint8_t> view(pattern);
+    return std::vector<uint64_t>(view.begin(), view.end());
+  }
+  std::vector<uint64_t> res(pattern.size());
+  for (size_t i = 0; i < pattern.size(); i++) {
+    res[i] = pattern.element64(i);
+  }
+  return res;
+}
+
+}  // namespace
+
 SearchDialog::SearchDialog(HexEdit* hexEdit, QWidget* parent)
     : QDialog(parent),
       ui(new Ui::SearchDialog),
@@ -71,6 +92,7 @@ SearchDialog::~SearchDialog() { delete ui; }
 qint64 SearchDialog::indexOf(const data::BinData& pattern, qint64 startPos) {
   // TODO(mwk): implement this as BinData method or as separate util
   const data::BinData& data = _hexEdit->dataModel()->binData();
+  std::vector<uint64_t> pattern_values = patternValues(pattern);
   if (startPos == -1) {
     startPos = 0;
   }
@@ -79,7 +101,7 @@ qint64 SearchDialog::indexOf(const data::BinData& pattern, qint64 startPos) {
     size_t numberOfMatches = 0;
     while (numberOfMatches < pattern.size() &&
            numberOfMatches + index < data.size() &&
-           pattern.element64(numberOfMatches) ==
+           pattern_values[numberOfMatches] ==
                _hexEdit->byteValue(index + numberOfMatches)) {
       ++numberOfMatches;
     }
@@ -98,6 +120,7 @@ qint64 SearchDialog::lastIndexOf(const data::BinData& pattern,
                                  qint64 startPos) {
   // TODO(mwk): implement this as BinData method or as separate util
   const data::BinData& data = _hexEdit->dataModel()->binData();
+  std::vector<uint64_t> pattern_values = patternValues(pattern);
   if (startPos == -1) {
     startPos = data.size();
   }
@@ -106,7 +129,7 @@ qint64 SearchDialog::lastIndexOf(const data::BinData& pattern,
     size_t numberOfMatches = 0;
     while (numberOfMatches < pattern.size() &&
            numberOfMatches + index < data.size() &&
-           pattern.element64(numberOfMatches) ==
+           pattern_values[numberOfMatches] ==
                _hexEdit->byteValue(index + numberOfMatches)) {
       ++numberOfMatches;
     }
@@ -16,6 +16,8 @@
  */
 #include "ui/fileblobmodel.h"
 
+#include <algorithm>
+
 #include <QColor>
 #include <QFont>
 #include <QSize>
@@ -29,6 +31,8 @@
 namespace veles {
 namespace ui {
 
+const uint64_t FileBlobModel::BYTES_REQUEST_SIZE;
+
 QColor FileBlobModel::color(int colorIndex) const {
   return util::settings::theme::chunkBackground(colorIndex);
 }
@@ -96,9 +100,10 @@ FileBlobModel::FileBlobModel(const dbif::ObjectHandle& fileBlob,
                              const QStringList& path, QObject* parent)
     : QAbstractItemModel(parent),
       fileBlob_(fileBlob),
-      bytesPromise_(nullptr),
+      bytesMissing_(0),
       bytesCount_(0),
       path_(path) {
+  resetSamples();
   item_ = new RootFileBlobItem(fileBlob, this);
 
   connect(item_, &FileBlobItem::removingChildren,
@@ -131,23 +136,86 @@ FileBlobModel::FileBlobModel(const dbif::ObjectHandle& fileBlob,
           &FileBlobModel::gotDescriptionResponse);
 }
 
-void FileBlobModel::gotBytesResponse(const veles::dbif::PInfoReply& reply) {
+void FileBlobModel::gotBytesResponse(uint64_t start,
+                                     const veles::dbif::PInfoReply& reply) {
   if (auto bytesReply = reply.dynamicCast<dbif::BlobDataRequest::ReplyType>()) {
-    binData_ = bytesReply->data;
-    emit newBinData();
+    const data::BinData& data = bytesReply->data;
+    uint64_t part_size =
+        std::min<uint64_t>(BYTES_REQUEST_SIZE, bytesCount_ - start);
+    if (data.width() != binData_.width() || data.size() != part_size) {
+      return;
+    }
+    if (partialBinData_ == nullptr) {
+      // A part changed after all of them arrived.
+      binData_.setData(start, data.size(), data);
+      resetSamples();
+    } else {
+      unsigned octets = data.octetsPerElement();
+      partialBinData_->write(start * octets,
+                             reinterpret_cast<const char*>(data.rawData()),
+                             data.size() * octets);
+      size_t part = start / BYTES_REQUEST_SIZE;
+      if (!bytesReceived_[part]) {
+        bytesReceived_[part] = true;
+        --bytesMissing_;
+      }
+      if (bytesMissing_ == 0) {
+        // The parts are already laid out like BinData elements, so the
+        // complete data just takes over their buffer.
+        auto partial = std::move(partialBinData_);
+        binData_ = data::BinData::fromExternal(
+            binData_.width(), bytesCount_,
+            reinterpret_cast<const uint8_t*>(partial->contiguousData()),
+            [partial]() {});
+        resetSamples();
+      }
+    }
+    emit binDataReceived(start, start + data.size());
+    if (bytesMissing_ == 0) {
+      emit newBinData();
+    }
   }
 }
 
+void FileBlobModel::resetSamples() {
+  binDataSource_ = std::make_shared<util::BinDataSource>(binData_);
+  sampleCache_ = std::make_shared<util::SampleCache>();
+}
+
 void FileBlobModel::gotDescriptionResponse(
     const veles::dbif::PInfoReply& reply) {
   if (auto description = reply.dynamicCast<dbif::BlobDescriptionReply>()) {
     if (bytesCount_ != description->size) {
       bytesCount_ = description->size;
-      delete bytesPromise_;
-      bytesPromise_ =
-          fileBlob_->asyncSubInfo<dbif::BlobDataRequest>(this, 0, bytesCount_);
-      connect(bytesPromise_, &dbif::InfoPromise::gotInfo, this,
-              &FileBlobModel::gotBytesResponse);
+      for (auto* promise : bytesPromises_) {
+        delete promise;
+      }
+      bytesPromises_.clear();
+      binData_ = data::BinData(static_cast<uint32_t>(description->width), 0);
+      resetSamples();
+      size_t parts =
+          (bytesCount_ + BYTES_REQUEST_SIZE - 1) / BYTES_REQUEST_SIZE;
+      bytesReceived_.assign(parts, false);
+      bytesMissing_ = parts;
+      if (parts == 0) {
+        partialBinData_ = nullptr;
+        emit newBinData();
+      } else {
+        partialBinData_ = std::make_shared<util::ProgressiveDataSource>(
+            bytesCount_ * binData_.octetsPerElement());
+      }
+      for (uint64_t start = 0; start < bytesCount_;
+           start += BYTES_REQUEST_SIZE) {
+        uint64_t end = std::min<uint64_t>(start + BYTES_REQUEST_SIZE,
+                                          bytesCount_);
+        auto* promise =
+            fileBlob_->asyncSubInfo<dbif::BlobDataRequest>(this, start, end);
+        connect(promise, &dbif::InfoPromise::gotInfo, this,
+                [this, start](const veles::dbif::PInfoReply& reply) {
+                  gotBytesResponse(start, reply);
+                });
+        bytesPromises_.push_back(promise);
+      }
     }
   }
 }
@@ -26,6 +26,8 @@
 #include <QPainter>
 #include <QScrollBar>
 
+#include "data/bindata_builder.h"
+#include "data/bindata_view.h"
 #include "ui/velesapplication.h"
 #include "util/encoders/factory.h"
 #include "util/misc.h"
@@ -800,6 +802,8 @@ void HexEdit::paintEvent(QPaintEvent* event) {
       edit_engine_.bytesValues(start_byte, size_to_paint);
   std::vector<bool> modified_positions =
       edit_engine_.modifiedPositions(start_byte, size_to_paint);
+  // Octet-sized elements are read directly instead of through element64().
+  bool octet_values = data::BinDataView<uint8_t>::isCompatible(bytes_values);
 
   // Draw background.
   // This code will be optimized in another commit to reduce number of calls to
@@ -858,7 +862,10 @@ void HexEdit::paintEvent(QPaintEvent* event) {
         bool redraw_ascii = invalidated_rect.intersects(ascii_rect);
 
         if (redraw_hex || redraw_ascii) {
-          auto byte_val = bytes_values.element64(byte_num - start_byte);
+          auto value_idx = byte_num - start_byte;
+          uint64_t byte_val =
+              octet_values ? data::BinDataView<uint8_t>(bytes_values)[value_idx]
+                           : bytes_values.element64(value_idx);
           painter.setPen(QPen(byteTextColorFromByteValue(byte_val)));
           // We use drawStaticText() where possible, as it's much faster than
           // drawText(). Unfortunately, both functions use different
@@ -1182,7 +1189,7 @@ void HexEdit::copyToClipboard(util::encoders::IEncoder* enc) {
       enc = hexEncoder_.data();
     }
   }
-  auto selectedData =
+  const auto selectedData =
       edit_engine_.bytesValues(selectionStart(), selectionSize());
 
   QClipboard* clipboard = QApplication::clipboard();
@@ -1214,10 +1221,11 @@ void HexEdit::pasteFromClipboard(util::encoders::IDecoder* enc) {
     paste_size = dataBytesCount_ - paste_start_position;
   }
 
-  data::BinData new_data(bindata_width_, paste_size);
+  data::BinDataBuilder builder(bindata_width_, paste_size);
   for (int i = 0; i < paste_size; ++i) {
-    new_data.setElement64(i, static_cast<unsigned char>(data[i]));
+    builder.appendElement64(static_cast<unsigned char>(data[i]));
   }
+  data::BinData new_data = builder.finish();
   if (in_insert_mode_) {
     insertBytes(paste_start_position, new_data);
   } else {
@@ -1392,7 +1400,7 @@ void HexEdit::saveDataToFile(qint64 byte_offset, qint64 size,
   if (byte_offset + size > dataBytesCount_) {
     size = dataBytesCount_ - byte_offset;
   }
-  auto data = edit_engine_.bytesValues(byte_offset, size);
+  const auto data = edit_engine_.bytesValues(byte_offset, size);
 
   QString tmp_path = path + ".tmp." + util::generateRandomUppercaseText(12);
 
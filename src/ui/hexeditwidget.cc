@@ -155,7 +155,7 @@ void HexEditWidget::createActions() {
       util::getColoredIcon(":/images/trigram_icon.png", icon_color),
       Qt::WidgetWithChildrenShortcut);
   visualization_act_->setToolTip(tr("Visualization"));
-  visualization_act_->setEnabled(data_model_->binData().size() > 0);
+  visualization_act_->setEnabled(data_model_->hasAnyBinData());
   connect(visualization_act_, &QAction::triggered, this,
           &HexEditWidget::showVisualization);
 
@@ -330,6 +330,9 @@ void HexEditWidget::addChunk(const QString& name, const QString& type,
 void HexEditWidget::setupDataModelHandlers() {
   connect(data_model_.data(), &FileBlobModel::newBinData, this,
           &HexEditWidget::newBinData);
+  // Visualizations can show data that is still arriving.
+  connect(data_model_.data(), &FileBlobModel::binDataReceived, this,
+          &HexEditWidget::newBinData);
 }
 
 /*****************************************************************************/
@@ -366,7 +369,7 @@ void HexEditWidget::openHexEditor() {
 }
 
 void HexEditWidget::newBinData() {
-  visualization_act_->setEnabled(data_model_->binData().size() > 0);
+  visualization_act_->setEnabled(data_model_->hasAnyBinData());
 }
 
 void HexEditWidget::enableFindNext(bool enable) {
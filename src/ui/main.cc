@@ -19,6 +19,7 @@
 #include <QSurfaceFormat>
 #include <QTranslator>
 
+#include "ui/batch_export.h"
 #include "ui/dockwidget.h"
 #include "ui/veles_mainwindow.h"
 #include "ui/velesapplication.h"
@@ -30,6 +31,11 @@
 #include "visualization/trigram.h"
 
 int main(int argc, char* argv[]) {
+  // Batch mode doesn't need a GUI, so it can run on headless servers.
+  if (veles::ui::batchExportRequested(argc, argv)) {
+    return veles::ui::runBatchExport(argc, argv);
+  }
+
   Q_INIT_RESOURCE(veles);
 
   QSurfaceFormat format;
@@ -717,9 +717,11 @@ void MainWindowWithDetachableDockWidgets::createVisualization(
     const QSharedPointer<FileBlobModel>& data_model) {
   auto* panel = new visualization::VisualizationPanel(this, data_model);
 
-  panel->setData(
-      QByteArray(reinterpret_cast<const char*>(data_model->binData().rawData()),
-                 static_cast<int>(data_model->binData().size())));
+  if (data_model->hasAllBinData()) {
+    panel->setData();
+  } else {
+    panel->setProgressiveData();
+  }
   panel->setAttribute(Qt::WA_DeleteOnClose);
 
   // FIXME: main_window_ needs to be updated when docks are moved around,
@@ -92,8 +92,7 @@ NodeWidget::NodeWidget(
   if(data_model_->binData().size() > 0) {
     loadBinDataToMinimap();
   } else {
-    sampler_data_ = QByteArray("");
-    sampler_ = new util::UniformSampler(sampler_data_);
+    sampler_ = new util::UniformSampler(QByteArray());
     sampler_->setSampleSize(4 * 1024 * 1024);
     minimap_->setSampler(sampler_);
   }
@@ -127,10 +126,8 @@ NodeWidget::~NodeWidget() { delete sampler_; }
 void NodeWidget::loadBinDataToMinimap() {
   delete sampler_;
 
-  sampler_data_ = QByteArray(
-      reinterpret_cast<const char*>(data_model_->binData().rawData()),
-      static_cast<int>(data_model_->binData().octets()));
-  sampler_ = new util::UniformSampler(sampler_data_);
+  // Share the data instead of copying it.
+  sampler_ = new util::UniformSampler(data_model_->binDataSource());
   sampler_->setSampleSize(4 * 1024 * 1024);
   minimap_->setSampler(sampler_);
 }
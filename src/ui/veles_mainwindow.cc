@@ -350,25 +350,10 @@ void VelesMainWindow::createDb() {
 void VelesMainWindow::createFileBlob(const QString& file_name) {
   data::BinData data(8, 0);
 
-  if (!file_name.isEmpty()) {
-    QFile file(file_name);
-    file.setFileName(file_name);
-    if (!file.open(QIODevice::ReadOnly)) {
-      QMessageBox::warning(
-          this, tr("Failed to open"),
-          QString(tr("Failed to open \"%1\".")).arg(file_name));
-      return;
-    }
-    QByteArray bytes = file.readAll();
-    if (bytes.size() == 0 && file.size() != bytes.size()) {
-      QMessageBox::warning(
-          this, tr("File too large"),
-          QString(tr("Failed to open \"%1\" due to current size limitation."))
-              .arg(file_name));
-      return;
-    }
-    data = data::BinData(8, bytes.size(),
-                         reinterpret_cast<uint8_t*>(bytes.data()));
+  if (!file_name.isEmpty() && !data::BinData::mapFile(file_name, &data)) {
+    QMessageBox::warning(this, tr("Failed to open"),
+                         QString(tr("Failed to open \"%1\".")).arg(file_name));
+    return;
   }
   auto promise =
       database_->asyncRunMethod<dbif::RootCreateFileBlobFromDataRequest>(
@@ -16,9 +16,13 @@
  */
 #include "util/concurrency/threadpool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <exception>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -84,6 +88,8 @@ SchedulingResult runTask(const std::string& topic, const Task& t) {
   std::unique_lock<std::mutex> topic_lc(ti->mutex);
   lc.unlock();
   if (ti->mock) {
+    // The task may schedule more tasks of the same topic.
+    topic_lc.unlock();
     t();
     return SchedulingResult::SCHEDULED;
   }
@@ -96,6 +102,153 @@ SchedulingResult runTask(const std::string& topic, const Task& t) {
   return SchedulingResult::SCHEDULED;
 }
 
+namespace {
+
+/** Below this amount of work, parallelFor() doesn't bother helpers.  */
+const uint64_t k_parallel_min_work = 256 * 1024;
+
+/** True on a thread running chunks of a parallelFor() call.  */
+thread_local bool in_parallel_for = false;
+
+/** A parallelFor() call, shared between its caller and the helpers.  */
+struct ParallelJob {
+  const std::function<void(size_t)>* func;
+  size_t num_chunks;
+  std::atomic<size_t> next_chunk{0};
+  std::atomic<bool> failed{false};
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  // Guarded by mutex.
+  size_t finished = 0;
+  std::exception_ptr error;
+
+  /** Run chunks until none are left to take.  */
+  void runChunks() {
+    bool outer = in_parallel_for;
+    in_parallel_for = true;
+    size_t done = 0;
+    for (size_t chunk = next_chunk++; chunk < num_chunks;
+         chunk = next_chunk++) {
+      if (!failed) {
+        try {
+          (*func)(chunk);
+        } catch (...) {
+          std::unique_lock<std::mutex> lc(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          failed = true;
+        }
+      }
+      ++done;
+    }
+    in_parallel_for = outer;
+    if (done > 0) {
+      std::unique_lock<std::mutex> lc(mutex);
+      finished += done;
+      if (finished == num_chunks) {
+        cv.notify_all();
+      }
+    }
+  }
+};
+
+/** Helper threads of parallelFor(), waiting for jobs with chunks left.  */
+class ParallelPool {
+ public:
+  static ParallelPool& instance() {
+    // Never destroyed: helpers run until the process exits.
+    static auto* pool = new ParallelPool(parallelism() - 1);
+    return *pool;
+  }
+
+  void run(size_t num_chunks, const std::function<void(size_t)>& func) {
+    auto job = std::make_shared<ParallelJob>();
+    job->func = &func;
+    job->num_chunks = num_chunks;
+    {
+      std::unique_lock<std::mutex> lc(mutex_);
+      jobs_.push_back(job);
+    }
+    cv_.notify_all();
+    // The caller works too, so the job finishes even if all helpers are
+    // busy with other jobs.
+    job->runChunks();
+    {
+      std::unique_lock<std::mutex> lc(job->mutex);
+      job->cv.wait(lc, [&]() { return job->finished == num_chunks; });
+    }
+    {
+      std::unique_lock<std::mutex> lc(mutex_);
+      auto it = std::find(jobs_.begin(), jobs_.end(), job);
+      if (it != jobs_.end()) {
+        jobs_.erase(it);
+      }
+    }
+    if (job->error) {
+      std::rethrow_exception(job->error);
+    }
+  }
+
+ private:
+  explicit ParallelPool(size_t helpers) {
+    for (size_t i = 0; i < helpers; ++i) {
+      std::thread(&ParallelPool::helperFunction, this).detach();
+    }
+  }
+
+  void helperFunction() {
+    while (true) {
+      std::shared_ptr<ParallelJob> job;
+      {
+        std::unique_lock<std::mutex> lc(mutex_);
+        cv_.wait(lc, [this]() { return !jobs_.empty(); });
+        job = jobs_.front();
+        if (job->next_chunk >= job->num_chunks) {
+          // Nothing left to take, the caller finishes it.
+          jobs_.pop_front();
+          continue;
+        }
+      }
+      job->runChunks();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<ParallelJob>> jobs_;
+};
+
+}  // namespace
+
+void parallelFor(size_t num_chunks, const std::function<void(size_t)>& func) {
+  if (num_chunks <= 1 || in_parallel_for || parallelism() == 1) {
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      func(chunk);
+    }
+    return;
+  }
+  ParallelPool::instance().run(num_chunks, func);
+}
+
+void parallelFor(size_t num_chunks, uint64_t work,
+                 const std::function<void(size_t)>& func) {
+  if (work < k_parallel_min_work) {
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      func(chunk);
+    }
+    return;
+  }
+  parallelFor(num_chunks, func);
+}
+
+size_t parallelism() {
+  static const size_t threads =
+      std::max(1u, std::thread::hardware_concurrency());
+  return threads;
+}
+
 }  // namespace threadpool
 }  // namespace util
 }  // namespace veles
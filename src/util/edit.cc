@@ -17,6 +17,8 @@
 
 #include "util/edit.h"
 
+#include "data/bindata_view.h"
+
 namespace veles {
 namespace util {
 
@@ -261,17 +263,18 @@ uint64_t EditEngine::byteValue(size_t pos) const {
   --it;
 
   size_t offset_in_fragment = it->offset_ + (pos - it.key());
-  if (it->fragment_ == nullptr) {
-    return original_data_->binData().element64(offset_in_fragment);
+  const data::BinData& fragment = it->fragment_ == nullptr
+                                      ? original_data_->binData()
+                                      : *it->fragment_;
+  if (data::BinDataView<uint8_t>::isCompatible(fragment)) {
+    return data::BinDataView<uint8_t>(fragment)[offset_in_fragment];
   }
-  return it->fragment_->element64(offset_in_fragment);
+  return fragment.element64(offset_in_fragment);
 }
 
 data::BinData EditEngine::bytesValues(size_t pos, size_t size) const {
   assert(pos + size <= dataSize());
 
-  data::BinData result = data::BinData(original_data_->binData().width(), size);
-
   const size_t end_pos = pos + size;
   auto next_it = address_mapping_.upperBound(pos);
   assert(next_it != address_mapping_.cbegin());
@@ -280,36 +283,37 @@ data::BinData EditEngine::bytesValues(size_t pos, size_t size) const {
 
   if (next_it == address_mapping_.cend() || end_pos <= next_it.key()) {
     // This is the case when whole query range is located in only one node.
-    result.setData(0, size,
-                   getDataFromEditNode(it.value(), pos - it.key(), size));
-  } else {
-    // This is the case when query range is located in two or more nodes.
-
-    // Copy data from first relevant node.
-    size_t size_to_write = next_it.key() - pos;
-    result.setData(
-        0, size_to_write,
-        getDataFromEditNode(it.value(), pos - it.key(), size_to_write));
-    size_t bytes_written = size_to_write;
+    // The slice shares storage with the node, so no copy is made here.
+    return getDataFromEditNode(it.value(), pos - it.key(), size);
+  }
 
-    // Copy data from inner relevant nodes (maybe none).
-    ++it;
-    ++next_it;
-    while (next_it != address_mapping_.cend() && next_it.key() < end_pos) {
-      size_to_write = next_it.key() - it.key();
-      result.setData(bytes_written, size_to_write,
-                     getDataFromEditNode(it.value(), 0, size_to_write));
-      bytes_written += size_to_write;
-      ++it;
-      ++next_it;
-    }
+  // This is the case when query range is located in two or more nodes.
+  data::BinData result = data::BinData(original_data_->binData().width(), size);
 
-    // Copy data from last relevant node.
-    size_to_write = size - bytes_written;
+  // Copy data from first relevant node.
+  size_t size_to_write = next_it.key() - pos;
+  result.setData(
+      0, size_to_write,
+      getDataFromEditNode(it.value(), pos - it.key(), size_to_write));
+  size_t bytes_written = size_to_write;
+
+  // Copy data from inner relevant nodes (maybe none).
+  ++it;
+  ++next_it;
+  while (next_it != address_mapping_.cend() && next_it.key() < end_pos) {
+    size_to_write = next_it.key() - it.key();
     result.setData(bytes_written, size_to_write,
                    getDataFromEditNode(it.value(), 0, size_to_write));
+    bytes_written += size_to_write;
+    ++it;
+    ++next_it;
   }
 
+  // Copy data from last relevant node.
+  size_to_write = size - bytes_written;
+  result.setData(bytes_written, size_to_write,
+                 getDataFromEditNode(it.value(), 0, size_to_write));
+
   return result;
 }
 
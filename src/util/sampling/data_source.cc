@@ -0,0 +1,274 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/data_source.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+namespace veles {
+namespace util {
+
+/*****************************************************************************/
+/* DataSource */
+/*****************************************************************************/
+
+char DataSource::byteAt(uint64_t offset) const {
+  const char* data = contiguousData();
+  if (data != nullptr) {
+    return data[offset];
+  }
+  char res;
+  read(offset, 1, &res);
+  return res;
+}
+
+/*****************************************************************************/
+/* QByteArrayDataSource */
+/*****************************************************************************/
+
+uint64_t QByteArrayDataSource::size() const {
+  return static_cast<uint64_t>(data_.size());
+}
+
+void QByteArrayDataSource::read(uint64_t offset, uint64_t size,
+                                char* out) const {
+  assert(offset + size <= this->size());
+  memcpy(out, data_.constData() + offset, size);
+}
+
+const char* QByteArrayDataSource::contiguousData() const {
+  return data_.constData();
+}
+
+/*****************************************************************************/
+/* BinDataSource */
+/*****************************************************************************/
+
+BinDataSource::BinDataSource(const data::BinData& data) : data_(data) {}
+
+uint64_t BinDataSource::size() const { return data_.octets(); }
+
+void BinDataSource::read(uint64_t offset, uint64_t size, char* out) const {
+  assert(offset + size <= data_.octets());
+  memcpy(out, contiguousData() + offset, size);
+}
+
+const char* BinDataSource::contiguousData() const {
+  return reinterpret_cast<const char*>(data_.rawData());
+}
+
+/*****************************************************************************/
+/* MappedFileDataSource */
+/*****************************************************************************/
+
+MappedFileDataSource::MappedFileDataSource(const QString& path)
+    : file_(path), size_(0), map_(nullptr) {
+  if (!file_.open(QIODevice::ReadOnly)) {
+    return;
+  }
+  size_ = static_cast<uint64_t>(file_.size());
+  if (size_ == 0) {
+    return;
+  }
+  map_ = reinterpret_cast<const char*>(file_.map(0, file_.size()));
+  if (map_ == nullptr) {
+    // Samplers read many small windows, which would be a seek and a read
+    // each.
+    pages_.reset(new PagedDataSource(
+        size_, [this](uint64_t offset, uint64_t size, char* out) {
+          readFile(offset, size, out);
+        }));
+  }
+}
+
+uint64_t MappedFileDataSource::size() const { return size_; }
+
+void MappedFileDataSource::read(uint64_t offset, uint64_t size,
+                                char* out) const {
+  assert(offset + size <= size_);
+  if (map_ != nullptr) {
+    memcpy(out, map_ + offset, size);
+  } else if (pages_ != nullptr) {
+    pages_->read(offset, size, out);
+  }
+}
+
+void MappedFileDataSource::readFile(uint64_t offset, uint64_t size,
+                                    char* out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.seek(static_cast<qint64>(offset));
+  qint64 read = file_.read(out, static_cast<qint64>(size));
+  if (read < 0) {
+    read = 0;
+  }
+  // Keep the contract of returning exactly `size` bytes even if the file
+  // was truncated behind our back.
+  memset(out + read, 0, size - static_cast<uint64_t>(read));
+}
+
+const char* MappedFileDataSource::contiguousData() const { return map_; }
+
+/*****************************************************************************/
+/* PagedDataSource */
+/*****************************************************************************/
+
+const uint64_t PagedDataSource::k_default_page_size;
+const size_t PagedDataSource::k_default_max_pages;
+
+PagedDataSource::PagedDataSource(uint64_t size, const PageFetcher& fetcher,
+                                 uint64_t page_size, size_t max_pages)
+    : size_(size),
+      fetcher_(fetcher),
+      page_size_(page_size),
+      max_pages_(std::max<size_t>(max_pages, 1)) {
+  assert(page_size_ != 0);
+}
+
+uint64_t PagedDataSource::size() const { return size_; }
+
+void PagedDataSource::read(uint64_t offset, uint64_t size, char* out) const {
+  assert(offset + size <= size_);
+  while (size != 0) {
+    uint64_t index = offset / page_size_;
+    uint64_t page_offset = offset % page_size_;
+    // Fetched pages are never modified, holding one keeps it alive even if
+    // it's evicted meanwhile.
+    auto data = page(index);
+    uint64_t chunk = std::min<uint64_t>(size, data->size() - page_offset);
+    memcpy(out, data->data() + page_offset, chunk);
+    offset += chunk;
+    size -= chunk;
+    out += chunk;
+  }
+}
+
+PagedDataSource::PageData PagedDataSource::page(uint64_t index) const {
+  std::unique_lock<std::mutex> lc(mutex_);
+  auto it = pages_.find(index);
+  while (it != pages_.end() && it->second.data == nullptr) {
+    // Someone else is fetching it.
+    fetched_.wait(lc);
+    it = pages_.find(index);
+  }
+  if (it != pages_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.data;
+  }
+  pages_.emplace(index, Page());
+  lc.unlock();
+
+  uint64_t start = index * page_size_;
+  std::shared_ptr<std::vector<char>> data;
+  try {
+    data = std::make_shared<std::vector<char>>(
+        std::min(page_size_, size_ - start));
+    fetcher_(start, data->size(), data->data());
+  } catch (...) {
+    lc.lock();
+    pages_.erase(index);
+    fetched_.notify_all();
+    throw;
+  }
+
+  lc.lock();
+  it = pages_.find(index);
+  it->second.data = data;
+  it->second.lru = lru_.insert(lru_.begin(), index);
+  while (lru_.size() > max_pages_) {
+    pages_.erase(lru_.back());
+    lru_.pop_back();
+  }
+  fetched_.notify_all();
+  return data;
+}
+
+/*****************************************************************************/
+/* ProgressiveDataSource */
+/*****************************************************************************/
+
+ProgressiveDataSource::ProgressiveDataSource(uint64_t size)
+    : size_(size), data_(new char[size]()), available_(0) {}
+
+void ProgressiveDataSource::write(uint64_t offset, const char* data,
+                                  uint64_t size) {
+  assert(offset + size <= size_);
+  if (size == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  memcpy(data_.get() + offset, data, size);
+
+  // Merge [begin, end) with all ranges it touches.
+  uint64_t begin = offset, end = offset + size;
+  auto it = ranges_.upper_bound(begin);
+  if (it != ranges_.begin() && std::prev(it)->second >= begin) {
+    --it;
+  }
+  while (it != ranges_.end() && it->first <= end) {
+    begin = std::min(begin, it->first);
+    end = std::max(end, it->second);
+    available_ -= it->second - it->first;
+    it = ranges_.erase(it);
+  }
+  ranges_.emplace_hint(it, begin, end);
+  available_ += end - begin;
+}
+
+uint64_t ProgressiveDataSource::availableSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return available_;
+}
+
+bool ProgressiveDataSource::isComplete() const {
+  return availableSize() == size_;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>>
+ProgressiveDataSource::availableRanges(uint64_t start, uint64_t end) const {
+  std::vector<std::pair<uint64_t, uint64_t>> res;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ranges_.upper_bound(start);
+  if (it != ranges_.begin()) {
+    --it;
+  }
+  for (; it != ranges_.end() && it->first < end; ++it) {
+    uint64_t begin = std::max(start, it->first);
+    uint64_t range_end = std::min(end, it->second);
+    if (begin < range_end) {
+      res.emplace_back(begin, range_end);
+    }
+  }
+  return res;
+}
+
+uint64_t ProgressiveDataSource::size() const { return size_; }
+
+void ProgressiveDataSource::read(uint64_t offset, uint64_t size,
+                                 char* out) const {
+  assert(offset + size <= size_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  memcpy(out, data_.get() + offset, size);
+}
+
+const char* ProgressiveDataSource::contiguousData() const {
+  return isComplete() ? data_.get() : nullptr;
+}
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/entropy_sampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include "util/concurrency/threadpool.h"
+#include "util/sampling/windows.h"
+#include "util/stats/byte_stats.h"
+
+namespace veles {
+namespace util {
+
+const size_t EntropySampler::k_max_blocks;
+const size_t EntropySampler::k_probes_per_block;
+const size_t EntropySampler::k_probe_size;
+constexpr double EntropySampler::k_entropy_floor;
+
+/*****************************************************************************/
+/* Public methods */
+/*****************************************************************************/
+
+EntropySampler::EntropySampler(const QByteArray& data)
+    : ISampler(data),
+      seed_(0),
+      window_size_(0),
+      use_default_window_size_(true) {}
+
+EntropySampler::EntropySampler(std::shared_ptr<const DataSource> source)
+    : ISampler(std::move(source)),
+      seed_(0),
+      window_size_(0),
+      use_default_window_size_(true) {}
+
+void EntropySampler::setWindowSize(size_t size) {
+  auto lc = waitAndLock();
+  window_size_ = size;
+  use_default_window_size_ = size == 0;
+  resample();
+}
+
+void EntropySampler::setSeed(uint64_t seed) {
+  auto lc = waitAndLock();
+  seed_ = seed;
+  resample();
+}
+
+std::vector<double> EntropySampler::getBlockEntropy() {
+  auto lc = lock();
+  if (sample_ == nullptr) {
+    return {};
+  }
+  return sample_->block_entropy;
+}
+
+/*****************************************************************************/
+/* Private methods */
+/*****************************************************************************/
+
+EntropySampler::EntropySampler(const EntropySampler& other)
+    : ISampler(other),
+      seed_(other.seed_),
+      window_size_(other.window_size_),
+      use_default_window_size_(other.use_default_window_size_) {}
+
+char EntropySampler::getSampleByte(size_t index) const {
+  assert(sample_ != nullptr);
+  return sample_->data[index];
+}
+
+const char* EntropySampler::getData() const {
+  return sample_ != nullptr ? sample_->data.get() : nullptr;
+}
+
+size_t EntropySampler::getRealSampleSize() const {
+  return sample_ != nullptr ? window_size_ * sample_->windows.size() : 0;
+}
+
+size_t EntropySampler::getFileOffsetImpl(size_t index) const {
+  return sample_->fileOffset(index);
+}
+
+size_t EntropySampler::getSampleOffsetImpl(size_t address) const {
+  return sample_->sampleOffset(address);
+}
+
+std::vector<double> EntropySampler::blockEntropy(size_t block_size,
+                                                 size_t blocks,
+                                                 SamplerConfig* sc) const {
+  size_t size = getDataSize(sc);
+  std::vector<double> result(blocks);
+  uint64_t work = static_cast<uint64_t>(blocks) * k_probes_per_block *
+                  k_probe_size;
+  threadpool::parallelFor(blocks, work, [&](size_t block) {
+    if (isCancelled(sc)) {
+      return;
+    }
+    size_t begin = block * block_size;
+    size_t length = std::min(block_size, size - begin);
+    std::vector<char> probe(std::min(length, k_probe_size));
+    stats::ByteHistogram hist;
+    hist.fill(0);
+    uint64_t total = 0;
+    // Probes are spread evenly over the block. Small blocks are read whole.
+    size_t probes = std::min(k_probes_per_block,
+                             (length + k_probe_size - 1) / k_probe_size);
+    for (size_t i = 0; i < probes; ++i) {
+      size_t offset =
+          probes == 1 ? 0 : i * (length - probe.size()) / (probes - 1);
+      readData(begin + offset, probe.size(), probe.data(), sc);
+      stats::accumulateHistogram(
+          reinterpret_cast<const uint8_t*>(probe.data()), probe.size(),
+          &hist);
+      total += probe.size();
+    }
+    result[block] = stats::entropy(hist, total);
+  });
+  return result;
+}
+
+size_t EntropySampler::Sample::memorySize() const {
+  return WindowSample::memorySize() + block_entropy.size() * sizeof(double);
+}
+
+ISampler::ResampleData* EntropySampler::prepareResample(SamplerConfig* sc) {
+  size_t sample_size = getRequestedSampleSize(sc);
+  size_t window_size = window_size_;
+  if (use_default_window_size_ || window_size_ == 0) {
+    window_size =
+        std::max<size_t>(1, static_cast<size_t>(floor(sqrt(sample_size))));
+  }
+
+  SampleKey key{"entropy", sc->start, sc->start + getDataSize(sc),
+                sample_size, window_size, seed_};
+  auto sample = std::static_pointer_cast<const Sample>(
+      cachedSample(key, [&]() { return computeSample(sc, window_size); }));
+  if (sample == nullptr) {
+    return nullptr;
+  }
+
+  auto* rd = new EntropySamplerResampleData;
+  rd->sample = std::move(sample);
+  return rd;
+}
+
+std::shared_ptr<const EntropySampler::Sample> EntropySampler::computeSample(
+    SamplerConfig* sc, size_t window_size) const {
+  size_t size = getDataSize(sc);
+  size_t windows_count = getRequestedSampleSize(sc) / window_size;
+
+  size_t block_size = std::max((size + k_max_blocks - 1) / k_max_blocks,
+                               window_size);
+  size_t blocks = (size + block_size - 1) / block_size;
+  auto entropy = blockEntropy(block_size, blocks, sc);
+  if (isCancelled(sc)) {
+    return nullptr;
+  }
+  std::vector<double> weights(blocks);
+  std::vector<size_t> capacities(blocks);
+  for (size_t i = 0; i < blocks; ++i) {
+    size_t length = std::min(block_size, size - i * block_size);
+    weights[i] = (entropy[i] + k_entropy_floor) * length;
+    capacities[i] = length / window_size;
+  }
+  auto counts = allocateWindows(windows_count, weights, capacities);
+
+  std::vector<size_t> first_window(blocks + 1, 0);
+  for (size_t i = 0; i < blocks; ++i) {
+    first_window[i + 1] = first_window[i] + counts[i];
+  }
+  windows_count = first_window[blocks];
+
+  auto sample = std::make_shared<Sample>();
+  sample->window_size = window_size;
+  sample->windows.resize(windows_count);
+  sample->block_entropy = std::move(entropy);
+  sample->data.reset(new char[window_size * windows_count]);
+
+  uint64_t seed = seed_;
+  uint64_t work = static_cast<uint64_t>(windows_count) * window_size;
+  threadpool::parallelFor(blocks, work, [&](size_t block) {
+    size_t begin = block * block_size;
+    size_t length = std::min(block_size, size - begin);
+    size_t count = counts[block];
+    if (count == 0 || isCancelled(sc)) {
+      return;
+    }
+    auto generator = windowsGenerator(seed, block);
+    size_t* windows = sample->windows.data() + first_window[block];
+    drawWindows(length, count, window_size, &generator, windows);
+    for (size_t i = 0; i < count; ++i) {
+      windows[i] += begin;
+      readData(windows[i], window_size,
+               sample->data.get() + (first_window[block] + i) * window_size,
+               sc);
+    }
+  });
+  if (isCancelled(sc)) {
+    return nullptr;
+  }
+  return sample;
+}
+
+void EntropySampler::applyResample(ResampleData* rd) {
+  auto* esrd = static_cast<EntropySamplerResampleData*>(rd);
+  sample_ = std::move(esrd->sample);
+  window_size_ = sample_->window_size;
+  setWindowSample(sample_);
+  delete esrd;
+}
+
+void EntropySampler::cleanupResample(ResampleData* rd) {
+  delete static_cast<EntropySamplerResampleData*>(rd);
+}
+
+EntropySampler* EntropySampler::cloneImpl() const {
+  return new EntropySampler(*this);
+}
+
+}  // namespace util
+}  // namespace veles
@@ -16,9 +16,23 @@
  */
 #include "util/sampling/fake_sampler.h"
 
+#include <utility>
+
 namespace veles {
 namespace util {
 
+// There's nothing to wait for, so the data is published for snapshots right
+// away rather than on the first resample.
+
+FakeSampler::FakeSampler(const QByteArray& data) : ISampler(data) {
+  resample();
+}
+
+FakeSampler::FakeSampler(std::shared_ptr<const DataSource> source)
+    : ISampler(std::move(source)) {
+  resample();
+}
+
 FakeSampler* FakeSampler::cloneImpl() const { return new FakeSampler(*this); }
 
 size_t FakeSampler::getRealSampleSize() const { return getDataSize(); }
@@ -16,7 +16,12 @@
  */
 #include "util/sampling/isampler.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "util/concurrency/threadpool.h"
 
@@ -24,26 +29,128 @@ namespace veles {
 namespace util {
 
 /*****************************************************************************/
-/* Public methods */
+/* WindowSample */
+/*****************************************************************************/
+
+size_t WindowSample::memorySize() const {
+  return windows.size() * (sizeof(size_t) + window_size);
+}
+
+size_t WindowSample::fileOffset(size_t index) const {
+  return windows[index / window_size] + (index % window_size);
+}
+
+size_t WindowSample::sampleOffset(size_t address) const {
+  // we want the last window less or equal to address (or first window if
+  // no such window exists)
+  if (windows.empty() || address < windows[0]) {
+    return 0;
+  }
+  auto previous_window =
+      std::upper_bound(windows.begin(), windows.end(), address);
+  if (previous_window != windows.begin()) {
+    --previous_window;
+  }
+  size_t base_index = static_cast<size_t>(
+      std::distance(windows.begin(), previous_window) * window_size);
+  return base_index + std::min(window_size - 1, address - (*previous_window));
+}
+
+/*****************************************************************************/
+/* SampleSnapshot */
+/*****************************************************************************/
+
+SampleSnapshot::SampleSnapshot(std::shared_ptr<const DataSource> source,
+                               size_t start, size_t end,
+                               size_t requested_size)
+    : source_(std::move(source)),
+      start_(start),
+      end_(end),
+      requested_size_(requested_size),
+      size_(0),
+      data_(nullptr) {}
+
+size_t SampleSnapshot::getFileOffset(size_t index) const {
+  assert(index <= requested_size_);
+  if (index == 0) {
+    return start_;
+  }
+  if (index == requested_size_ - 1) {
+    return end_ - 1;
+  }
+  if (index == requested_size_) {
+    return end_;
+  }
+  if (sample_ == nullptr) {
+    return index + start_;
+  }
+  return start_ + sample_->fileOffset(index);
+}
+
+size_t SampleSnapshot::getSampleOffset(size_t address) const {
+  assert(address >= start_);
+  assert(address < end_);
+  if (address == start_) {
+    return 0;
+  }
+  if (address == end_ - 1) {
+    return size_ - 1;
+  }
+  if (sample_ == nullptr) {
+    return address - start_;
+  }
+  return sample_->sampleOffset(address - start_);
+}
+
+size_t SampleSnapshot::getWindowCount() const {
+  if (sample_ == nullptr) {
+    return empty() ? 0 : 1;
+  }
+  return sample_->windows.size();
+}
+
+size_t SampleSnapshot::getWindowSize() const {
+  if (sample_ == nullptr) {
+    return size_;
+  }
+  return sample_->window_size;
+}
+
+size_t SampleSnapshot::getWindowOffset(size_t index) const {
+  if (sample_ == nullptr) {
+    return start_;
+  }
+  return start_ + sample_->windows[index];
+}
+
+/*****************************************************************************/
+/* ISampler - public methods */
 /*****************************************************************************/
 
 ISampler::ISampler(const QByteArray& data)
-    : data_(data),
+    : ISampler(std::make_shared<QByteArrayDataSource>(data)) {}
+
+ISampler::ISampler(std::shared_ptr<const DataSource> source)
+    : source_(std::move(source)),
       start_(0),
       sample_size_(0),
       allow_async_(false),
       current_version_(0),
       requested_version_(0),
+      queued_resamples_(0),
       next_cb_id_(0) {
-  end_ = static_cast<size_t>(data_.size());
+  end_ = static_cast<size_t>(source_->size());
   last_config_.start = start_;
   last_config_.end = end_;
   last_config_.sample_size = sample_size_;
+  last_config_.version = 0;
+  snapshot_ = std::shared_ptr<const SampleSnapshot>(
+      new SampleSnapshot(source_, start_, end_, 0));
 }
 
 void ISampler::setRange(size_t start, size_t end) {
   assert(!empty());
-  assert(end <= static_cast<size_t>(data_.size()));
+  assert(end <= source_->size());
   auto lc = lock();
   last_config_.start = start;
   last_config_.end = end;
@@ -133,7 +240,11 @@ const char* ISampler::data() {
   return getData();
 }
 
-bool ISampler::empty() const { return data_.isEmpty(); }
+bool ISampler::empty() const { return source_->size() == 0; }
+
+std::shared_ptr<const SampleSnapshot> ISampler::snapshot() const {
+  return std::atomic_load(&snapshot_);
+}
 
 std::unique_lock<SamplerMutex> ISampler::lock() {
   return std::unique_lock<SamplerMutex>(sampler_mutex_);
@@ -151,7 +262,7 @@ std::unique_lock<SamplerMutex> ISampler::waitAndLock() {
   if (!allow_async_) {
     return lc;
   }
-  while (!isFinished()) {
+  while (!isFinished() || queued_resamples_ != 0) {
     sampler_condition_.wait(lc);
   }
   return lc;
@@ -163,19 +274,19 @@ bool ISampler::isFinished() const {
 
 ResampleCallbackId ISampler::registerResampleCallback(
     const ResampleCallback& cb) {
-  auto lc = lock();
+  std::unique_lock<SamplerMutex> lc(callbacks_mutex_);
   ResampleCallbackId id = next_cb_id_++;
   callbacks_[id] = cb;
   return id;
 }
 
 void ISampler::removeResampleCallback(ResampleCallbackId cb_id) {
-  auto lc = lock();
+  std::unique_lock<SamplerMutex> lc(callbacks_mutex_);
   callbacks_.erase(cb_id);
 }
 
 void ISampler::clearResampleCallbacks() {
-  auto lc = lock();
+  std::unique_lock<SamplerMutex> lc(callbacks_mutex_);
   callbacks_.clear();
 }
 
@@ -189,12 +300,18 @@ ISampler* ISampler::clone() {
 
 void ISampler::allowAsynchronousResampling(bool allow) { allow_async_ = allow; }
 
+void ISampler::setSampleCache(std::shared_ptr<SampleCache> cache) {
+  auto lc = lock();
+  cache_ = std::move(cache);
+}
+
 /*****************************************************************************/
 /* Protected methods */
 /*****************************************************************************/
 
 ISampler::ISampler(const ISampler& other)
-    : data_(other.data_),
+    : source_(other.source_),
+      cache_(other.cache_),
       start_(other.start_),
       end_(other.end_),
       sample_size_(other.sample_size_),
@@ -202,22 +319,52 @@ ISampler::ISampler(const ISampler& other)
       last_config_(other.last_config_),
       current_version_(0),
       requested_version_(0),
+      queued_resamples_(0),
+      snapshot_(std::atomic_load(&other.snapshot_)),
+      next_cb_id_(other.next_cb_id_),
       callbacks_(other.callbacks_) {}
 
 size_t ISampler::getDataSize(SamplerConfig* sc) const {
   if (sc == nullptr) {
-    return std::min<size_t>(data_.size(), end_ - start_);
+    return std::min<size_t>(source_->size(), end_ - start_);
   }
-  return std::min<size_t>(data_.size(), sc->end - sc->start);
+  return std::min<size_t>(source_->size(), sc->end - sc->start);
 }
 
 char ISampler::getDataByte(size_t index, SamplerConfig* sc) const {
   size_t start = (sc == nullptr) ? start_ : sc->start;
-  return data_[static_cast<int>(start + index)];
+  return source_->byteAt(start + index);
+}
+
+void ISampler::readData(size_t index, size_t size, char* out,
+                        SamplerConfig* sc) const {
+  size_t start = (sc == nullptr) ? start_ : sc->start;
+  source_->read(start + index, size, out);
+}
+
+bool ISampler::isCancelled(const SamplerConfig* sc) const {
+  return allow_async_ && sc->version < requested_version_.load();
+}
+
+std::shared_ptr<const CachedSample> ISampler::cachedSample(
+    const SampleKey& key, const SampleCache::Compute& compute) const {
+  if (cache_ == nullptr) {
+    return compute();
+  }
+  return cache_->get(key, compute);
+}
+
+std::shared_ptr<const CachedSample> ISampler::findCachedSample(
+    const SampleKey& key) const {
+  return cache_ != nullptr ? cache_->find(key) : nullptr;
 }
 
 size_t ISampler::getRealSampleSize() const { return getRequestedSampleSize(); }
 
+void ISampler::setWindowSample(std::shared_ptr<const WindowSample> sample) {
+  window_sample_ = std::move(sample);
+}
+
 size_t ISampler::getRequestedSampleSize(SamplerConfig* sc) const {
   size_t sample_size = (sc == nullptr) ? sample_size_ : sc->sample_size;
   return std::min(getDataSize(sc), sample_size);
@@ -225,7 +372,13 @@ size_t ISampler::getRequestedSampleSize(SamplerConfig* sc) const {
 
 const char* ISampler::getRawData(SamplerConfig* sc) const {
   size_t start = (sc == nullptr) ? start_ : sc->start;
-  return data_.data() + start;
+  const char* data = source_->contiguousData();
+  if (data != nullptr) {
+    return data + start;
+  }
+  raw_copy_.resize(getDataSize(sc));
+  readData(0, raw_copy_.size(), raw_copy_.data(), sc);
+  return raw_copy_.data();
 }
 
 /*****************************************************************************/
@@ -250,42 +403,61 @@ void ISampler::runResample(SamplerConfig* sc) {
       auto lc = lock();
       current_version_ = ++requested_version_;
       applySamplerConfig(sc);
-      for (auto i = callbacks_.rbegin(); i != callbacks_.rend(); ++i) {
-        (i->second)();
-      }
+      publishSnapshot();
       lc.unlock();
       delete sc;
+      runCallbacks();
       return;
     }
-    threadpool::runTask(
-        "visualization",
-        std::bind(&ISampler::resampleAsync, this, ++requested_version_, sc));
+    sc->version = ++requested_version_;
+    // Callers hold the sampler lock.
+    ++queued_resamples_;
+    if (threadpool::runTask(
+            "visualization",
+            std::bind(&ISampler::resampleAsync, this, sc->version, sc)) !=
+        threadpool::SchedulingResult::SCHEDULED) {
+      --queued_resamples_;
+    }
   } else {
     if (samplingRequired(sc)) {
       ResampleData* prepared = prepareResample(sc);
       applyResample(prepared);
     }
     applySamplerConfig(sc);
+    publishSnapshot();
     delete sc;
   }
 }
 
 void ISampler::resampleAsync(int target_version, SamplerConfig* sc) {
+  runResampleTask(target_version, sc);
+  // The last thing done with this sampler - wait() returns only after it,
+  // so the sampler may be deleted right afterwards.
+  auto lc = lock();
+  --queued_resamples_;
+  sampler_condition_.notify_all();
+}
+
+void ISampler::runResampleTask(int target_version, SamplerConfig* sc) {
   if (target_version < requested_version_.load()) {
+    delete sc;
     return;
   }
   ResampleData* prepared = prepareResample(sc);
+  if (prepared == nullptr && isCancelled(sc)) {
+    // Stopped early, a newer resample will take care of waiters.
+    delete sc;
+    return;
+  }
   auto lc = lock();
   if (target_version > current_version_) {
     applyResample(prepared);
     applySamplerConfig(sc);
+    publishSnapshot();
     current_version_ = target_version;
-    for (auto i = callbacks_.rbegin(); i != callbacks_.rend(); ++i) {
-      (i->second)();
-    }
     lc.unlock();
     delete sc;
-    sampler_condition_.notify_all();
+    runCallbacks();
   } else {
     lc.unlock();
     cleanupResample(prepared);
@@ -293,5 +465,36 @@ void ISampler::resampleAsync(int target_version, SamplerConfig* sc) {
   }
 }
 
+void ISampler::publishSnapshot() {
+  std::shared_ptr<SampleSnapshot> snapshot(
+      new SampleSnapshot(source_, start_, end_, getRequestedSampleSize()));
+  if (samplingRequired() && window_sample_ != nullptr) {
+    snapshot->sample_ = window_sample_;
+    snapshot->size_ = window_sample_->size();
+    snapshot->data_ = window_sample_->data.get();
+  } else if (!empty()) {
+    snapshot->size_ = getDataSize();
+    const char* data = source_->contiguousData();
+    if (data != nullptr) {
+      snapshot->data_ = data + start_;
+      snapshot->data_owner_ = source_;
+    } else {
+      auto copy = std::make_shared<std::vector<char>>(snapshot->size_);
+      readData(0, copy->size(), copy->data());
+      snapshot->data_ = copy->data();
+      snapshot->data_owner_ = std::move(copy);
+    }
+  }
+  std::atomic_store(&snapshot_,
+                    std::shared_ptr<const SampleSnapshot>(std::move(snapshot)));
+}
+
+void ISampler::runCallbacks() {
+  std::unique_lock<SamplerMutex> lc(callbacks_mutex_);
+  for (auto i = callbacks_.rbegin(); i != callbacks_.rend(); ++i) {
+    (i->second)();
+  }
+}
+
 }  // namespace util
 }  // namespace veles
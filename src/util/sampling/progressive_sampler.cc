@@ -0,0 +1,175 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/progressive_sampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include "util/concurrency/threadpool.h"
+#include "util/sampling/windows.h"
+
+namespace veles {
+namespace util {
+
+const uint64_t ProgressiveSampler::k_refine_steps;
+
+/*****************************************************************************/
+/* Public methods */
+/*****************************************************************************/
+
+ProgressiveSampler::ProgressiveSampler(
+    std::shared_ptr<const ProgressiveDataSource> source)
+    : ISampler(source),
+      progressive_source_(std::move(source)),
+      refined_size_(0),
+      window_size_(0),
+      use_default_window_size_(true) {}
+
+void ProgressiveSampler::setWindowSize(size_t size) {
+  auto lc = waitAndLock();
+  window_size_ = size;
+  use_default_window_size_ = size == 0;
+  resample();
+}
+
+bool ProgressiveSampler::refine() {
+  auto lc = lock();
+  uint64_t available = progressive_source_->availableSize();
+  if (available == refined_size_) {
+    return false;
+  }
+  uint64_t step = progressive_source_->size() / k_refine_steps;
+  if (available < 2 * refined_size_ && available - refined_size_ < step &&
+      !progressive_source_->isComplete()) {
+    return false;
+  }
+  refined_size_ = available;
+  resample();
+  return true;
+}
+
+/*****************************************************************************/
+/* Private methods */
+/*****************************************************************************/
+
+ProgressiveSampler::ProgressiveSampler(const ProgressiveSampler& other)
+    : ISampler(other),
+      progressive_source_(other.progressive_source_),
+      refined_size_(other.refined_size_),
+      window_size_(other.window_size_),
+      use_default_window_size_(other.use_default_window_size_) {}
+
+char ProgressiveSampler::getSampleByte(size_t index) const {
+  assert(sample_ != nullptr);
+  return sample_->data[index];
+}
+
+const char* ProgressiveSampler::getData() const {
+  return sample_ != nullptr ? sample_->data.get() : nullptr;
+}
+
+size_t ProgressiveSampler::getRealSampleSize() const {
+  return sample_ != nullptr ? sample_->size() : 0;
+}
+
+size_t ProgressiveSampler::getFileOffsetImpl(size_t index) const {
+  return sample_->fileOffset(index);
+}
+
+size_t ProgressiveSampler::getSampleOffsetImpl(size_t address) const {
+  return sample_->sampleOffset(address);
+}
+
+ISampler::ResampleData* ProgressiveSampler::prepareResample(
+    SamplerConfig* sc) {
+  size_t sample_size = getRequestedSampleSize(sc);
+  size_t window_size = window_size_;
+  if (use_default_window_size_ || window_size_ == 0) {
+    window_size =
+        std::max<size_t>(1, static_cast<size_t>(floor(sqrt(sample_size))));
+  }
+
+  // Ranges relative to sc->start, like window offsets.
+  auto ranges = progressive_source_->availableRanges(
+      sc->start, sc->start + getDataSize(sc));
+  std::vector<double> weights(ranges.size());
+  std::vector<size_t> capacities(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    ranges[i].first -= sc->start;
+    ranges[i].second -= sc->start;
+    size_t length = static_cast<size_t>(ranges[i].second - ranges[i].first);
+    weights[i] = static_cast<double>(length);
+    capacities[i] = length / window_size;
+  }
+  auto counts =
+      allocateWindows(sample_size / window_size, weights, capacities);
+  std::vector<size_t> first_window(ranges.size() + 1, 0);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    first_window[i + 1] = first_window[i] + counts[i];
+  }
+  size_t windows_count = first_window.back();
+
+  auto sample = std::make_shared<WindowSample>();
+  sample->window_size = window_size;
+  sample->windows.resize(windows_count);
+  sample->data.reset(new char[window_size * windows_count]);
+  uint64_t work = static_cast<uint64_t>(windows_count) * window_size;
+  threadpool::parallelFor(ranges.size(), work, [&](size_t range) {
+    size_t begin = static_cast<size_t>(ranges[range].first);
+    size_t count = counts[range];
+    if (count == 0 || isCancelled(sc)) {
+      return;
+    }
+    auto generator = windowsGenerator(0, sc->start + begin);
+    size_t* windows = sample->windows.data() + first_window[range];
+    drawWindows(static_cast<size_t>(ranges[range].second) - begin, count,
+                window_size, &generator, windows);
+    for (size_t i = 0; i < count; ++i) {
+      windows[i] += begin;
+      readData(windows[i], window_size,
+               sample->data.get() + (first_window[range] + i) * window_size,
+               sc);
+    }
+  });
+  if (isCancelled(sc)) {
+    return nullptr;
+  }
+  auto* rd = new ProgressiveSamplerResampleData;
+  rd->sample = std::move(sample);
+  return rd;
+}
+
+void ProgressiveSampler::applyResample(ResampleData* rd) {
+  auto* psrd = static_cast<ProgressiveSamplerResampleData*>(rd);
+  sample_ = std::move(psrd->sample);
+  window_size_ = sample_->window_size;
+  setWindowSample(sample_);
+  delete psrd;
+}
+
+void ProgressiveSampler::cleanupResample(ResampleData* rd) {
+  delete static_cast<ProgressiveSamplerResampleData*>(rd);
+}
+
+ProgressiveSampler* ProgressiveSampler::cloneImpl() const {
+  return new ProgressiveSampler(*this);
+}
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/sample_cache.h"
+
+#include <tuple>
+
+#include "util/sampling/sample_pyramid.h"
+
+namespace veles {
+namespace util {
+
+const size_t SampleCache::k_default_capacity;
+
+bool operator<(const SampleKey& a, const SampleKey& b) {
+  return std::tie(a.method, a.start, a.end, a.sample_size, a.window_size,
+                  a.seed) < std::tie(b.method, b.start, b.end, b.sample_size,
+                                     b.window_size, b.seed);
+}
+
+SampleCache::SampleCache(size_t capacity)
+    : capacity_(capacity), memory_size_(0), misses_(0) {}
+
+std::shared_ptr<const CachedSample> SampleCache::get(const SampleKey& key,
+                                                     const Compute& compute) {
+  std::unique_lock<std::mutex> lc(mutex_);
+  auto it = entries_.find(key);
+  while (it != entries_.end() && it->second.sample == nullptr) {
+    // Someone else is computing it.
+    computed_.wait(lc);
+    it = entries_.find(key);
+  }
+  if (it != entries_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.sample;
+  }
+  ++misses_;
+  entries_.emplace(key, Entry());
+  lc.unlock();
+
+  std::shared_ptr<const CachedSample> sample;
+  try {
+    sample = compute();
+  } catch (...) {
+    lc.lock();
+    entries_.erase(key);
+    computed_.notify_all();
+    throw;
+  }
+
+  lc.lock();
+  it = entries_.find(key);
+  if (sample == nullptr) {
+    entries_.erase(it);
+  } else {
+    it->second.sample = sample;
+    it->second.lru = lru_.insert(lru_.begin(), key);
+    memory_size_ += sample->memorySize();
+    evict();
+  }
+  computed_.notify_all();
+  return sample;
+}
+
+std::shared_ptr<const CachedSample> SampleCache::find(const SampleKey& key) {
+  std::unique_lock<std::mutex> lc(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end() || it->second.sample == nullptr) {
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second.lru);
+  return it->second.sample;
+}
+
+std::shared_ptr<const SamplePyramid> SampleCache::pyramid(
+    const std::shared_ptr<const DataSource>& source, size_t finest_size,
+    uint64_t seed) {
+  PyramidKey key(source.get(), finest_size, seed);
+  std::unique_lock<std::mutex> lc(mutex_);
+  auto it = pyramids_.find(key);
+  while (it != pyramids_.end() && it->second == nullptr) {
+    // Someone else is building it.
+    computed_.wait(lc);
+    it = pyramids_.find(key);
+  }
+  if (it != pyramids_.end()) {
+    return it->second;
+  }
+  pyramids_.emplace(key, nullptr);
+  lc.unlock();
+
+  std::shared_ptr<const SamplePyramid> pyramid;
+  try {
+    pyramid = std::make_shared<SamplePyramid>(source, finest_size, seed);
+  } catch (...) {
+    lc.lock();
+    pyramids_.erase(key);
+    computed_.notify_all();
+    throw;
+  }
+
+  lc.lock();
+  pyramids_[key] = pyramid;
+  computed_.notify_all();
+  return pyramid;
+}
+
+std::shared_ptr<const SamplePyramid> SampleCache::findPyramid(
+    const std::shared_ptr<const DataSource>& source, size_t finest_size,
+    uint64_t seed) {
+  std::unique_lock<std::mutex> lc(mutex_);
+  auto it = pyramids_.find(PyramidKey(source.get(), finest_size, seed));
+  return it != pyramids_.end() ? it->second : nullptr;
+}
+
+void SampleCache::clear() {
+  std::unique_lock<std::mutex> lc(mutex_);
+  for (const auto& key : lru_) {
+    entries_.erase(key);
+  }
+  lru_.clear();
+  memory_size_ = 0;
+  // Like samples, pyramids being built are left for their builders.
+  for (auto it = pyramids_.begin(); it != pyramids_.end();) {
+    if (it->second != nullptr) {
+      it = pyramids_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t SampleCache::memorySize() {
+  std::unique_lock<std::mutex> lc(mutex_);
+  return memory_size_;
+}
+
+size_t SampleCache::misses() {
+  std::unique_lock<std::mutex> lc(mutex_);
+  return misses_;
+}
+
+void SampleCache::evict() {
+  // The newest sample is kept even if it alone exceeds the capacity, so
+  // that samplers asking for it right away (eg. clones) still share it.
+  while (memory_size_ > capacity_ && lru_.size() > 1) {
+    auto it = entries_.find(lru_.back());
+    memory_size_ -= it->second.sample->memorySize();
+    entries_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+}  // namespace util
+}  // namespace veles
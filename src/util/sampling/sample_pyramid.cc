@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/sample_pyramid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "util/concurrency/threadpool.h"
+#include "util/sampling/windows.h"
+
+namespace veles {
+namespace util {
+
+namespace {
+
+// Windows are read in blocks of this many windows.
+const size_t k_windows_per_block = 1024;
+
+}  // namespace
+
+/*****************************************************************************/
+/* SamplePyramid */
+/*****************************************************************************/
+
+const size_t SamplePyramid::k_min_level_windows;
+
+SamplePyramid::SamplePyramid(std::shared_ptr<const DataSource> source,
+                             size_t finest_size, uint64_t seed)
+    : source_(std::move(source)) {
+  size_t size = static_cast<size_t>(source_->size());
+  size_t finest = std::min(finest_size, size);
+  window_size_ =
+      std::max<size_t>(1, static_cast<size_t>(floor(sqrt(finest))));
+  size_t windows_count = finest / window_size_;
+
+  Level finest_level;
+  finest_level.windows.resize(windows_count);
+  finest_level.data.reset(new char[windows_count * window_size_]);
+  auto generator = windowsGenerator(seed, 0);
+  drawWindows(size, windows_count, window_size_, &generator,
+              finest_level.windows.data());
+  size_t blocks =
+      (windows_count + k_windows_per_block - 1) / k_windows_per_block;
+  uint64_t work = static_cast<uint64_t>(windows_count) * window_size_;
+  threadpool::parallelFor(blocks, work, [&](size_t block) {
+    size_t end = std::min(windows_count, (block + 1) * k_windows_per_block);
+    for (size_t i = block * k_windows_per_block; i < end; ++i) {
+      source_->read(finest_level.windows[i], window_size_,
+                    finest_level.data.get() + i * window_size_);
+    }
+  });
+  levels_.push_back(std::move(finest_level));
+
+  while (levels_.back().windows.size() / 2 >= k_min_level_windows) {
+    const Level& previous = levels_.back();
+    size_t count = (previous.windows.size() + 1) / 2;
+    Level level;
+    level.windows.resize(count);
+    level.data.reset(new char[count * window_size_]);
+    for (size_t i = 0; i < count; ++i) {
+      level.windows[i] = previous.windows[2 * i];
+      memcpy(level.data.get() + i * window_size_,
+             previous.data.get() + 2 * i * window_size_, window_size_);
+    }
+    levels_.push_back(std::move(level));
+  }
+}
+
+const std::vector<size_t>& SamplePyramid::windows(size_t level) const {
+  return levels_[level].windows;
+}
+
+const char* SamplePyramid::data(size_t level) const {
+  return levels_[level].data.get();
+}
+
+size_t SamplePyramid::memorySize() const {
+  size_t res = 0;
+  for (const auto& level : levels_) {
+    res += level.windows.size() * window_size_;
+  }
+  return res;
+}
+
+bool SamplePyramid::findLevel(size_t start, size_t end, size_t min_windows,
+                              size_t* level, size_t* first,
+                              size_t* last) const {
+  if (end < start + window_size_) {
+    return false;
+  }
+  // Coarser levels have fewer windows in any range, so the first level
+  // (from the coarsest) that has enough is the one.
+  for (size_t i = levels_.size(); i-- > 0;) {
+    const auto& windows = levels_[i].windows;
+    auto begin = std::lower_bound(windows.begin(), windows.end(), start);
+    auto stop = std::upper_bound(begin, windows.end(), end - window_size_);
+    if (static_cast<size_t>(std::distance(begin, stop)) >= min_windows) {
+      *level = i;
+      *first = static_cast<size_t>(std::distance(windows.begin(), begin));
+      *last = static_cast<size_t>(std::distance(windows.begin(), stop));
+      return true;
+    }
+  }
+  return false;
+}
+
+/*****************************************************************************/
+/* PyramidSampler - public methods */
+/*****************************************************************************/
+
+PyramidSampler::PyramidSampler(std::shared_ptr<const SamplePyramid> pyramid)
+    : ISampler(pyramid->source()), pyramid_(std::move(pyramid)) {}
+
+/*****************************************************************************/
+/* PyramidSampler - private methods */
+/*****************************************************************************/
+
+PyramidSampler::PyramidSampler(const PyramidSampler& other)
+    : ISampler(other), pyramid_(other.pyramid_) {}
+
+char PyramidSampler::getSampleByte(size_t index) const {
+  assert(sample_ != nullptr);
+  return sample_->data[index];
+}
+
+const char* PyramidSampler::getData() const {
+  return sample_ != nullptr ? sample_->data.get() : nullptr;
+}
+
+size_t PyramidSampler::getRealSampleSize() const {
+  return sample_ != nullptr ? sample_->size() : 0;
+}
+
+size_t PyramidSampler::getFileOffsetImpl(size_t index) const {
+  return sample_->fileOffset(index);
+}
+
+size_t PyramidSampler::getSampleOffsetImpl(size_t address) const {
+  return sample_->sampleOffset(address);
+}
+
+ISampler::ResampleData* PyramidSampler::prepareResample(SamplerConfig* sc) {
+  size_t size = getDataSize(sc);
+  size_t sample_size = getRequestedSampleSize(sc);
+  size_t window_size = pyramid_->windowSize();
+  auto sample = std::make_shared<WindowSample>();
+
+  size_t windows_count = std::max<size_t>(1, sample_size / window_size);
+  size_t level, first, last;
+  if (pyramid_->findLevel(sc->start, sc->start + size, windows_count,
+                          &level, &first, &last)) {
+    // The level has between windows_count and 2 * windows_count windows
+    // in range, take windows_count of them evenly.
+    const auto& windows = pyramid_->windows(level);
+    const char* data = pyramid_->data(level);
+    sample->window_size = window_size;
+    sample->windows.resize(windows_count);
+    sample->data.reset(new char[windows_count * window_size]);
+    for (size_t i = 0; i < windows_count; ++i) {
+      size_t index = first + i * (last - first) / windows_count;
+      sample->windows[i] = windows[index] - sc->start;
+      memcpy(sample->data.get() + i * window_size, data + index * window_size,
+             window_size);
+    }
+    auto* rd = new PyramidSamplerResampleData;
+    rd->sample = std::move(sample);
+    return rd;
+  }
+
+  // Zoomed in deeper than the pyramid goes - sample input data.
+  window_size =
+      std::max<size_t>(1, static_cast<size_t>(floor(sqrt(sample_size))));
+  windows_count = sample_size / window_size;
+  sample->window_size = window_size;
+  sample->windows.resize(windows_count);
+  sample->data.reset(new char[windows_count * window_size]);
+  auto generator = windowsGenerator(0, sc->start);
+  drawWindows(size, windows_count, window_size, &generator,
+              sample->windows.data());
+  for (size_t i = 0; i < windows_count; ++i) {
+    if (i % k_windows_per_block == 0 && isCancelled(sc)) {
+      return nullptr;
+    }
+    readData(sample->windows[i], window_size,
+             sample->data.get() + i * window_size, sc);
+  }
+  auto* rd = new PyramidSamplerResampleData;
+  rd->sample = std::move(sample);
+  return rd;
+}
+
+void PyramidSampler::applyResample(ResampleData* rd) {
+  auto* psrd = static_cast<PyramidSamplerResampleData*>(rd);
+  sample_ = std::move(psrd->sample);
+  setWindowSample(sample_);
+  delete psrd;
+}
+
+void PyramidSampler::cleanupResample(ResampleData* rd) {
+  delete static_cast<PyramidSamplerResampleData*>(rd);
+}
+
+PyramidSampler* PyramidSampler::cloneImpl() const {
+  return new PyramidSampler(*this);
+}
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/sample_stats.h"
+
+#include <vector>
+
+#include "util/sampling/data_source.h"
+
+namespace veles {
+namespace util {
+
+bool SampleStats::update(std::shared_ptr<const SampleSnapshot> snapshot) {
+  // Bytes at the same offset are only the same if they come from the same
+  // data, and bytes of a download in progress can still change.
+  const auto& source = snapshot->getSource();
+  auto* progressive =
+      dynamic_cast<const ProgressiveDataSource*>(source.get());
+  if (snapshot_ == nullptr || snapshot_->getSource() != source ||
+      (progressive != nullptr && !progressive->isComplete())) {
+    stats_.clear();
+  }
+
+  std::vector<stats::NgramStats::Window> windows(snapshot->getWindowCount());
+  auto* data = reinterpret_cast<const uint8_t*>(snapshot->data());
+  size_t window_size = snapshot->getWindowSize();
+  for (size_t i = 0; i < windows.size(); ++i) {
+    windows[i].offset = snapshot->getWindowOffset(i);
+    windows[i].data = data + i * window_size;
+    windows[i].size = window_size;
+  }
+  bool res = stats_.setWindows(windows);
+  snapshot_ = std::move(snapshot);
+  return res;
+}
+
+}  // namespace util
+}  // namespace veles
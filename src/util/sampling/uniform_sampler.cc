@@ -17,26 +17,47 @@
 #include "util/sampling/uniform_sampler.h"
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iterator>
+#include <map>
 #include <random>
-#include <set>
+#include <utility>
+
+#include "util/concurrency/threadpool.h"
+#include "util/sampling/windows.h"
 
 namespace veles {
 namespace util {
 
+namespace {
+
+const size_t k_new_window = SIZE_MAX;
+
+}  // namespace
+
 /*****************************************************************************/
 /* Public methods */
 /*****************************************************************************/
 
 UniformSampler::UniformSampler(const QByteArray& data)
     : ISampler(data),
+      seed_(0),
       window_size_(0),
+      windows_count_(0),
       use_default_window_size_(true),
-      buffer_(nullptr) {}
+      incremental_(false) {}
 
-UniformSampler::~UniformSampler() { delete[] buffer_; }
+UniformSampler::UniformSampler(std::shared_ptr<const DataSource> source)
+    : ISampler(std::move(source)),
+      seed_(0),
+      window_size_(0),
+      windows_count_(0),
+      use_default_window_size_(true),
+      incremental_(false) {}
 
 void UniformSampler::setWindowSize(size_t size) {
   auto lc = waitAndLock();
@@ -45,115 +66,292 @@ void UniformSampler::setWindowSize(size_t size) {
   resample();
 }
 
+void UniformSampler::setSeed(uint64_t seed) {
+  auto lc = waitAndLock();
+  seed_ = seed;
+  resample();
+}
+
+void UniformSampler::setIncrementalResampling(bool incremental) {
+  auto lc = lock();
+  incremental_ = incremental;
+}
+
 /*****************************************************************************/
 /* Private methods */
 /*****************************************************************************/
 
 UniformSampler::UniformSampler(const UniformSampler& other)
-    : ISampler(other), window_size_(other.window_size_), buffer_(nullptr) {}
+    : ISampler(other),
+      seed_(other.seed_),
+      window_size_(other.window_size_),
+      windows_count_(0),
+      use_default_window_size_(other.use_default_window_size_),
+      incremental_(other.incremental_) {}
 
 char UniformSampler::getSampleByte(size_t index) const {
-  if (buffer_ != nullptr) {
-    return buffer_[index];
-  }
-  size_t base_index = windows_[index / window_size_];
-  return getDataByte(base_index + (index % window_size_));
+  assert(sample_ != nullptr);
+  return sample_->data[index];
 }
 
-const char* UniformSampler::getData() const { return buffer_; }
+const char* UniformSampler::getData() const {
+  return sample_ != nullptr ? sample_->data.get() : nullptr;
+}
 
 size_t UniformSampler::getRealSampleSize() const {
   return window_size_ * windows_count_;
 }
 
 size_t UniformSampler::getFileOffsetImpl(size_t index) const {
-  size_t base_index = windows_[index / window_size_];
-  return base_index + (index % window_size_);
+  return sample_->fileOffset(index);
 }
 
 size_t UniformSampler::getSampleOffsetImpl(size_t address) const {
-  // we want the last window less or equal to address (or first window if
-  // no such window exists)
-  if (address < windows_[0]) {
-    return 0;
-  }
-  auto previous_window =
-      std::upper_bound(windows_.begin(), windows_.end(), address);
-  if (previous_window != windows_.begin()) {
-    --previous_window;
-  }
-  size_t base_index = static_cast<size_t>(
-      std::distance(windows_.begin(), previous_window) * window_size_);
-  return base_index + std::min(window_size_ - 1, address - (*previous_window));
+  return sample_->sampleOffset(address);
 }
 
 ISampler::ResampleData* UniformSampler::prepareResample(SamplerConfig* sc) {
   size_t size = getRequestedSampleSize(sc);
   size_t window_size = window_size_;
   if (use_default_window_size_ || window_size_ == 0) {
-    window_size = static_cast<size_t>(floor(sqrt(size)));
+    window_size = std::max<size_t>(1, static_cast<size_t>(floor(sqrt(size))));
   }
   size_t windows_count = size / window_size;
-  size = window_size * windows_count;
-  std::vector<size_t> windows(windows_count);
-
-  // Algorithm:
-  // First let's mark windows_count_ as m, window_size_ as k and
-  // getDataSize() as n.
-  // 1. Take m numbers from {0, 1 ... n - m*k} with repetitions,
-  //    marked as (c_i) sequence.
-  // 2. Sort (c_i) sequence.
-  // 3. Produce the result indices (d_i) in the following way:
-  //    d_i = c_i + i*k
-  //
-  // And why that works:
-  // - The smallest value of d_0 is 0.
-  // - The largest value of d_{m-1} is
-  //   n - m*k + (m-1)*k = n - k
-  //   which is exactly what we want because the piece length is k.
-  // - For each i the distance d_{i+1}-d_i >= k.
+
+  SampleKey key{"uniform", sc->start, sc->start + getDataSize(sc), size,
+                window_size, seed_};
+  std::shared_ptr<const Sample> sample;
+  if (incremental_) {
+    // An incremental sample depends on the previous one and not only on
+    // the key, so it's never cached. A cached sample is still used.
+    sample = std::static_pointer_cast<const Sample>(findCachedSample(key));
+    if (sample == nullptr) {
+      sample = computeSample(sc, window_size, windows_count);
+    }
+  } else {
+    sample = std::static_pointer_cast<const Sample>(cachedSample(
+        key, [&]() { return computeSample(sc, window_size, windows_count); }));
+  }
+  if (sample == nullptr) {
+    return nullptr;
+  }
+
+  auto* rd = new UniformSamplerResampleData;
+  rd->sample = std::move(sample);
+  return rd;
+}
+
+std::shared_ptr<const UniformSampler::Sample> UniformSampler::computeSample(
+    SamplerConfig* sc, size_t window_size, size_t windows_count) {
+  auto sample = std::make_shared<Sample>();
+  sample->seed = seed_;
+  sample->start = sc->start;
+  sample->end = sc->start + getDataSize(sc);
+  sample->window_size = window_size;
+  sample->data.reset(new char[window_size * windows_count]);
+
+  std::shared_ptr<const Sample> previous;
+  if (incremental_) {
+    auto lc = lock();
+    previous = sample_;
+  }
+  std::vector<size_t> reused;
+  if (previous == nullptr ||
+      !reuseWindows(*previous, windows_count, sc, sample.get(), &reused)) {
+    previous = nullptr;
+    drawWindows(windows_count, sc, sample.get());
+    reused.assign(windows_count, k_new_window);
+  }
+  if (isCancelled(sc)) {
+    return nullptr;
+  }
+  copyWindows(previous.get(), reused, sc, sample.get());
+  if (isCancelled(sc)) {
+    return nullptr;
+  }
+  return sample;
+}
+
+void UniformSampler::drawWindows(size_t windows_count, SamplerConfig* sc,
+                                 Sample* sample) const {
+  size_t window_size = sample->window_size;
+  auto& windows = sample->windows;
+  windows.resize(windows_count);
+
+  // Offsets are drawn in blocks, each with its own generator, and then
+  // spread together as in util::drawWindows().
   size_t max_index = getDataSize(sc) - windows_count * window_size;
-  std::default_random_engine generator;
-  std::uniform_int_distribution<size_t> distribution(0, max_index);
-  for (size_t i = 0; i < windows_count; ++i) {
-    windows[i] = distribution(generator);
+  size_t blocks =
+      (windows_count + k_windows_per_block - 1) / k_windows_per_block;
+  uint64_t seed = seed_;
+  // Drawing a window costs about as much as copying a few dozen bytes.
+  threadpool::parallelFor(blocks, windows_count * 64, [&](size_t block) {
+    if (isCancelled(sc)) {
+      return;
+    }
+    auto generator = windowsGenerator(seed, block);
+    size_t first = block * k_windows_per_block;
+    size_t end = std::min(windows_count, first + k_windows_per_block);
+    drawWindowOffsets(max_index, end - first, &generator,
+                      windows.data() + first);
+  });
+  spreadWindows(windows_count, window_size, windows.data());
+}
+
+bool UniformSampler::reuseWindows(const Sample& previous,
+                                  size_t windows_count, SamplerConfig* sc,
+                                  Sample* sample,
+                                  std::vector<size_t>* reused) const {
+  size_t window_size = sample->window_size;
+  size_t start = sample->start;
+  size_t size = sample->end - sample->start;
+  // Placing windows at random positions only works well while they are
+  // sparse.
+  if (previous.seed != sample->seed || previous.window_size != window_size ||
+      windows_count == 0 || 2 * windows_count * window_size > size) {
+    return false;
   }
-  std::sort(windows.begin(), windows.end());
-  for (size_t i = 0; i < windows_count; ++i) {
-    windows[i] += i * window_size;
+  size_t overlap_begin = std::max(start, previous.start);
+  size_t overlap_end = std::min(sample->end, previous.end);
+  if (overlap_begin + window_size > overlap_end) {
+    return false;
   }
+  overlap_begin -= start;
+  overlap_end -= start;
 
-  // Now let's create data array (it's more efficient to do it here,
-  // than later calculate values)
-  const char* raw_data = getRawData(sc);
-  auto* tmp_buffer = new char[size];
-  for (size_t i = 0; i < size; ++i) {
-    size_t base_index = windows[i / window_size];
-    tmp_buffer[i] = raw_data[base_index + (i % window_size)];
+  // Window offset -> index in previous, for all previous windows that
+  // fit in the new range.
+  std::vector<std::pair<size_t, size_t>> kept;
+  for (size_t i = 0; i < previous.windows.size(); ++i) {
+    size_t offset = previous.start + previous.windows[i];
+    if (offset >= start && offset + window_size <= sample->end) {
+      kept.emplace_back(offset - start, i);
+    }
   }
 
-  auto* rd = new UniformSamplerResampleData;
-  rd->window_size = window_size;
-  rd->windows_count = windows_count;
-  rd->windows = std::move(windows);
-  rd->data = tmp_buffer;
-  return rd;
+  // The overlap should end up with its share of windows. If the range grew
+  // it has more than that, and a random subset of them is dropped.
+  auto generator = windowsGenerator(sample->seed, sc->start, sc->end);
+  size_t outside = size - (overlap_end - overlap_begin);
+  size_t overlap_share = windows_count;
+  if (outside >= window_size) {
+    overlap_share = static_cast<size_t>(
+        static_cast<double>(windows_count) * (overlap_end - overlap_begin) /
+            size +
+        0.5);
+  }
+  if (kept.size() > overlap_share) {
+    std::shuffle(kept.begin(), kept.end(), generator);
+    kept.resize(overlap_share);
+  }
+
+  std::map<size_t, size_t> windows(kept.begin(), kept.end());
+  // Draws `count` new windows starting within the given segments, with
+  // probability proportional to segment length.
+  auto place = [&](size_t count,
+                   const std::vector<std::pair<size_t, size_t>>& segments) {
+    size_t total = 0;
+    for (const auto& segment : segments) {
+      total += segment.second - segment.first;
+    }
+    if (count == 0) {
+      return true;
+    }
+    if (total == 0) {
+      return false;
+    }
+    std::uniform_int_distribution<size_t> distribution(0, total - 1);
+    size_t attempts = 32 * count + 64;
+    while (count > 0) {
+      if (attempts-- == 0) {
+        return false;
+      }
+      size_t pos = distribution(generator);
+      for (const auto& segment : segments) {
+        size_t length = segment.second - segment.first;
+        if (pos < length) {
+          pos += segment.first;
+          break;
+        }
+        pos -= length;
+      }
+      auto next = windows.lower_bound(pos);
+      if (next != windows.end() && next->first < pos + window_size) {
+        continue;
+      }
+      if (next != windows.begin() &&
+          std::prev(next)->first + window_size > pos) {
+        continue;
+      }
+      windows.emplace_hint(next, pos, k_new_window);
+      --count;
+    }
+    return true;
+  };
+
+  // Segments are clipped so that windows starting in them fit in the range.
+  size_t last = size - window_size + 1;
+  std::vector<std::pair<size_t, size_t>> outside_segments;
+  if (overlap_begin > 0) {
+    outside_segments.emplace_back(0, std::min(overlap_begin, last));
+  }
+  if (overlap_end < last) {
+    outside_segments.emplace_back(overlap_end, last);
+  }
+  size_t overlap_missing = overlap_share - kept.size();
+  if (!place(overlap_missing,
+             {{overlap_begin, overlap_end - window_size + 1}}) ||
+      !place(windows_count - overlap_share, outside_segments)) {
+    return false;
+  }
+
+  sample->windows.clear();
+  sample->windows.reserve(windows_count);
+  reused->clear();
+  reused->reserve(windows_count);
+  for (const auto& window : windows) {
+    sample->windows.push_back(window.first);
+    reused->push_back(window.second);
+  }
+  return true;
+}
+
+void UniformSampler::copyWindows(const Sample* previous,
+                                 const std::vector<size_t>& reused,
+                                 SamplerConfig* sc, Sample* sample) const {
+  size_t window_size = sample->window_size;
+  size_t windows_count = sample->windows.size();
+  size_t blocks =
+      (windows_count + k_windows_per_block - 1) / k_windows_per_block;
+  uint64_t work = static_cast<uint64_t>(windows_count) * window_size;
+  threadpool::parallelFor(blocks, work, [&](size_t block) {
+    if (isCancelled(sc)) {
+      return;
+    }
+    size_t end = std::min(windows_count, (block + 1) * k_windows_per_block);
+    for (size_t i = block * k_windows_per_block; i < end; ++i) {
+      char* out = sample->data.get() + i * window_size;
+      if (reused[i] != k_new_window) {
+        memcpy(out, previous->data.get() + reused[i] * window_size,
+               window_size);
+      } else {
+        readData(sample->windows[i], window_size, out, sc);
+      }
+    }
+  });
 }
 
 void UniformSampler::applyResample(ResampleData* rd) {
-  delete[] buffer_;
   auto* usrd = static_cast<UniformSamplerResampleData*>(rd);
-  window_size_ = usrd->window_size;
-  windows_count_ = usrd->windows_count;
-  windows_ = std::move(usrd->windows);
-  buffer_ = usrd->data;
+  sample_ = std::move(usrd->sample);
+  window_size_ = sample_->window_size;
+  windows_count_ = sample_->windows.size();
+  setWindowSample(sample_);
   delete usrd;
 }
 
 void UniformSampler::cleanupResample(ResampleData* rd) {
-  auto* usrd = static_cast<UniformSamplerResampleData*>(rd);
-  delete[] usrd->data;
-  delete usrd;
+  delete static_cast<UniformSamplerResampleData*>(rd);
 }
 
 UniformSampler* UniformSampler::cloneImpl() const {
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/windows.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace veles {
+namespace util {
+
+std::vector<size_t> allocateWindows(size_t windows_count,
+                                    const std::vector<double>& weights,
+                                    const std::vector<size_t>& capacities) {
+  assert(weights.size() == capacities.size());
+  size_t parts = weights.size();
+  std::vector<size_t> counts(parts, 0);
+  size_t total_capacity = 0;
+  for (size_t capacity : capacities) {
+    total_capacity += capacity;
+  }
+  if (total_capacity <= windows_count) {
+    return capacities;
+  }
+
+  // Parts whose proportional share exceeds their capacity are filled up,
+  // and the rest of the windows is split again between the other parts,
+  // until all shares fit.
+  std::vector<bool> full(parts, false);
+  std::vector<double> shares(parts, 0);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    size_t left = windows_count;
+    double weight = 0;
+    for (size_t i = 0; i < parts; ++i) {
+      if (full[i]) {
+        left -= capacities[i];
+      } else {
+        weight += weights[i];
+      }
+    }
+    for (size_t i = 0; i < parts; ++i) {
+      if (full[i]) {
+        continue;
+      }
+      shares[i] = weight > 0 ? left * weights[i] / weight : 0;
+      if (shares[i] >= capacities[i]) {
+        full[i] = true;
+        changed = true;
+      }
+    }
+  }
+
+  size_t allocated = 0;
+  for (size_t i = 0; i < parts; ++i) {
+    counts[i] = full[i] ? capacities[i] : static_cast<size_t>(shares[i]);
+    allocated += counts[i];
+  }
+  // Hand out what's left after rounding down by largest remainder. There
+  // is always room for it, as total capacity exceeds windows_count.
+  std::vector<size_t> order;
+  for (size_t i = 0; i < parts; ++i) {
+    if (counts[i] < capacities[i]) {
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return shares[a] - std::floor(shares[a]) >
+           shares[b] - std::floor(shares[b]);
+  });
+  for (size_t i = 0; allocated < windows_count; i = (i + 1) % order.size()) {
+    if (counts[order[i]] < capacities[order[i]]) {
+      ++counts[order[i]];
+      ++allocated;
+    }
+  }
+  return counts;
+}
+
+void drawWindows(size_t length, size_t count, size_t window_size,
+                 std::mt19937_64* generator, size_t* out) {
+  assert(count * window_size <= length);
+  drawWindowOffsets(length - count * window_size, count, generator, out);
+  spreadWindows(count, window_size, out);
+}
+
+void drawWindowOffsets(size_t max_offset, size_t count,
+                       std::mt19937_64* generator, size_t* out) {
+  std::uniform_int_distribution<size_t> distribution(0, max_offset);
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = distribution(*generator);
+  }
+}
+
+void spreadWindows(size_t count, size_t window_size, size_t* out) {
+  // Algorithm:
+  // First let's mark count as m, window_size as k and the length of the
+  // range as n. The numbers were drawn from {0, 1 ... n - m*k}.
+  // 1. Sort the numbers, marked as (c_i) sequence.
+  // 2. Produce the result offsets (d_i) in the following way:
+  //    d_i = c_i + i*k
+  //
+  // And why that works:
+  // - The smallest value of d_0 is 0.
+  // - The largest value of d_{m-1} is
+  //   n - m*k + (m-1)*k = n - k
+  //   which is exactly what we want because the piece length is k.
+  // - For each i the distance d_{i+1}-d_i >= k.
+  std::sort(out, out + count);
+  for (size_t i = 0; i < count; ++i) {
+    out[i] += i * window_size;
+  }
+}
+
+std::mt19937_64 windowsGenerator(uint64_t seed, uint64_t part,
+                                 uint64_t subpart) {
+  std::array<uint32_t, 6> words = {
+      {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+       static_cast<uint32_t>(part), static_cast<uint32_t>(part >> 32),
+       static_cast<uint32_t>(subpart), static_cast<uint32_t>(subpart >> 32)}};
+  std::seed_seq seq(words.begin(), words.end());
+  return std::mt19937_64(seq);
+}
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,320 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/stats/byte_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "util/concurrency/threadpool.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VELES_STATS_SSE2 1
+#endif
+
+namespace veles {
+namespace util {
+namespace stats {
+
+namespace {
+
+/** Inputs are split between threads in chunks of at least this size.
+    Below that, starting a thread costs more than it saves.  */
+const size_t k_parallel_min_chunk = 4 << 20;
+
+/** Digram counting is slower per byte (its tables don't fit in L1), so it
+    pays off to split smaller inputs, even though each extra chunk costs a
+    merge of its own tables (up to 1 MiB).  */
+const size_t k_digram_min_chunk = 1 << 20;
+
+/** Number of chunks to split an input of the given size into.  */
+size_t numChunks(size_t size, size_t min_chunk = k_parallel_min_chunk) {
+  // Inputs below min_chunk are common (eg. a minimap pixel), don't even ask
+  // for the thread count then.
+  if (size < 2 * min_chunk) {
+    return 1;
+  }
+  return std::min(threadpool::parallelism(), size / min_chunk);
+}
+
+/** Runs func(chunk, begin, end) in parallel for num_chunks equal chunks of
+    [0, size).  Returns once all of them are done.  */
+template <typename Func>
+void runChunks(size_t size, size_t num_chunks, const Func& func) {
+  size_t chunk_size = size / num_chunks;
+  threadpool::parallelFor(num_chunks, [&](size_t chunk) {
+    size_t begin = chunk * chunk_size;
+    size_t end = chunk + 1 == num_chunks ? size : begin + chunk_size;
+    func(chunk, begin, end);
+  });
+}
+
+inline uint64_t load64(const uint8_t* p) {
+  uint64_t res;
+  memcpy(&res, p, sizeof(res));
+  return res;
+}
+
+/** Counts into four sub-histograms with 32-bit counters, each getting every
+    fourth byte.  Consecutive equal bytes then increment different counters,
+    so they don't wait for each other's stores, and the tables together take
+    only 4 KiB.  */
+void histogramSerial(const uint8_t* data, size_t size, ByteHistogram* hist) {
+  // Each counter gets at most a quarter of a block, so it can't overflow.
+  const size_t k_block_size = size_t(1) << 31;
+  uint32_t sub[4][256];
+  while (size > 0) {
+    size_t block = std::min(size, k_block_size);
+    memset(sub, 0, sizeof(sub));
+    size_t i = 0;
+    for (; i + 8 <= block; i += 8) {
+      uint64_t word = load64(data + i);
+      sub[0][word & 0xff]++;
+      sub[1][(word >> 8) & 0xff]++;
+      sub[2][(word >> 16) & 0xff]++;
+      sub[3][(word >> 24) & 0xff]++;
+      sub[0][(word >> 32) & 0xff]++;
+      sub[1][(word >> 40) & 0xff]++;
+      sub[2][(word >> 48) & 0xff]++;
+      sub[3][word >> 56]++;
+    }
+    for (; i < block; i++) {
+      sub[0][data[i]]++;
+    }
+    for (int v = 0; v < 256; v++) {
+      (*hist)[v] += uint64_t(sub[0][v]) + sub[1][v] + sub[2][v] + sub[3][v];
+    }
+    data += block;
+    size -= block;
+  }
+}
+
+/** Digram counts for pairs starting at positions [begin, end).  */
+void digramSerial(const uint8_t* data, size_t begin, size_t end,
+                  uint64_t* counts, uint64_t* position_sums) {
+  if (position_sums == nullptr) {
+    for (size_t i = begin; i < end; i++) {
+      counts[data[i] << 8 | data[i + 1]]++;
+    }
+    return;
+  }
+  for (size_t i = begin; i < end; i++) {
+    size_t index = data[i] << 8 | data[i + 1];
+    counts[index]++;
+    position_sums[index] += i;
+  }
+}
+
+uint64_t sumSerial(const uint8_t* data, size_t size) {
+  uint64_t res = 0;
+  size_t i = 0;
+#ifdef VELES_STATS_SSE2
+  // psadbw against zero sums each group of 8 bytes into a 64-bit lane.
+  __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  for (; i + 16 <= size; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+  }
+  res = static_cast<uint64_t>(_mm_cvtsi128_si64(acc)) +
+        static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+#endif
+  for (; i < size; i++) {
+    res += data[i];
+  }
+  return res;
+}
+
+MinMax minMaxSerial(const uint8_t* data, size_t size) {
+  MinMax res = {data[0], data[0]};
+  size_t i = 0;
+#ifdef VELES_STATS_SSE2
+  if (size >= 16) {
+    __m128i vmin = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i vmax = vmin;
+    for (i = 16; i + 16 <= size; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      vmin = _mm_min_epu8(vmin, v);
+      vmax = _mm_max_epu8(vmax, v);
+    }
+    uint8_t mins[16], maxs[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), vmin);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+    res.min = *std::min_element(mins, mins + 16);
+    res.max = *std::max_element(maxs, maxs + 16);
+  }
+#endif
+  for (; i < size; i++) {
+    res.min = std::min(res.min, data[i]);
+    res.max = std::max(res.max, data[i]);
+  }
+  return res;
+}
+
+}  // namespace
+
+void accumulateHistogram(const uint8_t* data, size_t size,
+                         ByteHistogram* hist) {
+  size_t num_chunks = numChunks(size);
+  if (num_chunks == 1) {
+    histogramSerial(data, size, hist);
+    return;
+  }
+  std::vector<ByteHistogram> partial(num_chunks);
+  runChunks(size, num_chunks, [&](size_t chunk, size_t begin, size_t end) {
+    partial[chunk].fill(0);
+    histogramSerial(data + begin, end - begin, &partial[chunk]);
+  });
+  for (const auto& part : partial) {
+    for (int v = 0; v < 256; v++) {
+      (*hist)[v] += part[v];
+    }
+  }
+}
+
+ByteHistogram histogram(const uint8_t* data, size_t size) {
+  ByteHistogram res;
+  res.fill(0);
+  accumulateHistogram(data, size, &res);
+  return res;
+}
+
+void digramHistogram(const uint8_t* data, size_t size, uint64_t* counts,
+                     uint64_t* position_sums) {
+  const size_t k_bins = 256 * 256;
+  memset(counts, 0, k_bins * sizeof(*counts));
+  if (position_sums != nullptr) {
+    memset(position_sums, 0, k_bins * sizeof(*position_sums));
+  }
+  if (size < 2) {
+    return;
+  }
+  size_t pairs = size - 1;
+  size_t num_chunks = numChunks(pairs, k_digram_min_chunk);
+  if (num_chunks == 1) {
+    digramSerial(data, 0, pairs, counts, position_sums);
+    return;
+  }
+  // Every chunk but the first counts into its own tables, which are added
+  // up at the end.
+  size_t tables = position_sums == nullptr ? 1 : 2;
+  std::unique_ptr<uint64_t[]> partial(
+      new uint64_t[(num_chunks - 1) * tables * k_bins]());
+  runChunks(pairs, num_chunks, [&](size_t chunk, size_t begin, size_t end) {
+    if (chunk == 0) {
+      digramSerial(data, begin, end, counts, position_sums);
+      return;
+    }
+    uint64_t* own = partial.get() + (chunk - 1) * tables * k_bins;
+    digramSerial(data, begin, end, own,
+                 position_sums == nullptr ? nullptr : own + k_bins);
+  });
+  for (size_t chunk = 1; chunk < num_chunks; chunk++) {
+    const uint64_t* own = partial.get() + (chunk - 1) * tables * k_bins;
+    for (size_t i = 0; i < k_bins; i++) {
+      counts[i] += own[i];
+    }
+    if (position_sums != nullptr) {
+      for (size_t i = 0; i < k_bins; i++) {
+        position_sums[i] += own[k_bins + i];
+      }
+    }
+  }
+}
+
+double entropy(const ByteHistogram& hist, uint64_t total) {
+  if (total == 0) {
+    return 0.0;
+  }
+  double res = 0.0;
+  for (uint64_t count : hist) {
+    if (count > 0) {
+      double p = static_cast<double>(count) / total;
+      res -= p * std::log2(p);
+    }
+  }
+  return res;
+}
+
+double entropy(const uint8_t* data, size_t size) {
+  return entropy(histogram(data, size), size);
+}
+
+constexpr double EntropyTable::k_term_scale;
+
+EntropyTable::EntropyTable(uint64_t max_size) : terms_(max_size + 1) {
+  terms_[0] = 0;
+  for (uint64_t n = 1; n <= max_size; ++n) {
+    double term = static_cast<double>(n) * std::log2(static_cast<double>(n));
+    terms_[n] = std::llround(term * k_term_scale);
+  }
+}
+
+double EntropyTable::entropy(const ByteHistogram& hist, uint64_t total) const {
+  int64_t term_sum = 0;
+  for (uint64_t count : hist) {
+    term_sum += terms_[count];
+  }
+  return entropy(term_sum, total);
+}
+
+uint64_t sum(const uint8_t* data, size_t size) {
+  size_t num_chunks = numChunks(size);
+  if (num_chunks == 1) {
+    return sumSerial(data, size);
+  }
+  std::vector<uint64_t> partial(num_chunks);
+  runChunks(size, num_chunks, [&](size_t chunk, size_t begin, size_t end) {
+    partial[chunk] = sumSerial(data + begin, end - begin);
+  });
+  uint64_t res = 0;
+  for (uint64_t part : partial) {
+    res += part;
+  }
+  return res;
+}
+
+double mean(const uint8_t* data, size_t size) {
+  if (size == 0) {
+    return 0.0;
+  }
+  return static_cast<double>(sum(data, size)) / size;
+}
+
+MinMax minMax(const uint8_t* data, size_t size) {
+  size_t num_chunks = numChunks(size);
+  if (num_chunks == 1) {
+    return minMaxSerial(data, size);
+  }
+  std::vector<MinMax> partial(num_chunks);
+  runChunks(size, num_chunks, [&](size_t chunk, size_t begin, size_t end) {
+    partial[chunk] = minMaxSerial(data + begin, end - begin);
+  });
+  MinMax res = partial[0];
+  for (const auto& part : partial) {
+    res.min = std::min(res.min, part.min);
+    res.max = std::max(res.max, part.max);
+  }
+  return res;
+}
+
+}  // namespace stats
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/stats/ngram_stats.h"
+
+#include <algorithm>
+
+#include "util/concurrency/threadpool.h"
+
+namespace veles {
+namespace util {
+namespace stats {
+
+namespace {
+
+/** Runs of n-grams at least this long are counted with the kernels of
+    byte_stats.h (which split large inputs between threads) into temporary
+    tables.  Shorter ones are cheaper to count directly.  */
+const uint64_t k_kernel_min_size = 64 << 10;
+
+/** Trigrams are split between threads in chunks of at least this size.  */
+const uint64_t k_parallel_min_chunk = 4 << 20;
+
+/** When everything is counted again, windows are split between threads in
+    chunks of at least this many bytes - each thread counts into its own
+    tables, which take a while to add up.  */
+const uint64_t k_count_all_min_chunk = 512 << 10;
+
+/** Counts get this added for every n-gram - 1, or -1 (wrapping around)
+    when n-grams are subtracted.  */
+uint64_t delta(bool subtract) { return subtract ? ~uint64_t(0) : 1; }
+
+void countTrigramsSerial(const uint8_t* data, uint64_t starts, uint64_t delta,
+                         uint64_t* cells) {
+  for (uint64_t i = 0; i < starts; ++i) {
+    cells[NgramStats::trigramCell(data[i], data[i + 1], data[i + 2])] +=
+        delta;
+  }
+}
+
+}  // namespace
+
+const int NgramStats::k_trigram_grid_bits;
+const size_t NgramStats::k_trigram_grid_size;
+
+void NgramStats::OffsetSum::addProduct(uint64_t count, uint64_t value,
+                                       bool negative) {
+  // 64 x 64 -> 128 bit multiplication from 32-bit halves.
+  const uint64_t mask = 0xffffffff;
+  uint64_t low_low = (count & mask) * (value & mask);
+  uint64_t high_low = (count >> 32) * (value & mask);
+  uint64_t low_high = (count & mask) * (value >> 32);
+  uint64_t high_high = (count >> 32) * (value >> 32);
+  uint64_t cross = (low_low >> 32) + (high_low & mask) + low_high;
+  uint64_t product_high = high_high + (high_low >> 32) + (cross >> 32);
+  uint64_t product_low = (cross << 32) | (low_low & mask);
+  if (negative) {
+    high -= product_high;
+    subtract(product_low);
+  } else {
+    high += product_high;
+    add(product_low);
+  }
+}
+
+NgramStats::Counts::Counts(int max_order)
+    : digrams(max_order >= 2 ? 256 * 256 : 0),
+      digram_offset_sums(digrams.size()),
+      trigrams(max_order >= 3 ? k_trigram_grid_size * k_trigram_grid_size *
+                                    k_trigram_grid_size
+                              : 0) {
+  bytes.fill(0);
+}
+
+void NgramStats::Counts::clear() {
+  bytes.fill(0);
+  std::fill(digrams.begin(), digrams.end(), 0);
+  std::fill(digram_offset_sums.begin(), digram_offset_sums.end(),
+            OffsetSum());
+  std::fill(trigrams.begin(), trigrams.end(), 0);
+}
+
+void NgramStats::Counts::add(const Counts& other) {
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] += other.bytes[i];
+  }
+  for (size_t i = 0; i < digrams.size(); ++i) {
+    if (other.digrams[i] != 0) {
+      digrams[i] += other.digrams[i];
+      digram_offset_sums[i].add(other.digram_offset_sums[i]);
+    }
+  }
+  for (size_t i = 0; i < trigrams.size(); ++i) {
+    trigrams[i] += other.trigrams[i];
+  }
+}
+
+NgramStats::NgramStats(int max_order)
+    : max_order_(std::min(3, std::max(1, max_order))),
+      size_(0),
+      counts_(max_order_) {}
+
+void NgramStats::clear() {
+  windows_.clear();
+  size_ = 0;
+  counts_.clear();
+}
+
+bool NgramStats::setWindows(const std::vector<Window>& windows) {
+  // Starts of n-grams to subtract and to add, for n = 1, 2, 3.
+  std::vector<Starts> removed[3], added[3];
+  auto orders = static_cast<size_t>(max_order_);
+  uint64_t changed = 0, total = 0;
+  for (size_t n = 1; n <= orders; ++n) {
+    auto old_starts = ngramStarts(windows_, n);
+    auto new_starts = ngramStarts(windows, n);
+    removed[n - 1] = subtract(old_starts, new_starts);
+    added[n - 1] = subtract(new_starts, old_starts);
+    for (const auto& starts : removed[n - 1]) {
+      changed += starts.end - starts.begin;
+    }
+    for (const auto& starts : added[n - 1]) {
+      changed += starts.end - starts.begin;
+    }
+    for (const auto& starts : new_starts) {
+      total += starts.end - starts.begin;
+    }
+  }
+  bool incremental = changed <= total && !windows_.empty();
+  // From now on, starts point into windows_ or windows, so the new windows
+  // can't replace windows_ until they're all counted.
+  std::vector<Window> previous;
+  previous.swap(windows_);
+  if (incremental) {
+    for (size_t n = 1; n <= orders; ++n) {
+      for (const auto& starts : removed[n - 1]) {
+        count(n, starts, true, &counts_);
+      }
+      for (const auto& starts : added[n - 1]) {
+        count(n, starts, false, &counts_);
+      }
+    }
+  } else {
+    clear();
+    for (size_t n = 1; n <= orders; ++n) {
+      added[n - 1] = ngramStarts(windows, n);
+    }
+    countAll(added);
+  }
+  windows_ = windows;
+  size_ = 0;
+  for (const auto& window : windows_) {
+    size_ += window.size;
+  }
+  return incremental;
+}
+
+void NgramStats::countAll(const std::vector<Starts>* added) {
+  auto orders = static_cast<size_t>(max_order_);
+  uint64_t totals[3] = {0, 0, 0};
+  for (size_t n = 1; n <= orders; ++n) {
+    for (const auto& starts : added[n - 1]) {
+      totals[n - 1] += starts.end - starts.begin;
+    }
+  }
+  size_t num_chunks = static_cast<size_t>(std::min<uint64_t>(
+      threadpool::parallelism(), totals[0] / k_count_all_min_chunk));
+  if (num_chunks <= 1) {
+    for (size_t n = 1; n <= orders; ++n) {
+      for (const auto& starts : added[n - 1]) {
+        count(n, starts, false, &counts_);
+      }
+    }
+    return;
+  }
+  std::vector<Counts> partial(num_chunks, Counts(max_order_));
+  threadpool::parallelFor(num_chunks, [&](size_t chunk) {
+    for (size_t n = 1; n <= orders; ++n) {
+      uint64_t total = totals[n - 1];
+      for (const auto& starts :
+           slice(added[n - 1], total * chunk / num_chunks,
+                 total * (chunk + 1) / num_chunks)) {
+        count(n, starts, false, &partial[chunk]);
+      }
+    }
+  });
+  for (const auto& counts : partial) {
+    counts_.add(counts);
+  }
+}
+
+std::vector<NgramStats::Starts> NgramStats::ngramStarts(
+    const std::vector<Window>& windows, size_t n) {
+  std::vector<Starts> res;
+  res.reserve(windows.size());
+  for (const auto& window : windows) {
+    if (window.size >= n) {
+      res.push_back(
+          Starts{window.offset, window.offset + window.size - n + 1, &window});
+    }
+  }
+  return res;
+}
+
+std::vector<NgramStats::Starts> NgramStats::subtract(
+    const std::vector<Starts>& a, const std::vector<Starts>& b) {
+  std::vector<Starts> res;
+  size_t first = 0;
+  for (const auto& starts : a) {
+    uint64_t pos = starts.begin;
+    while (first < b.size() && b[first].end <= pos) {
+      ++first;
+    }
+    for (size_t i = first; i < b.size() && b[i].begin < starts.end; ++i) {
+      if (b[i].begin > pos) {
+        res.push_back(Starts{pos, b[i].begin, starts.window});
+      }
+      pos = std::max(pos, b[i].end);
+      if (pos >= starts.end) {
+        break;
+      }
+    }
+    if (pos < starts.end) {
+      res.push_back(Starts{pos, starts.end, starts.window});
+    }
+  }
+  return res;
+}
+
+std::vector<NgramStats::Starts> NgramStats::slice(
+    const std::vector<Starts>& starts, uint64_t first, uint64_t last) {
+  std::vector<Starts> res;
+  uint64_t pos = 0;
+  for (const auto& run : starts) {
+    uint64_t size = run.end - run.begin;
+    uint64_t begin = std::max(first, pos), end = std::min(last, pos + size);
+    if (begin < end) {
+      res.push_back(Starts{run.begin + (begin - pos), run.begin + (end - pos),
+                           run.window});
+    }
+    pos += size;
+    if (pos >= last) {
+      break;
+    }
+  }
+  return res;
+}
+
+void NgramStats::count(size_t n, const Starts& starts, bool subtract,
+                       Counts* counts) {
+  switch (n) {
+    case 1:
+      countBytes(starts, subtract, counts);
+      break;
+    case 2:
+      countDigrams(starts, subtract, counts);
+      break;
+    default:
+      countTrigrams(starts, subtract, counts);
+      break;
+  }
+}
+
+void NgramStats::countBytes(const Starts& starts, bool subtract,
+                            Counts* counts) {
+  const uint8_t* data =
+      starts.window->data + (starts.begin - starts.window->offset);
+  uint64_t size = starts.end - starts.begin;
+  uint64_t d = delta(subtract);
+  if (size < k_kernel_min_size) {
+    for (uint64_t i = 0; i < size; ++i) {
+      counts->bytes[data[i]] += d;
+    }
+    return;
+  }
+  ByteHistogram hist = histogram(data, size);
+  for (size_t i = 0; i < hist.size(); ++i) {
+    counts->bytes[i] += hist[i] * d;
+  }
+}
+
+void NgramStats::countDigrams(const Starts& starts, bool subtract,
+                              Counts* counts) {
+  const uint8_t* data =
+      starts.window->data + (starts.begin - starts.window->offset);
+  uint64_t size = starts.end - starts.begin;
+  uint64_t d = delta(subtract);
+  if (size < k_kernel_min_size) {
+    for (uint64_t i = 0; i < size; ++i) {
+      size_t digram = data[i] * 256 + data[i + 1];
+      counts->digrams[digram] += d;
+      if (subtract) {
+        counts->digram_offset_sums[digram].subtract(starts.begin + i);
+      } else {
+        counts->digram_offset_sums[digram].add(starts.begin + i);
+      }
+    }
+    return;
+  }
+  // The kernel sums positions relative to the start.
+  std::vector<uint64_t> hist(256 * 256), position_sums(256 * 256);
+  digramHistogram(data, size + 1, hist.data(), position_sums.data());
+  for (size_t i = 0; i < hist.size(); ++i) {
+    if (hist[i] == 0) {
+      continue;
+    }
+    counts->digrams[i] += hist[i] * d;
+    OffsetSum& sum = counts->digram_offset_sums[i];
+    sum.addProduct(hist[i], starts.begin, subtract);
+    if (subtract) {
+      sum.subtract(position_sums[i]);
+    } else {
+      sum.add(position_sums[i]);
+    }
+  }
+}
+
+void NgramStats::countTrigrams(const Starts& starts, bool subtract,
+                               Counts* counts) {
+  const uint8_t* data =
+      starts.window->data + (starts.begin - starts.window->offset);
+  uint64_t size = starts.end - starts.begin;
+  uint64_t d = delta(subtract);
+  size_t num_chunks = static_cast<size_t>(std::min<uint64_t>(
+      threadpool::parallelism(), size / k_parallel_min_chunk));
+  if (num_chunks <= 1) {
+    countTrigramsSerial(data, size, d, counts->trigrams.data());
+    return;
+  }
+  // Every chunk counts into its own grid, which are added up at the end.
+  size_t cells = counts->trigrams.size();
+  std::vector<uint64_t> partial(num_chunks * cells);
+  uint64_t chunk_size = size / num_chunks;
+  threadpool::parallelFor(num_chunks, [&](size_t chunk) {
+    uint64_t begin = chunk * chunk_size;
+    uint64_t end = chunk + 1 == num_chunks ? size : begin + chunk_size;
+    countTrigramsSerial(data + begin, end - begin, 1,
+                        partial.data() + chunk * cells);
+  });
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    const uint64_t* own = partial.data() + chunk * cells;
+    for (size_t i = 0; i < cells; ++i) {
+      counts->trigrams[i] += own[i] * d;
+    }
+  }
+}
+
+}  // namespace stats
+}  // namespace util
+}  // namespace veles
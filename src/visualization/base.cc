@@ -53,9 +53,24 @@ void VisualizationWidget::setSampler(util::ISampler* sampler) {
 
 void VisualizationWidget::refreshVisualization(
     const AdditionalResampleDataPtr& ad) {
+  // The snapshot doesn't change under us, so no need to lock the sampler
+  // (and wait for a resample to finish) while uploading it.
+  std::shared_ptr<const util::SampleSnapshot> snapshot;
+  AdditionalResampleDataPtr data = ad;
+  if (auto result = std::dynamic_pointer_cast<ResampleResult>(ad)) {
+    // Show the sample the additional data was computed from, even if the
+    // sampler has a newer one by now - its resampled() is on the way.
+    snapshot = result->snapshot;
+    data = result->data;
+  } else {
+    snapshot = sampler_->snapshot();
+  }
+  {
+    std::unique_lock<std::mutex> lc(snapshot_mutex_);
+    snapshot_ = std::move(snapshot);
+  }
   if (gl_initialized_ && !error_message_set_) {
-    auto lc = sampler_->lock();
-    refresh(ad);
+    refresh(data);
   }
 }
 
@@ -97,28 +112,44 @@ void VisualizationWidget::initializeGL() {
   }
 }
 
+std::shared_ptr<const util::SampleSnapshot>
+VisualizationWidget::getSnapshot() {
+  std::unique_lock<std::mutex> lc(snapshot_mutex_);
+  return snapshot_;
+}
+
 size_t VisualizationWidget::getDataSize() {
-  if (!initialized_ || sampler_->empty()) {
+  auto snapshot = getSnapshot();
+  if (!initialized_ || snapshot == nullptr) {
     return 0;
   }
-  return sampler_->getSampleSize();
+  return snapshot->getSampleSize();
 }
 
 const char* VisualizationWidget::getData() {
-  if (!initialized_ || sampler_->empty()) {
+  auto snapshot = getSnapshot();
+  if (!initialized_ || snapshot == nullptr || snapshot->empty()) {
     return nullptr;
   }
-  return sampler_->data();
+  return snapshot->data();
 }
 
-char VisualizationWidget::getByte(size_t index) { return (*sampler_)[index]; }
+char VisualizationWidget::getByte(size_t index) {
+  auto snapshot = getSnapshot();
+  if (snapshot == nullptr || index >= snapshot->getSampleSize()) {
+    return 0;
+  }
+  return (*snapshot)[index];
+}
 
 void VisualizationWidget::prepareOptions(
     QMainWindow* /*visualization_window*/) {}
 
 void VisualizationWidget::resampleCallback() {
-  AdditionalResampleDataPtr additionalData(onAsyncResample());
-  emit resampled(additionalData);
+  auto result = std::make_shared<ResampleResult>();
+  result->snapshot = sampler_->snapshot();
+  result->data.reset(onAsyncResample(result->snapshot));
+  emit resampled(result);
 }
 
 }  // namespace visualization
@@ -16,6 +16,10 @@
  */
 #include "visualization/digram.h"
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace veles {
 namespace visualization {
 
@@ -31,10 +35,56 @@ DigramWidget::~DigramWidget() {
   doneCurrent();
 }
 
-void DigramWidget::refresh(const AdditionalResampleDataPtr& /*ad*/) {
+DigramWidget::DigramData* DigramWidget::computeDigramData(
+    const util::SampleStats& stats) {
+  auto* res = new DigramData();
+  res->table.resize(256 * 256 * 2);
+  const auto& ngrams = stats.stats();
+  if (stats.snapshot() == nullptr || ngrams.size() == 0) {
+    return res;
+  }
+  auto range = stats.snapshot()->getRange();
+  auto size = static_cast<double>(ngrams.size());
+  auto range_size = static_cast<double>(range.second - range.first);
+  for (int i = 0; i < 256 * 256; i++) {
+    auto count = static_cast<double>(ngrams.digrams()[i]);
+    if (count == 0) {
+      continue;
+    }
+    double mean_offset = ngrams.digramOffsetSums()[i].toDouble() / count;
+    res->table[i * 2] = static_cast<float>(count / size);
+    res->table[i * 2 + 1] = static_cast<float>(
+        count / size * (mean_offset - range.first) / range_size);
+  }
+  return res;
+}
+
+DigramWidget::DigramData* DigramWidget::currentDigramData() {
+  util::SampleStats stats(2);
+  auto snapshot = getSnapshot();
+  if (snapshot != nullptr) {
+    stats.update(snapshot);
+  }
+  return computeDigramData(stats);
+}
+
+VisualizationWidget::AdditionalResampleData* DigramWidget::onAsyncResample(
+    const std::shared_ptr<const util::SampleSnapshot>& snapshot) {
+  std::unique_lock<std::mutex> lc(sample_stats_mutex_);
+  sample_stats_.update(snapshot);
+  return computeDigramData(sample_stats_);
+}
+
+void DigramWidget::refresh(const AdditionalResampleDataPtr& ad) {
+  // Data of asynchronous resamples is counted in onAsyncResample, only
+  // samples set directly (eg. a new sampler) are counted here.
+  auto data = std::static_pointer_cast<DigramData>(ad);
+  if (data == nullptr) {
+    data.reset(currentDigramData());
+  }
   makeCurrent();
   delete texture_;
-  initTextures();
+  initTextures(*data);
   doneCurrent();
   update();
 }
@@ -47,7 +97,8 @@ bool DigramWidget::initializeVisualizationGL() {
   glClearColor(0, 0, 0, 1);
 
   initShaders();
-  initTextures();
+  std::unique_ptr<DigramData> data(currentDigramData());
+  initTextures(*data);
   initGeometry();
   return true;
 }
@@ -75,32 +126,14 @@ void DigramWidget::initShaders() {
   }
 }
 
-void DigramWidget::initTextures() {
+void DigramWidget::initTextures(const DigramData& data) {
   texture_ = new QOpenGLTexture(QOpenGLTexture::Target2D);
   texture_->setSize(256, 256);
   texture_->setFormat(QOpenGLTexture::RG32F);
   texture_->allocateStorage();
 
-  // effectively arrays of size [256][256][2], represented as single blocks
-  auto bigtab = new uint64_t[256 * 256 * 2];
-  memset(bigtab, 0, 256 * 256 * 2 * sizeof(*bigtab));
-  auto ftab = new float[256 * 256 * 2];
-  const auto* rowdata = reinterpret_cast<const uint8_t*>(getData());
-  for (size_t i = 0; i < getDataSize() - 1; i++) {
-    size_t index = rowdata[i] * 512 + rowdata[i + 1] * 2;
-    bigtab[index]++;
-    bigtab[index + 1] += i;
-  }
-  for (int i = 0; i < 256; i++) {
-    for (int j = 0; j < 256; j++) {
-      int index = i * 512 + j * 2;
-      ftab[index] = static_cast<float>(bigtab[index]) / getDataSize();
-      ftab[index + 1] =
-          static_cast<float>(bigtab[index + 1]) / getDataSize() / getDataSize();
-    }
-  }
   texture_->setData(QOpenGLTexture::RG, QOpenGLTexture::Float32,
-                    reinterpret_cast<void*>(ftab));
+                    data.table.data());
   texture_->generateMipMaps();
 
   texture_->setMinificationFilter(QOpenGLTexture::Nearest);
@@ -108,9 +141,6 @@ void DigramWidget::initTextures() {
   texture_->setMagnificationFilter(QOpenGLTexture::Linear);
 
   texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
-
-  delete[] bigtab;
-  delete[] ftab;
 }
 
 void DigramWidget::initGeometry() {
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "visualization/image_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include "visualization/digram.h"
+
+namespace veles {
+namespace visualization {
+
+namespace {
+
+// The trigram cube is turned so that it's seen from above a corner, like
+// in an isometric drawing.
+const float k_trigram_yaw = 45.0f;
+const float k_trigram_pitch = 35.264f;  // atan(1 / sqrt(2)) in degrees
+
+/** Converts a color channel computed by a shader to 8 bits, clamping it to
+    [0, 1] like OpenGL does when writing it to the framebuffer.  */
+int colorChannel(float value) {
+  return static_cast<int>(std::min(1.0f, std::max(0.0f, value)) * 255.0f +
+                          0.5f);
+}
+
+}  // namespace
+
+QImage renderDigram(const util::SampleStats& stats) {
+  std::unique_ptr<DigramWidget::DigramData> data(
+      DigramWidget::computeDigramData(stats));
+  QImage image(256, 256, QImage::Format_RGB32);
+  for (int first = 0; first < 256; ++first) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(255 - first));
+    for (int second = 0; second < 256; ++second) {
+      float count = data->table[(first * 256 + second) * 2];
+      float position = data->table[(first * 256 + second) * 2 + 1];
+      if (count == 0) {
+        line[second] = qRgb(0, 0, 0);
+        continue;
+      }
+      // As in digram/fshader.glsl.
+      float ch = position / count;
+      float clr = count * 4096.0f;
+      line[second] = qRgb(colorChannel(clr * (1.0f - ch)),
+                          colorChannel(clr / 2.0f), colorChannel(clr * ch));
+    }
+  }
+  return image;
+}
+
+QImage renderMinimap(const util::SampleSnapshot& snapshot,
+                     VisualizationMinimap::MinimapMode mode,
+                     VisualizationMinimap::MinimapColor color, int width,
+                     int height) {
+  if (width <= 0 || height <= 0) {
+    return QImage();
+  }
+  QImage image(width, height, QImage::Format_RGB32);
+  image.fill(Qt::black);
+  if (snapshot.empty()) {
+    return image;
+  }
+
+  auto rows = static_cast<size_t>(height);
+  auto cols = static_cast<size_t>(width);
+  minimap::fitTextureToSample(snapshot.getSampleSize(), &rows, &cols);
+  std::vector<float> texels;
+  minimap::calculateTexels(snapshot, mode, rows * cols, &texels);
+
+  auto channel = static_cast<int>(color);
+  for (int y = 0; y < height; ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    size_t row = static_cast<size_t>(y) * rows / height;
+    for (int x = 0; x < width; ++x) {
+      size_t col = static_cast<size_t>(x) * cols / width;
+      // As in minimap/fshader.glsl, inside the selection.
+      int rgb[3] = {0, 0, 0};
+      rgb[channel] = colorChannel(texels[row * cols + col] / 255.0f);
+      line[x] = qRgb(rgb[0], rgb[1], rgb[2]);
+    }
+  }
+  return image;
+}
+
+QImage renderTrigram(const util::SampleSnapshot& snapshot, int size,
+                     int brightness, const QColor& color_begin,
+                     const QColor& color_end) {
+  if (size <= 0) {
+    return QImage();
+  }
+  QImage image(size, size, QImage::Format_RGB32);
+  image.fill(Qt::black);
+  size_t sample_size = snapshot.getSampleSize();
+  if (sample_size < 3) {
+    return image;
+  }
+
+  // A point moves on the image by the sum of offsets of its coordinates.
+  // The cube's corners are sqrt(3) away from its center, so it fits in the
+  // image however it's turned.
+  QMatrix4x4 view;
+  view.rotate(k_trigram_pitch, 1, 0, 0);
+  view.rotate(k_trigram_yaw, 0, 1, 0);
+  const QVector3D axes[3] = {view.mapVector(QVector3D(1, 0, 0)),
+                             view.mapVector(QVector3D(0, 1, 0)),
+                             view.mapVector(QVector3D(0, 0, 1))};
+  float scale = static_cast<float>(size) / (2.0f * std::sqrt(3.0f));
+  float offset_x[3][256], offset_y[3][256];
+  for (int axis = 0; axis < 3; ++axis) {
+    for (int value = 0; value < 256; ++value) {
+      // As in trigram/vshader.glsl and coords.glsl, for the cube.
+      float coord = (value + 0.5f) / 256.0f * 2.0f - 1.0f;
+      offset_x[axis][value] = axes[axis].x() * coord * scale;
+      offset_y[axis][value] = -axes[axis].y() * coord * scale;
+    }
+  }
+
+  // As in trigram/fshader.glsl, except that the light of a point goes to a
+  // single pixel instead of a point 1% of the image across, so it's scaled
+  // by the area of such a point.
+  double point_size = 0.01 * size;
+  auto weight = static_cast<float>(
+      std::pow(static_cast<double>(brightness), 3) / sample_size *
+      std::max(1.0, point_size * point_size));
+  const float begin[3] = {static_cast<float>(color_begin.redF()),
+                          static_cast<float>(color_begin.greenF()),
+                          static_cast<float>(color_begin.blueF())};
+  const float end[3] = {static_cast<float>(color_end.redF()),
+                        static_cast<float>(color_end.greenF()),
+                        static_cast<float>(color_end.blueF())};
+
+  std::vector<float> light(static_cast<size_t>(size) * size * 3);
+  const auto* sample = reinterpret_cast<const uint8_t*>(snapshot.data());
+  size_t points = sample_size - 2;
+  float center = size / 2.0f;
+  for (size_t i = 0; i < points; ++i) {
+    uint8_t a = sample[i], b = sample[i + 1], c = sample[i + 2];
+    auto x = static_cast<int>(center + offset_x[0][a] + offset_x[1][b] +
+                              offset_x[2][c]);
+    auto y = static_cast<int>(center + offset_y[0][a] + offset_y[1][b] +
+                              offset_y[2][c]);
+    if (x < 0 || y < 0 || x >= size || y >= size) {
+      continue;
+    }
+    float pos = points > 1 ? static_cast<float>(i) / (points - 1) : 0.0f;
+    float* pixel = &light[(static_cast<size_t>(y) * size + x) * 3];
+    for (int channel = 0; channel < 3; ++channel) {
+      pixel[channel] +=
+          weight * (pos * end[channel] + (1.0f - pos) * begin[channel]);
+    }
+  }
+
+  for (int y = 0; y < size; ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    const float* pixel = &light[static_cast<size_t>(y) * size * 3];
+    for (int x = 0; x < size; ++x, pixel += 3) {
+      line[x] = qRgb(colorChannel(pixel[0]), colorChannel(pixel[1]),
+                     colorChannel(pixel[2]));
+    }
+  }
+  return image;
+}
+
+}  // namespace visualization
+}  // namespace veles
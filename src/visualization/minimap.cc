@@ -16,19 +16,32 @@
  */
 #include "visualization/minimap.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <utility>
 
 #include <QImage>
 
+#include "util/concurrency/threadpool.h"
+
 namespace veles {
 namespace visualization {
 
 VisualizationMinimap::VisualizationMinimap(QWidget* parent)
-    : QOpenGLWidget(parent) {}
+    : QOpenGLWidget(parent), texture_jobs_(std::make_shared<TextureJobs>()) {
+  texture_jobs_->minimap = this;
+  connect(this, &VisualizationMinimap::textureCalculated, this,
+          &VisualizationMinimap::uploadTexture, Qt::QueuedConnection);
+}
 
 VisualizationMinimap::~VisualizationMinimap() {
+  {
+    // Calculations still running won't emit textureCalculated() anymore.
+    std::unique_lock<std::mutex> lc(texture_jobs_->mutex);
+    texture_jobs_->minimap = nullptr;
+  }
   if (gl_initialized_) {
     makeCurrent();
     delete texture_;
@@ -69,19 +82,11 @@ void VisualizationMinimap::setSelectedRange(size_t start_address,
   emit selectionChanged(start_address, end_address);
 }
 
-void VisualizationMinimap::refresh(bool has_context) {
+void VisualizationMinimap::refresh() {
   if (!initialized_ || !gl_initialized_) {
     return;
   }
-  if (!has_context) {
-    makeCurrent();
-  }
-  delete lines_texture_;
-  delete texture_;
   initTextures();
-  if (!has_context) {
-    doneCurrent();
-  }
   update();
 }
 
@@ -122,155 +127,41 @@ void VisualizationMinimap::setMinimapMode(MinimapMode mode) {
 /* calculate minimap texture methods */
 /*****************************************************************************/
 
-float* VisualizationMinimap::calculateAverageValueTexture(const uint8_t* sample,
-                                                          size_t sample_size,
-                                                          size_t texture_size,
-                                                          double point_size) {
-  auto bigtab = new float[texture_size];
-  memset(bigtab, 0, texture_size * sizeof(*bigtab));
-  uint64_t point_sum = 0, point_count = 0;
-
-  size_t index = 0;
-  for (size_t i = 0; i < sample_size; ++i) {
-    if (index < texture_size - 1 &&
-        static_cast<double>(i) / point_size >= index + 1) {
-      uint8_t result = (point_count == 0) ? 0 : point_sum / point_count;
-      bigtab[index] = static_cast<float>(result);  // HAX
-      index += 1;
-      point_sum = 0;
-      point_count = 0;
+void VisualizationMinimap::calculateTexture(
+    const std::shared_ptr<TextureJobs>& jobs, uint64_t version,
+    const std::shared_ptr<const util::SampleSnapshot>& snapshot,
+    MinimapMode mode, size_t rows, size_t cols) {
+  std::unique_ptr<Texture> texture(new Texture);
+  texture->version = version;
+  texture->rows = rows;
+  texture->cols = cols;
+  {
+    std::unique_lock<std::mutex> lc(jobs->mutex);
+    if (jobs->version != version) {
+      return;
     }
-    point_sum += sample[i];
-    point_count += 1;
-  }
-  bigtab[texture_size - 1] =
-      static_cast<float>((point_count == 0) ? 0 : point_sum / point_count);
-  return bigtab;
-}
-
-float* VisualizationMinimap::calculateEntropyTexture(const uint8_t* sample,
-                                                     size_t sample_size,
-                                                     size_t texture_size,
-                                                     double point_size) {
-  if (point_size > k_minimum_entropy_window) {
-    return calculateEntropyTexturePerPixel(sample, sample_size, texture_size,
-                                           point_size);
+    texture->texels.swap(jobs->spare);
   }
-  if (sample_size < 2 * k_minimum_entropy_window) {
-    return calculateEntropyTextureSingleWindow(sample, sample_size,
-                                               texture_size, point_size);
-  }
-  return calculateEntropyTextureSlidingWindow(sample, sample_size, texture_size,
-                                              point_size);
-}
-
-float* VisualizationMinimap::calculateEntropyTexturePerPixel(
-    const uint8_t* sample, size_t sample_size, size_t texture_size,
-    double point_size) {
-  auto bigtab = new float[texture_size];
-  memset(bigtab, 0, texture_size * sizeof(*bigtab));
 
-  auto counts = new uint64_t[256];  // assume 8-bit bytes
-  memset(counts, 0, 256 * sizeof(*counts));
+  minimap::calculateTexels(*snapshot, mode, rows * cols, &texture->texels);
 
-  size_t index = 0, point_count = 0;
-
-  for (size_t i = 0; i < sample_size; ++i) {
-    if (index < texture_size - 1 &&
-        static_cast<double>(i) / point_size >= index + 1) {
-      bigtab[index] = calculateEntropyValue(counts, point_count);
-      index += 1;
-      point_count = 0;
-      memset(counts, 0, 256 * sizeof(*counts));
-    }
-    counts[sample[i]] += 1;
-    point_count += 1;
-  }
-  bigtab[texture_size - 1] = calculateEntropyValue(counts, point_count);
-  delete[] counts;
-  return bigtab;
-}
-
-float* VisualizationMinimap::calculateEntropyTextureSlidingWindow(
-    const uint8_t* sample, size_t sample_size, size_t texture_size,
-    double point_size) {
-  auto bigtab = new float[texture_size];
-  memset(bigtab, 0, texture_size * sizeof(*bigtab));
-
-  auto counts = new uint64_t[256];  // assume 8-bit bytes
-  memset(counts, 0, 256 * sizeof(*counts));
-
-  size_t start = 0, end = 0;
-  while (start < sample_size) {
-    size_t mid = (start + end) / 2;
-    if (mid > 0 &&
-        std::floor(mid / point_size) != std::floor((mid - 1) / point_size)) {
-      size_t point_count = end - start;
-      bigtab[static_cast<size_t>(mid / point_size)] =
-          calculateEntropyValue(counts, point_count);
-    }
-    if (end > k_minimum_entropy_window || end >= sample_size) {
-      counts[sample[start++]] -= 1;
-    }
-    if (end < sample_size) {
-      counts[sample[end++]] += 1;
-    }
+  std::unique_lock<std::mutex> lc(jobs->mutex);
+  if (jobs->minimap == nullptr || version <= jobs->uploaded ||
+      (jobs->ready != nullptr && jobs->ready->version > version)) {
+    jobs->recycle(&texture->texels);
+    return;
   }
-  delete[] counts;
-  return bigtab;
-}
-
-float* VisualizationMinimap::calculateEntropyTextureSingleWindow(
-    const uint8_t* sample, size_t sample_size, size_t texture_size,
-    double point_size) {
-  auto bigtab = new float[texture_size];
-  memset(bigtab, 0, texture_size * sizeof(*bigtab));
-
-  auto counts = new uint64_t[256];  // assume 8-bit bytes
-  memset(counts, 0, 256 * sizeof(*counts));
-
-  for (size_t i = 0; i < sample_size; ++i) {
-    counts[sample[i]] += 1;
+  if (jobs->ready != nullptr) {
+    jobs->recycle(&jobs->ready->texels);
   }
-
-  uint64_t point_count = 0;
-  float point_sum = 0;
-  float result = 0;
-
-  size_t index = 0;
-  for (size_t i = 0; i < sample_size; ++i) {
-    if (index < texture_size - 1 &&
-        static_cast<double>(i) / point_size >= index + 1) {
-      result = (point_count == 0) ? 0.0f : point_sum / point_count;
-      bigtab[index] = static_cast<float>(result) * 32;  // Normalise to 0-256
-      index += 1;
-      point_sum = 0;
-      point_count = 0;
-    }
-    point_sum -= log2(static_cast<float>(counts[sample[i]]) / sample_size);
-    point_count += 1;
-  }
-  result = (point_count == 0) ? 0.0f : point_sum / point_count;
-  bigtab[texture_size - 1] =
-      static_cast<float>(result) * 32;  // Normalise to 0-256
-  delete[] counts;
-  return bigtab;
+  jobs->ready = std::move(texture);
+  emit jobs->minimap->textureCalculated();
 }
 
-float VisualizationMinimap::calculateEntropyValue(const uint64_t* bytes_counts,
-                                                  uint64_t total_count) {
-  if (total_count == 0) {
-    return 0.0f;
-  }
-  float entropy = 0.0f;
-  for (int i = 0; i < 256; ++i) {
-    if (bytes_counts[i] > 0) {
-      float fcounts = static_cast<float>(bytes_counts[i]) / total_count;
-      entropy -= fcounts * log2(fcounts);
-    }
+void VisualizationMinimap::TextureJobs::recycle(std::vector<float>* texels) {
+  if (texels->capacity() > spare.capacity()) {
+    spare.swap(*texels);
   }
-  entropy *= 32;  // 256 / 8 (entropy will be in range [0,8], scale it
-  return entropy;
 }
 
 /*****************************************************************************/
@@ -285,6 +176,8 @@ void VisualizationMinimap::initializeGL() {
     glClearColor(0, 0, 0, 1);
     initShaders();
     initGeometry();
+    lines_texture_ = new QOpenGLTexture(QImage(":/images/bar.png"));
+    lines_texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
     gl_initialized_ = true;
   }
 }
@@ -323,63 +216,71 @@ void VisualizationMinimap::initGeometry() {
 }
 
 void VisualizationMinimap::initTextures() {
-  if (!initialized_) {
-    return;
-  }
-
-  lines_texture_ = new QOpenGLTexture(QImage(":/images/bar.png"));
-  lines_texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
-
-  if (empty()) {
+  if (!initialized_ || empty()) {
     return;
   }
 
   // calculate texture size
+  auto snapshot = sampler_->snapshot();
   texture_rows_ = std::max(static_cast<size_t>(1), rows_);
   texture_cols_ = std::max(static_cast<size_t>(1), cols_);
-  sample_size_ = sampler_->getSampleSize();
+  sample_size_ = snapshot->getSampleSize();
+  minimap::fitTextureToSample(sample_size_, &texture_rows_, &texture_cols_);
   size_t texture_size = texture_rows_ * texture_cols_;
 
-  if (sample_size_ < texture_size) {
-    float scale_factor = std::sqrt(static_cast<float>(sample_size_) /
-                                   static_cast<float>(texture_size));
-    texture_cols_ = static_cast<size_t>(std::max(1.0f, cols_ * scale_factor));
-    texture_rows_ = static_cast<size_t>(std::max(
-        1.0f, std::min(static_cast<float>(sample_size_) / texture_cols_,
-                       rows_ * scale_factor)));
-    texture_size = texture_rows_ * texture_cols_;
+  point_size_ = std::max(1.0, static_cast<double>(sample_size_) / texture_size);
+
+  uint64_t version;
+  {
+    std::unique_lock<std::mutex> lc(texture_jobs_->mutex);
+    version = ++texture_jobs_->version;
+  }
+  auto jobs = texture_jobs_;
+  auto mode = mode_;
+  size_t rows = texture_rows_;
+  size_t cols = texture_cols_;
+  auto task = [jobs, version, snapshot, mode, rows, cols]() {
+    calculateTexture(jobs, version, snapshot, mode, rows, cols);
+  };
+  if (util::threadpool::runTask("visualization", task) !=
+      util::threadpool::SchedulingResult::SCHEDULED) {
+    task();
+  }
+}
+
+void VisualizationMinimap::uploadTexture() {
+  std::unique_ptr<Texture> texture;
+  {
+    std::unique_lock<std::mutex> lc(texture_jobs_->mutex);
+    if (texture_jobs_->ready == nullptr) {
+      return;
+    }
+    texture = std::move(texture_jobs_->ready);
+    texture_jobs_->uploaded = texture->version;
   }
 
+  makeCurrent();
+  delete texture_;
   texture_ = new QOpenGLTexture(QOpenGLTexture::Target2D);
-  texture_->setSize(static_cast<int>(texture_cols_),
-                    static_cast<int>(texture_rows_));
+  texture_->setSize(static_cast<int>(texture->cols),
+                    static_cast<int>(texture->rows));
   // TODO(Maciek): WTF HAX
   // I really want to use GL_R8UI here, but for some reasone it doesn't work
   // so using float32 as workaround
   // texture_->setFormat(QOpenGLTexture::R8U);
   texture_->setFormat(QOpenGLTexture::R32F);
   texture_->allocateStorage();
-
-  point_size_ = std::max(1.0, static_cast<double>(sample_size_) / texture_size);
-  auto* row_data = reinterpret_cast<const uint8_t*>(sampler_->data());
-
-  float* bigtab;
-  if (mode_ == MinimapMode::VALUE) {
-    bigtab = calculateAverageValueTexture(row_data, sample_size_, texture_size,
-                                          point_size_);
-  } else {
-    bigtab = calculateEntropyTexture(row_data, sample_size_, texture_size,
-                                     point_size_);
-  }
-
   texture_->setData(QOpenGLTexture::Red, QOpenGLTexture::Float32,
-                    reinterpret_cast<void*>(bigtab));
+                    texture->texels.data());
   texture_->generateMipMaps();
   texture_->setMinificationFilter(QOpenGLTexture::Nearest);
   texture_->setMagnificationFilter(QOpenGLTexture::Nearest);
   texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
+  doneCurrent();
+  update();
 
-  delete[] bigtab;
+  std::unique_lock<std::mutex> lc(texture_jobs_->mutex);
+  texture_jobs_->recycle(&texture->texels);
 }
 
 void VisualizationMinimap::resizeGL(int w, int h) {
@@ -391,7 +292,7 @@ void VisualizationMinimap::resizeGL(int w, int h) {
   if (rows != rows_ || cols != cols_) {
     rows_ = rows;
     cols_ = cols;
-    refresh(true);
+    refresh();
     top_line_pos_ = normaliseLinePosition(offsetToLine(selection_start_));
     bottom_line_pos_ = normaliseLinePosition(offsetToLine(selection_end_));
     updateLinePositions(true);
@@ -430,22 +331,25 @@ void VisualizationMinimap::paintGL() {
   background_program_.setUniformValueArray("coords", bottom_margin_coords, 4);
   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-  // Render minimap
-  program_.bind();
-  texture_->bind();
-
-  square_vertex_.bind();
-  int vertexLocation = program_.attributeLocation("a_position");
-  program_.enableAttributeArray(vertexLocation);
-  program_.setAttributeBuffer(vertexLocation, GL_FLOAT, 0, 2,
-                              sizeof(QVector2D));
-  program_.setUniformValue("scale_factor", pos_info.scale_factor);
-  program_.setUniformValue("tx", 0);
-  program_.setUniformValue("top_line_pos", (1 + (-1.0f * top_line_pos_)) / 2);
-  program_.setUniformValue("bottom_line_pos",
-                           (1 + (-1.0f * bottom_line_pos_)) / 2);
-  program_.setUniformValue("channel", static_cast<GLuint>(color_));
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  // Render minimap, once its first texture is calculated
+  if (texture_ != nullptr) {
+    program_.bind();
+    texture_->bind();
+
+    square_vertex_.bind();
+    int vertexLocation = program_.attributeLocation("a_position");
+    program_.enableAttributeArray(vertexLocation);
+    program_.setAttributeBuffer(vertexLocation, GL_FLOAT, 0, 2,
+                                sizeof(QVector2D));
+    program_.setUniformValue("scale_factor", pos_info.scale_factor);
+    program_.setUniformValue("tx", 0);
+    program_.setUniformValue("top_line_pos",
+                             (1 + (-1.0f * top_line_pos_)) / 2);
+    program_.setUniformValue("bottom_line_pos",
+                             (1 + (-1.0f * bottom_line_pos_)) / 2);
+    program_.setUniformValue("channel", static_cast<GLuint>(color_));
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  }
 
   // Render selection bars
   lines_program_.bind();
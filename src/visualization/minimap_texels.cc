@@ -0,0 +1,247 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "visualization/minimap_texels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "util/concurrency/threadpool.h"
+
+namespace veles {
+namespace visualization {
+namespace minimap {
+
+void fitTextureToSample(size_t sample_size, size_t* rows, size_t* cols) {
+  size_t texture_size = *rows * *cols;
+  if (sample_size >= texture_size) {
+    return;
+  }
+  float scale_factor = std::sqrt(static_cast<float>(sample_size) /
+                                 static_cast<float>(texture_size));
+  size_t new_cols = static_cast<size_t>(std::max(1.0f, *cols * scale_factor));
+  *rows = static_cast<size_t>(
+      std::max(1.0f, std::min(static_cast<float>(sample_size) / new_cols,
+                              *rows * scale_factor)));
+  *cols = new_cols;
+}
+
+void calculateTexels(const util::SampleSnapshot& snapshot, MinimapMode mode,
+                     size_t texture_size, std::vector<float>* texels) {
+  TextureInput in =
+      textureInput(reinterpret_cast<const uint8_t*>(snapshot.data()),
+                   snapshot.getSampleSize(), texture_size);
+  texels->resize(texture_size);
+  float* out = texels->data();
+  if (mode == MinimapMode::VALUE) {
+    forSegments(in, [&](size_t first, size_t last) {
+      calculateAverageValueTexture(in, first, last, out);
+    });
+  } else {
+    calculateEntropyTexture(in, out);
+  }
+}
+
+TextureInput textureInput(const uint8_t* sample, size_t sample_size,
+                          size_t texture_size) {
+  TextureInput in;
+  in.sample = sample;
+  in.sample_size = sample_size;
+  in.texture_size = texture_size;
+  // Same as point_size_ of a minimap showing the sample.
+  in.point_size =
+      std::max(1.0, static_cast<double>(sample_size) / texture_size);
+  return in;
+}
+
+void forSegments(const TextureInput& in,
+                 const std::function<void(size_t, size_t)>& func) {
+  size_t segments = std::max<size_t>(
+      1, std::min(in.texture_size, in.sample_size / k_minimum_segment_size));
+  util::threadpool::parallelFor(segments, [&](size_t segment) {
+    func(in.texture_size * segment / segments,
+         in.texture_size * (segment + 1) / segments);
+  });
+}
+
+void calculateAverageValueTexture(const TextureInput& in, size_t first,
+                                  size_t last, float* texels) {
+  for (size_t index = first; index < last; ++index) {
+    size_t start =
+        pixelStart(index, in.point_size, in.sample_size, in.texture_size);
+    size_t end =
+        pixelStart(index + 1, in.point_size, in.sample_size, in.texture_size);
+    size_t point_count = end - start;
+    uint64_t point_sum = util::stats::sum(in.sample + start, point_count);
+    texels[index] =
+        static_cast<float>((point_count == 0) ? 0 : point_sum / point_count);
+  }
+}
+
+void calculateEntropyTexture(const TextureInput& in, float* texels) {
+  if (in.point_size > k_minimum_entropy_window) {
+    // No pixel is longer than that.
+    auto max_pixel_size = static_cast<size_t>(std::ceil(in.point_size)) + 1;
+    std::unique_ptr<util::stats::EntropyTable> table;
+    if (max_pixel_size <= k_maximum_entropy_table_size) {
+      table.reset(new util::stats::EntropyTable(max_pixel_size));
+    }
+    forSegments(in, [&](size_t first, size_t last) {
+      calculateEntropyTexturePerPixel(in, table.get(), first, last, texels);
+    });
+    return;
+  }
+  if (in.sample_size < 2 * k_minimum_entropy_window) {
+    // Information content of each byte value in the whole sample.
+    util::stats::ByteHistogram counts =
+        util::stats::histogram(in.sample, in.sample_size);
+    float surprisal[256];
+    for (int i = 0; i < 256; ++i) {
+      surprisal[i] =
+          counts[i] == 0
+              ? 0.0f
+              : -std::log2(static_cast<float>(counts[i]) / in.sample_size);
+    }
+    forSegments(in, [&](size_t first, size_t last) {
+      calculateEntropyTextureSingleWindow(in, surprisal, first, last, texels);
+    });
+    return;
+  }
+  util::stats::EntropyTable table(k_minimum_entropy_window + 1);
+  forSegments(in, [&](size_t first, size_t last) {
+    calculateEntropyTextureSlidingWindow(in, table, first, last, texels);
+  });
+}
+
+void calculateEntropyTexturePerPixel(const TextureInput& in,
+                                     const util::stats::EntropyTable* table,
+                                     size_t first, size_t last, float* texels) {
+  for (size_t index = first; index < last; ++index) {
+    size_t start =
+        pixelStart(index, in.point_size, in.sample_size, in.texture_size);
+    size_t end =
+        pixelStart(index + 1, in.point_size, in.sample_size, in.texture_size);
+    auto counts = util::stats::histogram(in.sample + start, end - start);
+    texels[index] =
+        entropyTexel(table != nullptr
+                         ? table->entropy(counts, end - start)
+                         : util::stats::entropy(counts, end - start));
+  }
+}
+
+void calculateEntropyTextureSlidingWindow(
+    const TextureInput& in, const util::stats::EntropyTable& table,
+    size_t first, size_t last, float* texels) {
+  const uint8_t* sample = in.sample;
+  size_t sample_size = in.sample_size;
+  double point_size = in.point_size;
+  std::fill(texels + first, texels + last, 0.0f);
+
+  // The window slides over the whole sample one byte per step: in step i
+  // it's [i - k - 1, i) clipped to the sample, where k is
+  // k_minimum_entropy_window. A pixel gets the entropy of the window in
+  // the last step whose window middle is the first offset of the pixel.
+  // Steps before the middle reaches the first pixel of the segment only
+  // concern earlier pixels, so the segment starts right there.
+  size_t k = k_minimum_entropy_window;
+  auto window_start = [&](size_t step) {
+    return step > k + 1 ? step - (k + 1) : 0;
+  };
+  auto window_end = [&](size_t step) { return std::min(step, sample_size); };
+  auto middle = [&](size_t step) {
+    return (window_start(step) + window_end(step)) / 2;
+  };
+  size_t first_offset =
+      pixelStart(first, point_size, sample_size, in.texture_size);
+  size_t last_offset =
+      pixelStart(last, point_size, sample_size, in.texture_size);
+  // First step whose middle is at least first_offset.
+  size_t low = 0, high = sample_size + k + 1;
+  while (low < high) {
+    size_t step = (low + high) / 2;
+    if (middle(step) < first_offset) {
+      low = step + 1;
+    } else {
+      high = step;
+    }
+  }
+
+  size_t start = window_start(low), end = window_end(low);
+  util::stats::SlidingEntropy window(&table);
+  for (size_t i = start; i < end; ++i) {
+    window.add(sample[i]);
+  }
+  while (start < sample_size) {
+    size_t mid = (start + end) / 2;
+    if (mid >= last_offset) {
+      break;
+    }
+    if (mid > 0 &&
+        std::floor(mid / point_size) != std::floor((mid - 1) / point_size)) {
+      texels[static_cast<size_t>(mid / point_size)] =
+          entropyTexel(window.entropy());
+    }
+    if (end > k || end >= sample_size) {
+      window.remove(sample[start++]);
+    }
+    if (end < sample_size) {
+      window.add(sample[end++]);
+    }
+  }
+}
+
+void calculateEntropyTextureSingleWindow(const TextureInput& in,
+                                         const float* surprisal, size_t first,
+                                         size_t last, float* texels) {
+  for (size_t index = first; index < last; ++index) {
+    size_t start =
+        pixelStart(index, in.point_size, in.sample_size, in.texture_size);
+    size_t end =
+        pixelStart(index + 1, in.point_size, in.sample_size, in.texture_size);
+    float point_sum = 0;
+    for (size_t i = start; i < end; ++i) {
+      point_sum += surprisal[in.sample[i]];
+    }
+    float result = (end == start) ? 0.0f : point_sum / (end - start);
+    texels[index] = result * 32;  // Normalise to 0-256
+  }
+}
+
+size_t pixelStart(size_t index, double point_size, size_t sample_size,
+                  size_t texture_size) {
+  if (index >= texture_size) {
+    return sample_size;
+  }
+  // The first offset i such that i / point_size >= index.
+  auto res = static_cast<size_t>(std::ceil(index * point_size));
+  while (res > 0 && static_cast<double>(res - 1) / point_size >= index) {
+    --res;
+  }
+  while (static_cast<double>(res) / point_size < index) {
+    ++res;
+  }
+  return std::min(res, sample_size);
+}
+
+float entropyTexel(double entropy) {
+  // Entropy is in range [0, 8], scale it to [0, 256].
+  return static_cast<float>(entropy) * 32;
+}
+
+}  // namespace minimap
+}  // namespace visualization
+}  // namespace veles
@@ -22,8 +22,11 @@
 #include <QLayoutItem>
 #include <QVBoxLayout>
 
+#include "util/concurrency/threadpool.h"
 #include "util/icons.h"
+#include "util/sampling/entropy_sampler.h"
 #include "util/sampling/fake_sampler.h"
+#include "util/sampling/sample_pyramid.h"
 #include "util/sampling/uniform_sampler.h"
 #include "util/settings/shortcuts.h"
 #include "visualization/digram.h"
@@ -38,7 +41,9 @@ const std::map<QString, VisualizationPanel::ESampler>
     VisualizationPanel::k_sampler_map = {
         {"No sampling", VisualizationPanel::ESampler::NO_SAMPLER},
         {"Uniform random sampling",
-         VisualizationPanel::ESampler::UNIFORM_SAMPLER}};
+         VisualizationPanel::ESampler::UNIFORM_SAMPLER},
+        {"Entropy-weighted sampling",
+         VisualizationPanel::ESampler::ENTROPY_SAMPLER}};
 
 /*****************************************************************************/
 /* Public methods */
@@ -48,20 +53,32 @@ VisualizationPanel::VisualizationPanel(
     ui::MainWindowWithDetachableDockWidgets* main_window,
     const QSharedPointer<ui::FileBlobModel>& data_model, QWidget* /*parent*/)
     : veles::ui::IconAwareView("Visualization", ":/images/trigram_icon.png"),
+      data_(std::make_shared<util::QByteArrayDataSource>(QByteArray())),
       sampler_type_(k_default_sampler),
       visualization_type_(k_default_visualization),
       sample_size_(1024 * 1024),
+      progressive_sampler_(nullptr),
+      progressive_minimap_sampler_(nullptr),
+      minimap_from_pyramid_(false),
+      pyramid_jobs_(std::make_shared<PyramidJobs>()),
       data_model_(data_model),
       main_window_(main_window),
       visible_(true) {
-  sampler_ = getSampler(sampler_type_, data_, sample_size_);
+  sampler_ = getSampler(sampler_type_, data_, nullptr, sample_size_);
   sampler_->allowAsynchronousResampling(true);
-  minimap_sampler_ =
-      getSampler(ESampler::UNIFORM_SAMPLER, data_, k_minimap_sample_size);
+  minimap_sampler_ = getSampler(ESampler::UNIFORM_SAMPLER, data_, nullptr,
+                                k_minimap_sample_size);
   minimap_ = new MinimapPanel(this);
   minimap_->setSampler(minimap_sampler_);
   connect(minimap_, &MinimapPanel::selectionChanged, this,
           &VisualizationPanel::minimapSelectionChanged);
+  connect(data_model_.data(), &ui::FileBlobModel::binDataReceived, this,
+          &VisualizationPanel::binDataReceived);
+  connect(data_model_.data(), &ui::FileBlobModel::newBinData, this,
+          &VisualizationPanel::newBinData);
+  pyramid_jobs_->panel = this;
+  connect(this, &VisualizationPanel::pyramidBuilt, this,
+          &VisualizationPanel::usePyramid, Qt::QueuedConnection);
 
   visualization_ = getVisualization(visualization_type_, this);
   visualization_root_ = new QMainWindow;
@@ -81,24 +98,33 @@ VisualizationPanel::VisualizationPanel(
 }
 
 VisualizationPanel::~VisualizationPanel() {
+  {
+    // Pyramids still being built won't emit pyramidBuilt() anymore.
+    std::unique_lock<std::mutex> lc(pyramid_jobs_->mutex);
+    pyramid_jobs_->panel = nullptr;
+  }
   delete visualization_;
   delete minimap_;
-  delete sampler_;
-  delete minimap_sampler_;
+  deleteSampler(sampler_);
+  deleteSampler(minimap_sampler_);
 }
 
-void VisualizationPanel::setData(const QByteArray& data) {
-  delete sampler_;
-  delete minimap_sampler_;
-  data_ = data;
-  sampler_ = getSampler(sampler_type_, data_, sample_size_);
-  sampler_->allowAsynchronousResampling(true);
-  minimap_sampler_ =
-      getSampler(ESampler::UNIFORM_SAMPLER, data_, k_minimap_sample_size);
-  minimap_->setSampler(minimap_sampler_);
-  visualization_->setSampler(sampler_);
-  selection_label_->setText(prepareAddressString(
-      0, sampler_->getFileOffset(sampler_->getSampleSize())));
+void VisualizationPanel::setData() {
+  progressive_data_ = nullptr;
+  data_ = data_model_->binDataSource();
+  sample_cache_ = data_model_->sampleCache();
+  resetSamplers();
+}
+
+void VisualizationPanel::setProgressiveData() {
+  progressive_data_ = data_model_->partialBinData();
+  if (progressive_data_ == nullptr) {
+    setData();
+    return;
+  }
+  data_ = progressive_data_;
+  sample_cache_ = nullptr;
+  resetSamplers();
 }
 
 void VisualizationPanel::setRange(size_t start, size_t end) {
@@ -119,14 +145,23 @@ void VisualizationPanel::visibilityChanged(bool visibility) {
 /* Static factory methods */
 /*****************************************************************************/
 
-util::ISampler* VisualizationPanel::getSampler(ESampler type,
-                                               const QByteArray& data,
-                                               qint64 sample_size) {
+util::ISampler* VisualizationPanel::getSampler(
+    ESampler type, const std::shared_ptr<const util::DataSource>& data,
+    const std::shared_ptr<util::SampleCache>& cache, qint64 sample_size) {
   switch (type) {
     case ESampler::NO_SAMPLER:
       return new util::FakeSampler(data);
+    case ESampler::ENTROPY_SAMPLER: {
+      auto* sampler = new util::EntropySampler(data);
+      sampler->setSampleCache(cache);
+      sampler->setSampleSize(sample_size);
+      return sampler;
+    }
     case ESampler::UNIFORM_SAMPLER:
       auto* sampler = new util::UniformSampler(data);
+      // Selection changes mostly shift or resize the range a bit at a time.
+      sampler->setIncrementalResampling(true);
+      sampler->setSampleCache(cache);
       sampler->setSampleSize(sample_size);
       return sampler;
   }
@@ -172,20 +207,25 @@ void VisualizationPanel::setSamplingMethod(const QString& name) {
   if (new_sampler_type == sampler_type_) {
     return;
   }
+  if (progressive_data_ != nullptr) {
+    // Used once all data arrives.
+    sampler_type_ = new_sampler_type;
+    return;
+  }
 
   auto old_sampler = sampler_;
-  sampler_ = getSampler(new_sampler_type, data_, sample_size_);
+  sampler_ = getSampler(new_sampler_type, data_, sample_cache_, sample_size_);
   sampler_->allowAsynchronousResampling(true);
   auto selection = minimap_->getSelection();
   sampler_->setRange(selection.first, selection.second);
   visualization_->setSampler(sampler_);
-  delete old_sampler;
+  deleteSampler(old_sampler);
   sampler_type_ = new_sampler_type;
 }
 
 void VisualizationPanel::setSampleSize(size_t size) {
   sample_size_ = size;
-  if (sampler_type_ == ESampler::UNIFORM_SAMPLER) {
+  if (sampler_type_ != ESampler::NO_SAMPLER || progressive_data_ != nullptr) {
     sampler_->setSampleSize(size);
   }
 }
@@ -221,10 +261,133 @@ void VisualizationPanel::minimapSelectionChanged(size_t start, size_t end) {
 
 void VisualizationPanel::showMoreOptions() { sampling_method_dialog_->show(); }
 
+void VisualizationPanel::binDataReceived(uint64_t /*start*/,
+                                         uint64_t /*end*/) {
+  if (progressive_data_ == nullptr) {
+    if (data_->size() == 0 && data_model_->partialBinData() != nullptr) {
+      // The panel was created before the model knew the data size.
+      setProgressiveData();
+    }
+    return;
+  }
+  if (data_model_->hasAllBinData()) {
+    // newBinData() follows and replaces the progressive samplers, there's
+    // no point in resampling them once more.
+    return;
+  }
+  // Both samplers use the same thresholds, so they refine together.
+  progressive_sampler_->refine();
+  if (progressive_minimap_sampler_->refine()) {
+    // Minimaps sample a copy of the sampler, so they have to be reset, and
+    // the selection with them.
+    minimap_->setSampler(minimap_sampler_);
+    auto range = sampler_->getRange();
+    if (range.first != 0 || range.second != data_->size()) {
+      sampler_->setRange(0, data_->size());
+    }
+    selection_label_->setText(prepareAddressString(0, data_->size()));
+  }
+}
+
+void VisualizationPanel::newBinData() {
+  if (progressive_data_ != nullptr || data_->size() == 0) {
+    setData();
+  }
+}
+
+void VisualizationPanel::usePyramid() {
+  if (minimap_from_pyramid_ || sample_cache_ == nullptr) {
+    return;
+  }
+  // The data might have changed since the pyramid was requested.
+  auto pyramid = sample_cache_->findPyramid(data_, k_minimap_pyramid_size);
+  if (pyramid == nullptr) {
+    return;
+  }
+  // A new sampler resets the minimaps, so leave them alone once the user
+  // zoomed in.
+  auto selection = minimap_->getSelection();
+  if (selection.first != 0 || selection.second != data_->size()) {
+    return;
+  }
+  auto* old_sampler = minimap_sampler_;
+  minimap_sampler_ = new util::PyramidSampler(pyramid);
+  minimap_sampler_->setSampleSize(k_minimap_sample_size);
+  minimap_->setSampler(minimap_sampler_);
+  deleteSampler(old_sampler);
+  minimap_from_pyramid_ = true;
+}
+
 /*****************************************************************************/
 /* Private methods */
 /*****************************************************************************/
 
+void VisualizationPanel::resetSamplers() {
+  // The widgets unregister their callbacks from the old samplers when given
+  // the new ones, so the old ones are deleted only afterwards - once their
+  // resamples queued on the thread pool are done.
+  auto* old_sampler = sampler_;
+  auto* old_minimap_sampler = minimap_sampler_;
+  if (progressive_data_ != nullptr) {
+    progressive_sampler_ = new util::ProgressiveSampler(progressive_data_);
+    progressive_sampler_->setSampleSize(sample_size_);
+    progressive_minimap_sampler_ =
+        new util::ProgressiveSampler(progressive_data_);
+    progressive_minimap_sampler_->setSampleSize(k_minimap_sample_size);
+    sampler_ = progressive_sampler_;
+    minimap_sampler_ = progressive_minimap_sampler_;
+  } else {
+    progressive_sampler_ = nullptr;
+    progressive_minimap_sampler_ = nullptr;
+    sampler_ = getSampler(sampler_type_, data_, sample_cache_, sample_size_);
+    auto pyramid = sample_cache_->findPyramid(data_, k_minimap_pyramid_size);
+    minimap_from_pyramid_ = pyramid != nullptr;
+    if (minimap_from_pyramid_) {
+      minimap_sampler_ = new util::PyramidSampler(pyramid);
+      minimap_sampler_->setSampleSize(k_minimap_sample_size);
+    } else {
+      // Building the pyramid takes a while, the minimap samples the data
+      // directly until it's ready.
+      minimap_sampler_ = getSampler(ESampler::UNIFORM_SAMPLER, data_,
+                                    sample_cache_, k_minimap_sample_size);
+      buildPyramid();
+    }
+  }
+  sampler_->allowAsynchronousResampling(true);
+  minimap_->setSampler(minimap_sampler_);
+  visualization_->setSampler(sampler_);
+  deleteSampler(old_sampler);
+  deleteSampler(old_minimap_sampler);
+  selection_label_->setText(prepareAddressString(
+      0, sampler_->getFileOffset(sampler_->getSampleSize())));
+}
+
+void VisualizationPanel::deleteSampler(util::ISampler* sampler) {
+  if (sampler == nullptr) {
+    return;
+  }
+  // Resamples queued on the thread pool use the sampler.
+  sampler->wait();
+  delete sampler;
+}
+
+void VisualizationPanel::buildPyramid() {
+  auto jobs = pyramid_jobs_;
+  auto cache = sample_cache_;
+  auto data = data_;
+  auto task = [jobs, cache, data]() {
+    cache->pyramid(data, k_minimap_pyramid_size);
+    std::unique_lock<std::mutex> lc(jobs->mutex);
+    if (jobs->panel != nullptr) {
+      emit jobs->panel->pyramidBuilt();
+    }
+  };
+  if (util::threadpool::runTask("visualization", task) !=
+      util::threadpool::SchedulingResult::SCHEDULED) {
+    task();
+  }
+}
+
 void VisualizationPanel::setVisualization(EVisualization type) {
   if (type != visualization_type_) {
     auto toolbars = visualization_root_->findChildren<QToolBar*>();
@@ -37,6 +37,7 @@
 #include "ui/velesapplication.h"
 #include "util/icons.h"
 #include "util/settings/visualization.h"
+#include "util/stats/byte_stats.h"
 
 namespace veles {
 namespace visualization {
@@ -262,7 +263,8 @@ void TrigramWidget::prepareOptions(QMainWindow* visualization_window) {
   layout->addWidget(brightness_label);
 
   if (use_brightness_heuristic_) {
-    setBrightness(suggestBrightness());
+    setBrightness(suggestBrightness(
+        reinterpret_cast<const uint8_t*>(getData()), getDataSize()));
   }
   brightness_slider_ = new QSlider(Qt::Horizontal);
   brightness_slider_->setMinimum(k_minimum_brightness);
@@ -293,16 +295,15 @@ void TrigramWidget::prepareOptions(QMainWindow* visualization_window) {
   visualization_window->addToolBar(brightness_toolbar);
 }
 
-int TrigramWidget::suggestBrightness() {
-  size_t size = getDataSize();
-  auto data = reinterpret_cast<const uint8_t*>(getData());
+int TrigramWidget::suggestBrightness(const uint8_t* data, size_t size) {
+  return suggestBrightness(util::stats::histogram(data, size), size);
+}
+
+int TrigramWidget::suggestBrightness(util::stats::ByteHistogram counts,
+                                     uint64_t size) {
   if (size < 100) {
     return (k_minimum_brightness + k_maximum_brightness) / 2;
   }
-  std::vector<uint64_t> counts(256, 0);
-  for (size_t i = 0; i < size; ++i) {
-    counts[data[i]] += 1;
-  }
   std::sort(counts.begin(), counts.end());
   int offset = 0, sum = 0;
   while (offset < 255 && sum < k_brightness_heuristic_threshold * size) {
@@ -315,10 +316,14 @@ int TrigramWidget::suggestBrightness() {
                   k_brightness_heuristic_max - offset);
 }
 
-VisualizationWidget::AdditionalResampleData* TrigramWidget::onAsyncResample() {
+VisualizationWidget::AdditionalResampleData* TrigramWidget::onAsyncResample(
+    const std::shared_ptr<const util::SampleSnapshot>& snapshot) {
   if (use_brightness_heuristic_) {
+    std::unique_lock<std::mutex> lc(sample_stats_mutex_);
+    sample_stats_.update(snapshot);
     auto* res = new BrightnessData();
-    res->brightness = suggestBrightness();
+    res->brightness = suggestBrightness(sample_stats_.stats().bytes(),
+                                        sample_stats_.stats().size());
     return res;
   }
   return nullptr;
@@ -395,7 +400,8 @@ void TrigramWidget::setManipulator(Manipulator* manipulator) {
 }
 
 void TrigramWidget::autoSetBrightness() {
-  auto new_brightness = suggestBrightness();
+  auto new_brightness = suggestBrightness(
+      reinterpret_cast<const uint8_t*>(getData()), getDataSize());
   if (new_brightness == brightness_) {
     return;
   }
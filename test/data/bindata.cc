@@ -17,6 +17,9 @@
 #include "data/bindata.h"
 
 #include <algorithm>
+#include <vector>
+
+#include <QTemporaryFile>
 
 #include "gtest/gtest.h"
 
@@ -366,6 +369,54 @@ TEST(BinData, Data23) {
   EXPECT_EQ(c.rawData()[2], 6);
 }
 
+TEST(BinData, CopySharesStorage) {
+  BinData a(8, {1, 2, 3, 4, 5, 6});
+  BinData b(a);
+  const BinData& ca = a;
+  const BinData& cb = b;
+  EXPECT_EQ(ca.rawData(), cb.rawData());
+  EXPECT_FALSE(a.isDetached());
+  EXPECT_FALSE(b.isDetached());
+  b.setElement64(0, 7);
+  EXPECT_NE(ca.rawData(), cb.rawData());
+  EXPECT_TRUE(a.isDetached());
+  EXPECT_TRUE(b.isDetached());
+  EXPECT_EQ(a.element64(0), 1u);
+  EXPECT_EQ(b.element64(0), 7u);
+}
+
+TEST(BinData, DataSharesStorage) {
+  BinData a(16, {1, 2, 3, 4, 5, 6});
+  BinData b = a.data(2, 3);
+  const BinData& ca = a;
+  const BinData& cb = b;
+  EXPECT_EQ(ca.rawData(2), cb.rawData());
+  EXPECT_EQ(b.element64(0), 3u);
+  EXPECT_EQ(b.element64(2), 5u);
+  BinData c = b.data(1, 2);
+  EXPECT_EQ(ca.rawData(3), static_cast<const BinData&>(c).rawData());
+  c.rawData()[0] = 0x11;
+  EXPECT_EQ(a.element64(3), 4u);
+  EXPECT_EQ(b.element64(1), 4u);
+  EXPECT_EQ(c.element64(0), 0x11u);
+  a.setElement64(2, 0x22);
+  EXPECT_EQ(a.element64(2), 0x22u);
+  EXPECT_EQ(b.element64(0), 3u);
+}
+
+TEST(BinData, DetachAfterSourceDestroyed) {
+  BinData b;
+  {
+    BinData a(8, {1, 2, 3, 4});
+    b = a.data(1, 2);
+  }
+  EXPECT_TRUE(b.isDetached());
+  EXPECT_EQ(b.element64(0), 2u);
+  EXPECT_EQ(b.element64(1), 3u);
+  b.setElement64(1, 9);
+  EXPECT_EQ(b.element64(1), 9u);
+}
+
 TEST(BinData, SetData23) {
   BinData a = BinData::fromRawData(
       23, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
@@ -499,5 +550,102 @@ TEST(BinData, Equal) {
   EXPECT_FALSE(BinData::fromRawData(8, {1}) == BinData::fromRawData(7, {1}));
 }
 
+TEST(BinData, FromExternalSharesAndCopiesOnWrite) {
+  uint8_t raw[] = {1, 2, 3, 4, 5};
+  int released = 0;
+  {
+    BinData a = BinData::fromExternal(8, 5, raw, [&released]() {
+      released++;
+    });
+    const BinData& const_a = a;
+    EXPECT_EQ(const_a.rawData(), raw);
+    EXPECT_FALSE(a.isDetached());
+    BinData b = a.data(1, 3);
+    EXPECT_EQ(static_cast<const BinData&>(b).rawData(), raw + 1);
+    a.setElement64(0, 0x10);
+    EXPECT_NE(const_a.rawData(), raw);
+    EXPECT_EQ(raw[0], 1);
+    EXPECT_EQ(a, BinData(8, {0x10, 2, 3, 4, 5}));
+    EXPECT_EQ(released, 0);
+    EXPECT_EQ(b, BinData(8, {2, 3, 4}));
+  }
+  EXPECT_EQ(released, 1);
+}
+
+TEST(BinData, FromExternalInline) {
+  uint8_t raw[] = {0x34, 0x12};
+  int released = 0;
+  BinData a = BinData::fromExternal(16, 1, raw, [&released]() {
+    released++;
+  });
+  EXPECT_EQ(released, 1);
+  EXPECT_EQ(a.element64(), 0x1234u);
+}
+
+namespace {
+
+std::vector<uint8_t> writeTempFile(QTemporaryFile* file, size_t size) {
+  std::vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+  }
+  EXPECT_TRUE(file->open());
+  EXPECT_EQ(file->write(reinterpret_cast<const char*>(bytes.data()),
+                        static_cast<qint64>(size)),
+            static_cast<qint64>(size));
+  file->close();
+  return bytes;
+}
+
+}  // namespace
+
+TEST(BinData, MapFileMapped) {
+  QTemporaryFile file;
+  size_t size = BinData::k_map_min_size * 2 + 3;
+  auto bytes = writeTempFile(&file, size);
+  BinData a;
+  ASSERT_TRUE(BinData::mapFile(file.fileName(), &a));
+  EXPECT_EQ(a, BinData(8, size, bytes.data()));
+  // Backed by the read-only mapping, writes go to a private copy.
+  EXPECT_FALSE(a.isDetached());
+  BinData b = a;
+  b.setElement64(0, bytes[0] ^ 0xff);
+  EXPECT_EQ(a.element64(0), bytes[0]);
+  BinData c;
+  ASSERT_TRUE(BinData::mapFile(file.fileName(), &c));
+  EXPECT_EQ(c.element64(0), bytes[0]);
+}
+
+TEST(BinData, MapFileRead) {
+  QTemporaryFile file;
+  size_t size = BinData::k_map_min_size - 1;
+  auto bytes = writeTempFile(&file, size);
+  BinData a;
+  ASSERT_TRUE(BinData::mapFile(file.fileName(), &a));
+  EXPECT_EQ(a, BinData(8, size, bytes.data()));
+  // Small files are read into an ordinary buffer.
+  EXPECT_TRUE(a.isDetached());
+}
+
+TEST(BinData, MapFileEmpty) {
+  QTemporaryFile file;
+  writeTempFile(&file, 0);
+  BinData a(8, {1, 2});
+  ASSERT_TRUE(BinData::mapFile(file.fileName(), &a));
+  EXPECT_EQ(a, BinData(8, 0));
+}
+
+TEST(BinData, MapFileMissing) {
+  QString name;
+  {
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    name = file.fileName();
+  }
+  BinData a(8, {1, 2});
+  EXPECT_FALSE(BinData::mapFile(name, &a));
+  EXPECT_EQ(a, BinData(8, {1, 2}));
+}
+
 }  // namespace data
 }  // namespace veles
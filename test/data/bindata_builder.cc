@@ -0,0 +1,137 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "data/bindata_builder.h"
+
+#include "gtest/gtest.h"
+
+namespace veles {
+namespace data {
+
+TEST(BinDataBuilder, Empty) {
+  BinDataBuilder builder(8);
+  EXPECT_EQ(builder.size(), 0u);
+  BinData res = builder.finish();
+  EXPECT_EQ(res.width(), 8u);
+  EXPECT_EQ(res.size(), 0u);
+}
+
+TEST(BinDataBuilder, AppendElements) {
+  BinDataBuilder builder(16);
+  for (uint64_t i = 0; i < 1000; i++) {
+    builder.appendElement64(i * 7);
+  }
+  EXPECT_EQ(builder.size(), 1000u);
+  EXPECT_GE(builder.capacity(), 1000u);
+  BinData res = builder.finish();
+  EXPECT_EQ(res.width(), 16u);
+  ASSERT_EQ(res.size(), 1000u);
+  for (size_t i = 0; i < 1000; i++) {
+    EXPECT_EQ(res.element64(i), i * 7);
+  }
+  EXPECT_EQ(builder.size(), 0u);
+  EXPECT_EQ(builder.capacity(), 0u);
+}
+
+TEST(BinDataBuilder, AppendBinDataAndRaw) {
+  BinDataBuilder builder(8, 4);
+  EXPECT_EQ(builder.capacity(), 4u);
+  builder.append(BinData(8, {1, 2, 3}));
+  uint8_t raw[] = {4, 5, 6};
+  builder.appendRaw(raw, 3);
+  builder.append(BinData(8, 0));
+  builder.append(BinData(8, {7}));
+  EXPECT_EQ(builder.finish(), BinData(8, {1, 2, 3, 4, 5, 6, 7}));
+}
+
+TEST(BinDataBuilder, ReserveKeepsContents) {
+  BinDataBuilder builder(32);
+  builder.appendElement64(0xdeadbeef);
+  builder.reserve(100);
+  EXPECT_GE(builder.capacity(), 100u);
+  builder.reserve(10);
+  EXPECT_GE(builder.capacity(), 100u);
+  builder.appendElement64(0x12345678);
+  EXPECT_EQ(builder.finish(), BinData(32, {0xdeadbeef, 0x12345678}));
+}
+
+TEST(BinDataBuilder, FinishInline) {
+  BinDataBuilder builder(64, 32);
+  builder.appendElement64(0x0123456789abcdefu);
+  BinData res = builder.finish();
+  EXPECT_EQ(res, BinData(64, {0x0123456789abcdefu}));
+}
+
+TEST(BinDataBuilder, AppendBits) {
+  BinDataBuilder builder(12);
+  builder.appendBits64(0x321, 12);
+  // Bits spanning element boundaries.
+  builder.appendBits64(0x54, 8);
+  builder.appendBits64(0x876, 12);
+  EXPECT_TRUE(builder.hasPartialElement());
+  EXPECT_EQ(builder.size(), 2u);
+  uint8_t src[] = {0x9a, 0xbc};
+  builder.appendBits(src, 4, 4);
+  EXPECT_FALSE(builder.hasPartialElement());
+  EXPECT_EQ(builder.finish(), BinData(12, {0x321, 0x654, 0x987}));
+}
+
+TEST(BinDataBuilder, FinishPartialElement) {
+  BinDataBuilder builder(12);
+  builder.appendElement64(0xabc);
+  builder.appendBits64(0x5, 3);
+  EXPECT_EQ(builder.finish(), BinData(12, {0xabc, 0x5}));
+}
+
+TEST(BinDataBuilder, AppendElementsAfterPartialElement) {
+  BinDataBuilder builder(12);
+  builder.appendBits64(0x5, 3);
+  builder.appendElement64(0xabc);
+  EXPECT_FALSE(builder.hasPartialElement());
+  builder.appendBits64(0x3, 2);
+  builder.append(BinData(12, {0x123, 0x456}));
+  builder.appendBits64(0x1, 1);
+  uint8_t raw[] = {0x89, 0x07};
+  builder.appendRaw(raw, 1);
+  EXPECT_EQ(builder.size(), 7u);
+  EXPECT_EQ(builder.finish(),
+            BinData(12, {0x5, 0xabc, 0x3, 0x123, 0x456, 0x1, 0x789}));
+}
+
+TEST(BinDataBuilder, AppendManyBitsAcrossGrowth) {
+  BinDataBuilder builder(5);
+  for (unsigned i = 0; i < 500; i++) {
+    builder.appendBits64(i & 1, 1);
+  }
+  BinData res = builder.finish();
+  ASSERT_EQ(res.size(), 100u);
+  for (size_t i = 0; i < res.size(); i++) {
+    EXPECT_EQ(res.element64(i), i % 2 == 0 ? 0x0au : 0x15u);
+  }
+}
+
+TEST(BinDataBuilder, Move) {
+  BinDataBuilder a(8);
+  a.append(BinData(8, {1, 2, 3}));
+  BinDataBuilder b(std::move(a));
+  EXPECT_EQ(b.size(), 3u);
+  a = std::move(b);
+  a.appendElement64(4);
+  EXPECT_EQ(a.finish(), BinData(8, {1, 2, 3, 4}));
+}
+
+}  // namespace data
+}  // namespace veles
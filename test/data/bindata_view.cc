@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "data/bindata_view.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace veles {
+namespace data {
+
+TEST(BinDataView, Compatibility) {
+  EXPECT_TRUE(BinDataView<uint8_t>::isCompatible(BinData(8, 3)));
+  EXPECT_TRUE(BinDataView<uint8_t>::isCompatible(BinData(5, 3)));
+  EXPECT_FALSE(BinDataView<uint8_t>::isCompatible(BinData(9, 3)));
+  EXPECT_TRUE(BinDataView<uint16_t>::isCompatible(BinData(12, 3)));
+  EXPECT_FALSE(BinDataView<uint32_t>::isCompatible(BinData(24, 3)));
+  EXPECT_TRUE(BinDataView<uint32_t>::isCompatible(BinData(32, 3)));
+  EXPECT_TRUE(BinDataView<uint64_t>::isCompatible(BinData(64, 3)));
+}
+
+TEST(BinDataView, Elements8) {
+  BinData data(8, {1, 2, 0xff});
+  BinDataView<uint8_t> view(data);
+  ASSERT_EQ(view.size(), 3u);
+  EXPECT_FALSE(view.empty());
+  EXPECT_EQ(view[0], 1u);
+  EXPECT_EQ(view[1], 2u);
+  EXPECT_EQ(view[2], 0xffu);
+}
+
+TEST(BinDataView, Elements16) {
+  BinData data(12, {0x123, 0xfff, 0});
+  BinDataView<uint16_t> view(data);
+  EXPECT_EQ(std::vector<uint16_t>(view.begin(), view.end()),
+            (std::vector<uint16_t>{0x123, 0xfff, 0}));
+}
+
+TEST(BinDataView, Elements32And64) {
+  BinData data32(32, {0xdeadbeef, 0x01020304});
+  BinDataView<uint32_t> view32(data32);
+  EXPECT_EQ(view32[0], 0xdeadbeefu);
+  EXPECT_EQ(view32[1], 0x01020304u);
+  BinData data64(64, {0x0123456789abcdefu, 1});
+  BinDataView<uint64_t> view64(data64);
+  EXPECT_EQ(view64[0], 0x0123456789abcdefu);
+  EXPECT_EQ(view64[1], 1u);
+}
+
+TEST(BinDataView, MatchesElement64) {
+  BinData data(16, 100);
+  for (size_t i = 0; i < data.size(); i++) {
+    data.setElement64(i, i * 653);
+  }
+  BinDataView<uint16_t> view(data);
+  for (size_t i = 0; i < data.size(); i++) {
+    EXPECT_EQ(view[i], data.element64(i));
+  }
+}
+
+TEST(BinDataView, SliceAndIterators) {
+  BinData data(8, {5, 4, 3, 2, 1, 0});
+  BinData slice = data.data(1, 4);
+  BinDataView<uint8_t> view(slice);
+  EXPECT_EQ(view.end() - view.begin(), 4);
+  EXPECT_EQ(*std::max_element(view.begin(), view.end()), 4u);
+  auto it = view.begin();
+  EXPECT_EQ(*it++, 4u);
+  EXPECT_EQ(*it, 3u);
+  EXPECT_EQ(it[2], 1u);
+  EXPECT_EQ(*(view.end() - 1), 1u);
+  EXPECT_TRUE(view.begin() < view.end());
+}
+
+TEST(BinDataView, Empty) {
+  BinData data(32, 0);
+  BinDataView<uint32_t> view(data);
+  EXPECT_TRUE(view.empty());
+  EXPECT_EQ(view.begin(), view.end());
+}
+
+}  // namespace data
+}  // namespace veles
@@ -15,6 +15,10 @@
  *
  */
 #include "data/bindata.h"
+
+#include <random>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace veles {
@@ -88,5 +92,66 @@ TEST(CopyTest, ShiftOffset) {
   EXPECT_EQ(dst[7], 0xa7);
 }
 
+TEST(CopyTest, LongShift) {
+  // Long enough to go through the word and vector loops.
+  std::vector<uint8_t> src(100);
+  for (size_t i = 0; i < src.size(); i++) {
+    src[i] = static_cast<uint8_t>(i);
+  }
+  std::vector<uint8_t> dst(100, 0xff);
+  BinData::copyBits(dst.data(), 0, src.data(), 4, 8 * 90);
+  for (size_t i = 0; i < 90; i++) {
+    uint8_t expected = static_cast<uint8_t>((i >> 4) | ((i + 1) << 4));
+    EXPECT_EQ(dst[i], expected) << "at octet " << i;
+  }
+  for (size_t i = 90; i < dst.size(); i++) {
+    EXPECT_EQ(dst[i], 0xff);
+  }
+}
+
+namespace {
+
+/** Reference implementation, one bit at a time.  */
+void copyBitsReference(uint8_t* dst, unsigned dst_bit, const uint8_t* src,
+                       unsigned src_bit, unsigned num_bits) {
+  for (unsigned i = 0; i < num_bits; i++) {
+    unsigned s = src_bit + i;
+    unsigned d = dst_bit + i;
+    uint8_t bit = (src[s >> 3] >> (s & 7)) & 1;
+    dst[d >> 3] = static_cast<uint8_t>((dst[d >> 3] & ~(1 << (d & 7))) |
+                                       (bit << (d & 7)));
+  }
+}
+
+}  // namespace
+
+TEST(CopyTest, RandomizedDifferential) {
+  std::mt19937 gen(0x5eed);
+  std::uniform_int_distribution<int> octet(0, 255);
+  std::uniform_int_distribution<unsigned> offset(0, 67);
+  std::uniform_int_distribution<unsigned> length(0, 3000);
+  for (int iter = 0; iter < 2000; iter++) {
+    unsigned src_bit = offset(gen);
+    unsigned dst_bit = offset(gen);
+    unsigned num_bits = iter < 200 ? iter : length(gen);
+    // Size buffers exactly, so that reading or writing past the copied
+    // range is caught by sanitizers.
+    std::vector<uint8_t> src((src_bit + num_bits + 7) / 8);
+    std::vector<uint8_t> dst((dst_bit + num_bits + 7) / 8);
+    for (auto& x : src) {
+      x = static_cast<uint8_t>(octet(gen));
+    }
+    for (auto& x : dst) {
+      x = static_cast<uint8_t>(octet(gen));
+    }
+    std::vector<uint8_t> expected = dst;
+    copyBitsReference(expected.data(), dst_bit, src.data(), src_bit,
+                      num_bits);
+    BinData::copyBits(dst.data(), dst_bit, src.data(), src_bit, num_bits);
+    ASSERT_EQ(expected, dst) << "src_bit " << src_bit << " dst_bit "
+                             << dst_bit << " num_bits " << num_bits;
+  }
+}
+
 }  // namespace data
 }  // namespace veles
@@ -72,5 +72,30 @@ TEST(NodeID, TestBoolConv) {
   EXPECT_TRUE(*NodeID::getRootNodeId());
 }
 
+TEST(NodeIDTable, InternIsStable) {
+  NodeIDTable table;
+  NodeID n1, n2;
+  auto h1 = table.intern(n1);
+  auto h2 = table.intern(n2);
+  EXPECT_TRUE(h1.isValid());
+  EXPECT_TRUE(h2.isValid());
+  EXPECT_NE(h1, h2);
+  EXPECT_EQ(table.intern(NodeID(n1)), h1);
+  EXPECT_EQ(table.size(), 2u);
+  EXPECT_EQ(table.id(h1), n1);
+  EXPECT_EQ(table.id(h2), n2);
+  EXPECT_NE(NodeHandleHash()(h1), NodeHandleHash()(h2));
+}
+
+TEST(NodeIDTable, Find) {
+  NodeIDTable table;
+  NodeID n1, n2;
+  auto h1 = table.intern(n1);
+  EXPECT_EQ(table.find(n1), h1);
+  EXPECT_FALSE(table.find(n2).isValid());
+  EXPECT_FALSE(NodeHandle().isValid());
+  EXPECT_EQ(table.size(), 1u);
+}
+
 }  // namespace data
 }  // namespace veles
@@ -16,6 +16,8 @@
  */
 #include "data/repack.h"
 
+#include <random>
+
 #include "gtest/gtest.h"
 
 namespace veles {
@@ -253,6 +255,192 @@ TEST(Repack, Padded8to23MixedBig) {
   EXPECT_EQ(b.element64(1), 0x667788u);
 }
 
+TEST(Repack, IdentitySharesStorage) {
+  BinData a(16, {0x1234, 0x5678, 0x9abc, 0xdef0, 0x1111, 0x2222});
+  Repacker format{Endian::BIG, 16, 16};
+  BinData b = format.repack(a, 1, 4);
+  EXPECT_EQ(b, BinData(16, {0x5678, 0x9abc, 0xdef0, 0x1111}));
+  EXPECT_EQ(static_cast<const BinData&>(b).rawData(),
+            static_cast<const BinData&>(a).rawData(1));
+}
+
+TEST(Repack, Gather24To16Little) {
+  BinData a(24, {0x332211, 0x665544, 0x998877});
+  Repacker format{Endian::LITTLE, 24, 16};
+  EXPECT_EQ(format.repackSize(4), 3u);
+  BinData b = format.repack(a, 0, 4);
+  EXPECT_EQ(b, BinData(16, {0x2211, 0x4433, 0x6655, 0x8877}));
+}
+
+TEST(Repack, Gather8To32Big) {
+  BinData a(8, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99});
+  Repacker format{Endian::BIG, 8, 32};
+  BinData b = format.repack(a, 1, 2);
+  EXPECT_EQ(b, BinData(32, {0x22334455, 0x66778899}));
+}
+
+TEST(Repack, Gather8To64Big) {
+  BinData a(8, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99});
+  Repacker format{Endian::BIG, 8, 64};
+  BinData b = format.repack(a, 1, 5);
+  EXPECT_EQ(b.size(), 1u);
+  EXPECT_EQ(b.element64(0), 0x2233445566778899u);
+}
+
+TEST(Repack, Split64To8Big) {
+  BinData a(64, {0x0102030405060708u, 0x1112131415161718u});
+  Repacker format{Endian::BIG, 64, 8};
+  BinData b = format.repack(a, 0, 16);
+  EXPECT_EQ(b, BinData(8, {1, 2, 3, 4, 5, 6, 7, 8, 0x11, 0x12, 0x13, 0x14,
+                           0x15, 0x16, 0x17, 0x18}));
+}
+
+TEST(Repack, Split8To4Little) {
+  BinData a(8, {0x12, 0x34, 0x56});
+  Repacker format{Endian::LITTLE, 8, 4};
+  BinData b = format.repack(a, 1, 3);
+  EXPECT_EQ(b, BinData(4, {4, 3, 6}));
+}
+
+TEST(Repack, Split8To4Big) {
+  BinData a(8, {0x12, 0x34, 0x56});
+  Repacker format{Endian::BIG, 8, 4};
+  BinData b = format.repack(a, 1, 3);
+  EXPECT_EQ(b, BinData(4, {3, 4, 5}));
+}
+
+TEST(Repack, Split8To2And1) {
+  BinData a(8, {0xb4});
+  Repacker format2{Endian::BIG, 8, 2};
+  EXPECT_EQ(format2.repack(a, 0, 4), BinData(2, {2, 3, 1, 0}));
+  Repacker format2le{Endian::LITTLE, 8, 2};
+  EXPECT_EQ(format2le.repack(a, 0, 4), BinData(2, {0, 1, 3, 2}));
+  Repacker format1{Endian::BIG, 8, 1};
+  EXPECT_EQ(format1.repack(a, 0, 8), BinData(1, {1, 0, 1, 1, 0, 1, 0, 0}));
+  Repacker format1le{Endian::LITTLE, 8, 1};
+  EXPECT_EQ(format1le.repack(a, 0, 8),
+            BinData(1, {0, 0, 1, 0, 1, 1, 0, 1}));
+}
+
+namespace {
+
+/** Straightforward bit-by-bit implementation of unpadded repacking.  */
+BinData repackReference(const Repacker& format, const BinData& src,
+                        size_t start, size_t num_elements) {
+  BinData res(format.to_width, num_elements);
+  size_t total_bits = num_elements * format.to_width;
+  size_t src_bits = format.repackSize(num_elements) * format.from_width;
+  for (size_t bit = 0; bit < total_bits; bit++) {
+    // Position of the bit in the glued string, counted from its LSB.
+    size_t dst_el = bit / format.to_width;
+    size_t dst_bit = bit % format.to_width;
+    size_t pos = bit;
+    if (format.endian == Endian::BIG) {
+      pos = src_bits - (dst_el + 1) * format.to_width + dst_bit;
+    }
+    size_t src_el = pos / format.from_width;
+    size_t src_bit = pos % format.from_width;
+    if (format.endian == Endian::BIG) {
+      src_el = src_bits / format.from_width - 1 - src_el;
+    }
+    BinData::copyBits(res.rawData(dst_el), dst_bit,
+                      src.rawData(start + src_el), src_bit, 1);
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST(Repack, FastPathsMatchReference) {
+  static const uint64_t formats[][2] = {
+      {8, 1},  {8, 2},  {8, 4},  {8, 16}, {8, 32},  {8, 64},  {16, 8},
+      {32, 8}, {64, 8}, {24, 16}, {16, 16}, {16, 32}, {8, 24}, {24, 8}};
+  std::mt19937 gen(1234);
+  for (auto endian : {Endian::LITTLE, Endian::BIG}) {
+    for (const auto& widths : formats) {
+      Repacker format{endian, widths[0], widths[1]};
+      for (int iter = 0; iter < 20; iter++) {
+        BinData src(widths[0], 40);
+        for (size_t i = 0; i < src.octets(); i++) {
+          src.rawData()[i] = gen() & 0xff;
+        }
+        size_t start = gen() % 8;
+        size_t num_elements =
+            gen() % (format.repackableSize(src.size() - start) + 1);
+        EXPECT_EQ(format.repack(src, start, num_elements),
+                  repackReference(format, src, start, num_elements))
+            << "from " << widths[0] << " to " << widths[1] << " endian "
+            << static_cast<int>(endian) << " start " << start << " size "
+            << num_elements;
+      }
+    }
+  }
+}
+
+TEST(Repack, RepackIntoOverwritesGarbage) {
+  BinData a(8, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa});
+  Repacker format{Endian::BIG, 8, 23, 1, 8};
+  BinData dst(23, {0x7fffff, 0x7fffff, 0x7fffff, 0x7fffff});
+  EXPECT_EQ(format.repackInto(a, 1, 2, &dst, 1), 2u);
+  EXPECT_EQ(dst, BinData(23, {0x7fffff, 0x223344, 0x667788, 0x7fffff}));
+}
+
+TEST(StreamRepacker, MatchesRepack) {
+  static const Repacker formats[] = {
+      Repacker{Endian::LITTLE, 8, 12}, Repacker{Endian::BIG, 8, 12},
+      Repacker{Endian::BIG, 8, 32},    Repacker{Endian::LITTLE, 8, 4},
+      Repacker{Endian::BIG, 8, 23, 1, 8}, Repacker{Endian::BIG, 12, 8},
+      Repacker{Endian::LITTLE, 16, 16}};
+  std::mt19937 gen(4321);
+  for (const auto& format : formats) {
+    for (int iter = 0; iter < 10; iter++) {
+      BinData src(format.from_width, gen() % 100);
+      for (size_t i = 0; i < src.size(); i++) {
+        src.setElement64(i, gen() & ((1u << format.from_width) - 1));
+      }
+      BinData expected =
+          format.repack(src, 0, format.repackableSize(src.size()));
+
+      StreamRepacker stream(format);
+      BinData out(format.to_width, expected.size());
+      BinData sunk(format.to_width, 0);
+      StreamRepacker sink_stream(format);
+      auto sink = [&sunk](const BinData& piece) { sunk = sunk + piece; };
+      size_t written = 0;
+      for (size_t pos = 0; pos < src.size();) {
+        size_t len = std::min<size_t>(gen() % 7, src.size() - pos);
+        BinData chunk = src.data(pos, len);
+        EXPECT_LE(written + stream.outputSize(len), out.size());
+        written += stream.push(chunk, &out, written);
+        sink_stream.push(chunk, sink);
+        pos += len;
+      }
+      EXPECT_EQ(stream.finishSize() + written, expected.size());
+      written += stream.finish(&out, written);
+      sink_stream.finish(sink);
+      EXPECT_EQ(written, expected.size());
+      EXPECT_EQ(out, expected);
+      EXPECT_EQ(sunk, expected);
+      EXPECT_EQ(stream.pending(), 0u);
+    }
+  }
+}
+
+TEST(StreamRepacker, SinkBatches) {
+  Repacker format{Endian::LITTLE, 8, 12};
+  BinData src(8, 3 * StreamRepacker::k_max_batch_elements);
+  StreamRepacker stream(format);
+  size_t pieces = 0;
+  size_t total = 0;
+  stream.push(src, [&](const BinData& piece) {
+    EXPECT_LE(piece.size(), StreamRepacker::k_max_batch_elements);
+    pieces++;
+    total += piece.size();
+  });
+  EXPECT_EQ(total, 2 * StreamRepacker::k_max_batch_elements);
+  EXPECT_EQ(pieces, 2u);
+}
+
 TEST(Repack, MsgpackConversion) {
   auto format = std::make_shared<Repacker>(Endian::BIG, 8, 23, 1, 8);
   auto obj = messages::toMsgpackObject(format);
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/concurrency/threadpool.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace veles {
+namespace util {
+namespace threadpool {
+
+TEST(ParallelFor, runsEveryChunkOnce) {
+  for (size_t num_chunks : {0, 1, 2, 7, 1000}) {
+    std::vector<std::atomic<int>> runs(num_chunks);
+    for (auto& run : runs) {
+      run = 0;
+    }
+    parallelFor(num_chunks, [&](size_t chunk) { runs[chunk]++; });
+    for (auto& run : runs) {
+      EXPECT_EQ(run, 1);
+    }
+  }
+}
+
+TEST(ParallelFor, nestedCallsRunInline) {
+  std::mutex mutex;
+  bool inline_only = true;
+  std::atomic<int> inner_runs(0);
+  parallelFor(16, [&](size_t) {
+    auto outer = std::this_thread::get_id();
+    parallelFor(8, [&](size_t) {
+      inner_runs++;
+      if (std::this_thread::get_id() != outer) {
+        std::unique_lock<std::mutex> lc(mutex);
+        inline_only = false;
+      }
+    });
+  });
+  EXPECT_EQ(inner_runs, 16 * 8);
+  EXPECT_TRUE(inline_only);
+}
+
+TEST(ParallelFor, smallWorkRunsInline) {
+  auto caller = std::this_thread::get_id();
+  std::atomic<int> other_threads(0);
+  parallelFor(64, 1000, [&](size_t) {
+    if (std::this_thread::get_id() != caller) {
+      other_threads++;
+    }
+  });
+  EXPECT_EQ(other_threads, 0);
+}
+
+TEST(ParallelFor, rethrowsExceptions) {
+  std::atomic<int> runs(0);
+  EXPECT_THROW(parallelFor(100,
+                           [&](size_t chunk) {
+                             runs++;
+                             if (chunk == 3) {
+                               throw std::runtime_error("chunk 3");
+                             }
+                           }),
+               std::runtime_error);
+  EXPECT_LE(runs, 100);
+  // The pool still works afterwards.
+  std::atomic<int> after(0);
+  parallelFor(100, [&](size_t) { after++; });
+  EXPECT_EQ(after, 100);
+}
+
+TEST(ParallelFor, concurrentCallers) {
+  std::atomic<int> runs(0);
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i) {
+    callers.emplace_back([&]() {
+      for (int j = 0; j < 50; ++j) {
+        parallelFor(10, [&](size_t) { runs++; });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(runs, 4 * 50 * 10);
+  EXPECT_GE(parallelism(), 1u);
+}
+
+}  // namespace threadpool
+}  // namespace util
+}  // namespace veles
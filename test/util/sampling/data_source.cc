@@ -0,0 +1,223 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/data_source.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mock_sampler.h"
+#include "util/sampling/fake_sampler.h"
+#include "util/sampling/uniform_sampler.h"
+
+namespace veles {
+namespace util {
+
+namespace {
+
+PagedDataSource::PageFetcher fetcherFor(const QByteArray& data,
+                                        std::vector<uint64_t>* fetches) {
+  return [data, fetches](uint64_t offset, uint64_t size, char* out) {
+    if (fetches != nullptr) {
+      fetches->push_back(offset);
+    }
+    memcpy(out, data.constData() + offset, size);
+  };
+}
+
+}  // namespace
+
+TEST(DataSource, QByteArray) {
+  auto data = prepare_data(100);
+  QByteArrayDataSource source(data);
+  ASSERT_EQ(100u, source.size());
+  ASSERT_NE(nullptr, source.contiguousData());
+  ASSERT_EQ(0, memcmp(data.constData(), source.contiguousData(), 100));
+  char out[10];
+  source.read(40, 10, out);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(data[40 + i], out[i]);
+  }
+  ASSERT_EQ(data[99], source.byteAt(99));
+}
+
+TEST(DataSource, BinData) {
+  auto bindata = data::BinData(8, 100);
+  for (size_t i = 0; i < 100; ++i) {
+    bindata.setElement64(i, i * 3);
+  }
+  BinDataSource source(bindata);
+  ASSERT_EQ(100u, source.size());
+  ASSERT_NE(nullptr, source.contiguousData());
+  char out[4];
+  source.read(10, 4, out);
+  ASSERT_EQ(30, out[0]);
+  ASSERT_EQ(39, out[3]);
+  ASSERT_EQ(static_cast<char>(297), source.byteAt(99));
+}
+
+TEST(DataSource, Progressive) {
+  auto data = prepare_data(100);
+  ProgressiveDataSource source(100);
+  ASSERT_EQ(100u, source.size());
+  ASSERT_EQ(0u, source.availableSize());
+  source.write(10, data.constData() + 10, 10);
+  source.write(30, data.constData() + 30, 10);
+  using Ranges = std::vector<std::pair<uint64_t, uint64_t>>;
+  ASSERT_EQ((Ranges{{10, 20}, {30, 40}}), source.availableRanges(0, 100));
+  ASSERT_EQ((Ranges{{15, 20}, {30, 35}}), source.availableRanges(15, 35));
+  ASSERT_EQ(20u, source.availableSize());
+
+  // Touching and overlapping writes are merged.
+  source.write(20, data.constData() + 20, 10);
+  source.write(35, data.constData() + 35, 15);
+  ASSERT_EQ((Ranges{{10, 50}}), source.availableRanges(0, 100));
+  ASSERT_EQ(40u, source.availableSize());
+  ASSERT_FALSE(source.isComplete());
+  ASSERT_EQ(nullptr, source.contiguousData());
+
+  // Bytes that didn't arrive yet read as zeros.
+  char out[4];
+  source.read(48, 4, out);
+  ASSERT_EQ(data[48], out[0]);
+  ASSERT_EQ(data[49], out[1]);
+  ASSERT_EQ(0, out[2]);
+  ASSERT_EQ(0, out[3]);
+
+  source.write(0, data.constData(), 100);
+  ASSERT_EQ((Ranges{{0, 100}}), source.availableRanges(0, 100));
+  ASSERT_TRUE(source.isComplete());
+  ASSERT_NE(nullptr, source.contiguousData());
+  ASSERT_EQ(0, memcmp(data.constData(), source.contiguousData(), 100));
+}
+
+TEST(DataSource, PagedReadsAcrossPages) {
+  auto data = prepare_data(1000);
+  std::vector<uint64_t> fetches;
+  PagedDataSource source(data.size(), fetcherFor(data, &fetches), 64, 4);
+  ASSERT_EQ(1000u, source.size());
+  ASSERT_EQ(nullptr, source.contiguousData());
+
+  std::vector<char> out(200);
+  source.read(50, 200, out.data());
+  for (size_t i = 0; i < out.size(); ++i) {
+    ASSERT_EQ(data[static_cast<int>(50 + i)], out[i]);
+  }
+  ASSERT_EQ((std::vector<uint64_t>{0, 64, 128, 192}), fetches);
+
+  // The last, partial page.
+  source.read(990, 10, out.data());
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_EQ(data[static_cast<int>(990 + i)], out[i]);
+  }
+  ASSERT_EQ(960u, fetches.back());
+}
+
+TEST(DataSource, PagedCachesRecentPages) {
+  auto data = prepare_data(1000);
+  std::vector<uint64_t> fetches;
+  PagedDataSource source(data.size(), fetcherFor(data, &fetches), 100, 2);
+
+  source.byteAt(0);
+  source.byteAt(150);
+  source.byteAt(1);
+  ASSERT_EQ(2u, fetches.size());
+
+  // Page 2 evicts page 1, which was used least recently.
+  source.byteAt(250);
+  source.byteAt(2);
+  ASSERT_EQ(3u, fetches.size());
+  source.byteAt(151);
+  ASSERT_EQ(4u, fetches.size());
+  ASSERT_EQ(100u, fetches.back());
+}
+
+TEST(DataSource, PagedFetchesWithoutBlockingReads) {
+  auto data = prepare_data(1000);
+  std::atomic<bool> cached_read(false);
+  std::atomic<bool> fetch_waited(false);
+  auto fetcher = [&](uint64_t offset, uint64_t size, char* out) {
+    if (offset == 0) {
+      // Stalls until the other page is read from the cache.
+      for (int i = 0; i < 5000 && !cached_read; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      fetch_waited = cached_read.load();
+    }
+    memcpy(out, data.constData() + offset, size);
+  };
+  PagedDataSource source(data.size(), fetcher, 100, 4);
+  ASSERT_EQ(data[150], source.byteAt(150));
+
+  std::thread slow_reader([&source, &data]() {
+    ASSERT_EQ(data[5], source.byteAt(5));
+  });
+  // Doesn't wait for the slow fetch of page 0.
+  ASSERT_EQ(data[151], source.byteAt(151));
+  cached_read = true;
+  slow_reader.join();
+  ASSERT_TRUE(fetch_waited);
+}
+
+TEST(DataSource, PagedFetchFailureIsRetried) {
+  auto data = prepare_data(1000);
+  int fetches = 0;
+  auto fetcher = [&](uint64_t offset, uint64_t size, char* out) {
+    if (fetches++ == 0) {
+      throw std::runtime_error("fetch failed");
+    }
+    memcpy(out, data.constData() + offset, size);
+  };
+  PagedDataSource source(data.size(), fetcher, 100, 4);
+  ASSERT_THROW(source.byteAt(10), std::runtime_error);
+  ASSERT_EQ(data[10], source.byteAt(10));
+  ASSERT_EQ(2, fetches);
+}
+
+TEST(DataSource, SamplerOverPagedSource) {
+  auto data = prepare_data(10000);
+  UniformSampler reference(data);
+  reference.setSampleSize(900);
+  UniformSampler paged(std::make_shared<PagedDataSource>(
+      data.size(), fetcherFor(data, nullptr), 256, 4));
+  paged.setSampleSize(900);
+
+  ASSERT_EQ(reference.getSampleSize(), paged.getSampleSize());
+  for (size_t i = 0; i < reference.getSampleSize(); ++i) {
+    ASSERT_EQ(reference[i], paged[i]);
+  }
+
+  // No sampling required, so the range is read in full.
+  FakeSampler fake(std::make_shared<PagedDataSource>(
+      data.size(), fetcherFor(data, nullptr), 256, 4));
+  fake.setSampleSize(10000);
+  fake.setRange(100, 600);
+  ASSERT_EQ(500u, fake.getSampleSize());
+  const char* raw = fake.data();
+  for (int i = 0; i < 500; ++i) {
+    ASSERT_EQ(data[100 + i], raw[i]);
+  }
+}
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "util/sampling/entropy_sampler.h"
+
+#include <random>
+
+#include "mock_sampler.h"
+
+namespace veles {
+namespace util {
+
+namespace {
+
+// Zero padding followed by random bytes, like a firmware image with a
+// mostly empty partition.
+QByteArray paddedData(size_t padding, size_t size) {
+  QByteArray data(static_cast<int>(size), 0);
+  std::mt19937 generator(1);
+  for (size_t i = padding; i < size; ++i) {
+    data[static_cast<int>(i)] = static_cast<char>(generator());
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(EntropySampler, testOffsets) {
+  auto data = paddedData(300000, 1000000);
+  EntropySampler sampler(data);
+  sampler.setWindowSize(16);
+  sampler.setSampleSize(32000);
+  sampler.setRange(100000, 900000);
+  size_t size = sampler.getSampleSize();
+  ASSERT_EQ(32000u, size);
+  size_t prev = 100000;
+  for (size_t i = 1; i + 1 < size; ++i) {
+    size_t curr = sampler.getFileOffset(i);
+    ASSERT_LT(prev, curr);
+    ASSERT_LT(curr, 900000u);
+    ASSERT_EQ(i, sampler.getSampleOffset(curr));
+    ASSERT_EQ(data[static_cast<int>(curr)], sampler[i]);
+    prev = curr;
+  }
+}
+
+TEST(EntropySampler, testFavoursInformation) {
+  auto data = paddedData(750000, 1000000);
+  EntropySampler sampler(data);
+  sampler.setWindowSize(16);
+  sampler.setSampleSize(16000);
+  size_t size = sampler.getSampleSize();
+  ASSERT_EQ(16000u, size);
+  size_t in_padding = 0;
+  for (size_t i = 0; i < size; i += 16) {
+    in_padding += sampler.getFileOffset(i + 8) < 750000;
+  }
+  // Padding is 3/4 of the data, but should only get a few windows.
+  EXPECT_GT(in_padding, 0u);
+  EXPECT_LT(in_padding, size / 16 / 5);
+
+  auto entropy = sampler.getBlockEntropy();
+  ASSERT_FALSE(entropy.empty());
+  EXPECT_EQ(0, entropy.front());
+  EXPECT_GT(entropy.back(), 7.5);
+}
+
+}  // namespace util
+}  // namespace veles
@@ -15,6 +15,9 @@
  *
  */
 
+#include <chrono>
+#include <future>
+
 #include "mock_sampler.h"
 #include "util/concurrency/threadpool.h"
 
@@ -23,6 +26,7 @@ namespace util {
 
 using testing::_;
 using testing::Expectation;
+using testing::Invoke;
 using testing::Mock;
 using testing::Return;
 
@@ -227,5 +231,80 @@ TEST(ISamplerAsynchronous, prepareAndApplySample) {
   ASSERT_TRUE(sampler.isFinished());
 }
 
+TEST(ISamplerAsynchronous, cancelSuperseded) {
+  threadpool::mockTopic("visualization");
+  auto data = prepare_data(100);
+  MockCallback mc;
+  mc.resetCallCount();
+  testing::StrictMock<MockSampler> sampler(data);
+  sampler.allowAsynchronousResampling(true);
+  sampler.registerResampleCallback(std::ref(mc));
+  // Tasks of a mocked topic run immediately, so the second resample
+  // starts and finishes while the first one is still being prepared.
+  // The first one should notice that and stop, without being applied.
+  bool cancelled = false;
+  EXPECT_CALL(sampler, prepareResample(_))
+      .WillOnce(Invoke([&](MockSampler::SamplerConfig* sc) {
+        EXPECT_FALSE(sampler.proxy_isCancelled(sc));
+        sampler.resample();
+        cancelled = sampler.proxy_isCancelled(sc);
+        return nullptr;
+      }))
+      .WillOnce(Return(nullptr));
+  EXPECT_CALL(sampler, applyResample(nullptr));
+  sampler.setSampleSize(10);
+  ASSERT_TRUE(cancelled);
+  ASSERT_EQ(1, mc.getCallCount());
+  ASSERT_TRUE(sampler.isFinished());
+}
+
+TEST(ISamplerAsynchronous, waitForOutdatedResamples) {
+  threadpool::mockTopic("visualization");
+  auto data = prepare_data(100);
+  testing::NiceMock<MockSampler> sampler(data);
+  sampler.allowAsynchronousResampling(true);
+  // The first resample is outdated by the second one before it's done.
+  EXPECT_CALL(sampler, prepareResample(_))
+      .WillOnce(Invoke([&](MockSampler::SamplerConfig*) {
+        sampler.resample();
+        return nullptr;
+      }))
+      .WillRepeatedly(Return(nullptr));
+  sampler.setSampleSize(10);
+  ASSERT_TRUE(sampler.isFinished());
+  auto waited = std::async(std::launch::async, [&sampler]() {
+    sampler.wait();
+    return true;
+  });
+  ASSERT_EQ(std::future_status::ready,
+            waited.wait_for(std::chrono::seconds(10)));
+}
+
+TEST(ISamplerAsynchronous, snapshot) {
+  threadpool::mockTopic("visualization");
+  auto data = prepare_data(100);
+  testing::NiceMock<MockSampler> sampler(data);
+  sampler.setSampleSize(1000);
+  sampler.allowAsynchronousResampling(true);
+  bool published = false;
+  sampler.registerResampleCallback([&]() {
+    auto range = sampler.snapshot()->getRange();
+    published = range.first == 40 && range.second == 60;
+  });
+  sampler.setRange(40, 60);
+  ASSERT_TRUE(published);
+
+  // Reading a snapshot doesn't need the sampler lock.
+  auto lc = sampler.lock();
+  auto snapshot = std::async(std::launch::async,
+                             [&sampler]() { return sampler.snapshot(); });
+  ASSERT_EQ(std::future_status::ready,
+            snapshot.wait_for(std::chrono::seconds(10)));
+  auto result = snapshot.get();
+  ASSERT_EQ(20u, result->getSampleSize());
+  ASSERT_EQ(data[45], (*result)[5]);
+  ASSERT_EQ(45u, result->getFileOffset(5));
+}
+
 }  // namespace util
 }  // namespace veles
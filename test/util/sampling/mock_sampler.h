@@ -25,6 +25,8 @@ namespace util {
 
 class MockSampler : public ISampler {
  public:
+  using ISampler::SamplerConfig;
+
   explicit MockSampler(const QByteArray& data) : ISampler(data) {}
   MOCK_CONST_METHOD0(cloneImpl, ISampler*());
   MOCK_CONST_METHOD0(getRealSampleSize, size_t());
@@ -38,6 +40,7 @@ class MockSampler : public ISampler {
 
   size_t proxy_getDataSize() { return getDataSize(); }
   char proxy_getDataByte(size_t index) { return getDataByte(index); }
+  bool proxy_isCancelled(SamplerConfig* sc) { return isCancelled(sc); }
 };
 
 class MockCallback {
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "util/sampling/progressive_sampler.h"
+
+#include <memory>
+
+#include "mock_sampler.h"
+
+namespace veles {
+namespace util {
+
+TEST(ProgressiveSampler, testRefine) {
+  auto data = prepare_data(1000000);
+  auto source = std::make_shared<ProgressiveDataSource>(1000000);
+  ProgressiveSampler sampler(source);
+  sampler.setWindowSize(100);
+  sampler.setSampleSize(10000);
+  ASSERT_EQ(0u, sampler.getSampleSize());
+
+  // A coarse sample of what arrived so far.
+  source->write(200000, data.constData() + 200000, 100000);
+  ASSERT_TRUE(sampler.refine());
+  ASSERT_EQ(10000u, sampler.getSampleSize());
+  for (size_t i = 1; i + 1 < 10000; ++i) {
+    size_t offset = sampler.getFileOffset(i);
+    ASSERT_GE(offset, 200000u);
+    ASSERT_LT(offset, 300000u);
+    ASSERT_EQ(data[static_cast<int>(offset)], sampler[i]);
+    ASSERT_EQ(i, sampler.getSampleOffset(offset));
+  }
+
+  // Not worth resampling yet.
+  source->write(0, data.constData(), 1000);
+  ASSERT_FALSE(sampler.refine());
+
+  source->write(0, data.constData(), 1000000);
+  ASSERT_TRUE(sampler.refine());
+  ASSERT_FALSE(sampler.refine());
+  ASSERT_EQ(10000u, sampler.getSampleSize());
+  size_t outside = 0;
+  for (size_t i = 1; i + 1 < 10000; ++i) {
+    size_t offset = sampler.getFileOffset(i);
+    outside += offset < 200000 || offset >= 300000;
+    ASSERT_EQ(data[static_cast<int>(offset)], sampler[i]);
+  }
+  EXPECT_GT(outside, 10000u * 8 / 10);
+}
+
+TEST(ProgressiveSampler, testSparseData) {
+  auto data = prepare_data(100000);
+  auto source = std::make_shared<ProgressiveDataSource>(100000);
+  ProgressiveSampler sampler(source);
+  sampler.setWindowSize(10);
+  sampler.setSampleSize(10000);
+  // Less data arrived than the requested sample size - take all of it
+  // that fits in windows.
+  source->write(5, data.constData() + 5, 1000);
+  source->write(50000, data.constData() + 50000, 25);
+  ASSERT_TRUE(sampler.refine());
+  ASSERT_EQ(1020u, sampler.getSampleSize());
+  for (size_t i = 1; i + 1 < 1020; ++i) {
+    size_t offset = sampler.getFileOffset(i);
+    ASSERT_EQ(data[static_cast<int>(offset)], sampler[i]);
+  }
+}
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,265 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/sample_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "mock_sampler.h"
+#include "util/sampling/entropy_sampler.h"
+#include "util/sampling/sample_pyramid.h"
+#include "util/sampling/uniform_sampler.h"
+
+namespace veles {
+namespace util {
+
+namespace {
+
+struct TestSample : public CachedSample {
+  explicit TestSample(size_t size) : size(size) {}
+  size_t memorySize() const override { return size; }
+  size_t size;
+};
+
+SampleKey testKey(size_t start) {
+  return SampleKey{"test", start, start + 100, 10, 1, 0};
+}
+
+}  // namespace
+
+TEST(SampleCache, computesOnce) {
+  SampleCache cache;
+  int computed = 0;
+  auto compute = [&]() {
+    ++computed;
+    return std::make_shared<TestSample>(10);
+  };
+  auto first = cache.get(testKey(0), compute);
+  auto second = cache.get(testKey(0), compute);
+  ASSERT_EQ(1, computed);
+  ASSERT_EQ(first, second);
+  cache.get(testKey(1), compute);
+  ASSERT_EQ(2, computed);
+  ASSERT_EQ(2u, cache.misses());
+  ASSERT_EQ(20u, cache.memorySize());
+  cache.clear();
+  ASSERT_EQ(0u, cache.memorySize());
+  cache.get(testKey(0), compute);
+  ASSERT_EQ(3, computed);
+}
+
+TEST(SampleCache, cancelledNotCached) {
+  SampleCache cache;
+  ASSERT_EQ(nullptr, cache.get(testKey(0), []() { return nullptr; }));
+  int computed = 0;
+  cache.get(testKey(0), [&]() {
+    ++computed;
+    return std::make_shared<TestSample>(10);
+  });
+  ASSERT_EQ(1, computed);
+}
+
+TEST(SampleCache, failedNotCached) {
+  SampleCache cache;
+  ASSERT_THROW(cache.get(testKey(0),
+                         []() -> std::shared_ptr<const CachedSample> {
+                           throw std::runtime_error("read failed");
+                         }),
+               std::runtime_error);
+  int computed = 0;
+  auto sample = cache.get(testKey(0), [&]() {
+    ++computed;
+    return std::make_shared<TestSample>(10);
+  });
+  ASSERT_EQ(1, computed);
+  ASSERT_NE(nullptr, sample);
+}
+
+TEST(SampleCache, waitersRetryAfterFailure) {
+  SampleCache cache;
+  std::atomic<bool> started(false);
+  std::thread failing([&]() {
+    EXPECT_THROW(cache.get(testKey(0),
+                           [&]() -> std::shared_ptr<const CachedSample> {
+                             started = true;
+                             std::this_thread::sleep_for(
+                                 std::chrono::milliseconds(50));
+                             throw std::runtime_error("read failed");
+                           }),
+                 std::runtime_error);
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  auto sample = cache.get(testKey(0),
+                          []() { return std::make_shared<TestSample>(10); });
+  failing.join();
+  ASSERT_NE(nullptr, sample);
+}
+
+TEST(SampleCache, evictsLeastRecentlyUsed) {
+  SampleCache cache(25);
+  int computed = 0;
+  auto compute = [&]() {
+    ++computed;
+    return std::make_shared<TestSample>(10);
+  };
+  auto kept = cache.get(testKey(0), compute);
+  cache.get(testKey(1), compute);
+  cache.get(testKey(0), compute);
+  cache.get(testKey(2), compute);
+  ASSERT_EQ(3, computed);
+  ASSERT_EQ(20u, cache.memorySize());
+  // Key 1 was used least recently.
+  cache.get(testKey(0), compute);
+  ASSERT_EQ(3, computed);
+  cache.get(testKey(1), compute);
+  ASSERT_EQ(4, computed);
+  // Evicted samples stay alive as long as someone holds them.
+  ASSERT_EQ(10u, static_cast<const TestSample&>(*kept).size);
+}
+
+TEST(SampleCache, concurrentRequests) {
+  SampleCache cache;
+  std::atomic<int> computed(0);
+  std::vector<std::shared_ptr<const CachedSample>> results(4);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      results[i] = cache.get(testKey(0), [&]() {
+        ++computed;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::make_shared<TestSample>(10);
+      });
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(1, computed.load());
+  for (const auto& result : results) {
+    ASSERT_EQ(results[0], result);
+  }
+}
+
+TEST(SampleCache, sharedBetweenSamplers) {
+  auto data = prepare_data(1000000);
+  auto source = std::make_shared<QByteArrayDataSource>(data);
+  auto cache = std::make_shared<SampleCache>();
+
+  UniformSampler uniform(source);
+  uniform.setSampleCache(cache);
+  uniform.setSampleSize(10000);
+  UniformSampler other_uniform(source);
+  other_uniform.setSampleCache(cache);
+  other_uniform.setSampleSize(10000);
+  ASSERT_EQ(1u, cache->misses());
+  ASSERT_EQ(uniform.data(), other_uniform.data());
+
+  std::unique_ptr<ISampler> clone(uniform.clone());
+  ASSERT_EQ(1u, cache->misses());
+  ASSERT_EQ(uniform.data(), clone->data());
+
+  // Different range, seed or method means a different sample.
+  other_uniform.setRange(1000, 500000);
+  ASSERT_EQ(2u, cache->misses());
+  other_uniform.setRange(0, 1000000);
+  ASSERT_EQ(uniform.data(), other_uniform.data());
+  other_uniform.setSeed(1);
+  ASSERT_EQ(3u, cache->misses());
+  ASSERT_NE(uniform.data(), other_uniform.data());
+
+  EntropySampler entropy(source);
+  entropy.setSampleCache(cache);
+  entropy.setSampleSize(10000);
+  EntropySampler other_entropy(source);
+  other_entropy.setSampleCache(cache);
+  other_entropy.setSampleSize(10000);
+  ASSERT_EQ(4u, cache->misses());
+  ASSERT_EQ(entropy.data(), other_entropy.data());
+  ASSERT_EQ(entropy.getBlockEntropy(), other_entropy.getBlockEntropy());
+
+  // Incremental samples depend on the previous sample, so they aren't
+  // cached, but samples from the cache are used by incremental samplers.
+  UniformSampler incremental(source);
+  incremental.setSampleCache(cache);
+  incremental.setIncrementalResampling(true);
+  incremental.setSampleSize(10000);
+  ASSERT_EQ(uniform.data(), incremental.data());
+  incremental.setRange(100000, 600000);
+  size_t misses = cache->misses();
+  UniformSampler shifted(source);
+  shifted.setSampleCache(cache);
+  shifted.setSampleSize(10000);
+  shifted.setRange(100000, 600000);
+  ASSERT_EQ(misses + 1, cache->misses());
+  ASSERT_NE(incremental.data(), shifted.data());
+  UniformSampler uncached(source);
+  uncached.setSampleSize(10000);
+  uncached.setRange(100000, 600000);
+  ASSERT_EQ(0, memcmp(uncached.data(), shifted.data(),
+                      shifted.getSampleSize()));
+  incremental.setRange(0, 1000000);
+  ASSERT_EQ(uniform.data(), incremental.data());
+}
+
+TEST(SampleCache, pyramid) {
+  auto data = prepare_data(1000000);
+  auto source = std::make_shared<QByteArrayDataSource>(data);
+  SampleCache cache;
+  ASSERT_EQ(nullptr, cache.findPyramid(source, 100000));
+  auto pyramid = cache.pyramid(source, 100000);
+  ASSERT_EQ(pyramid, cache.pyramid(source, 100000));
+  ASSERT_EQ(pyramid, cache.findPyramid(source, 100000));
+  ASSERT_NE(pyramid, cache.pyramid(source, 50000));
+
+  // Same size and seed, but different data.
+  auto other_source = std::make_shared<QByteArrayDataSource>(data);
+  auto other_pyramid = cache.pyramid(other_source, 100000);
+  ASSERT_NE(pyramid, other_pyramid);
+  ASSERT_EQ(other_source, other_pyramid->source());
+
+  cache.clear();
+  ASSERT_EQ(nullptr, cache.findPyramid(source, 100000));
+}
+
+TEST(SampleCache, pyramidBuiltOnce) {
+  auto data = prepare_data(1000000);
+  auto source = std::make_shared<QByteArrayDataSource>(data);
+  SampleCache cache;
+  std::vector<std::shared_ptr<const SamplePyramid>> pyramids(4);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < pyramids.size(); ++i) {
+    threads.emplace_back([&cache, &source, &pyramids, i]() {
+      pyramids[i] = cache.pyramid(source, 100000);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& pyramid : pyramids) {
+    ASSERT_EQ(pyramids[0], pyramid);
+  }
+}
+
+}  // namespace util
+}  // namespace veles
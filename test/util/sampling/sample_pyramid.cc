@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "util/sampling/sample_pyramid.h"
+
+#include <atomic>
+#include <memory>
+
+#include "mock_sampler.h"
+
+namespace veles {
+namespace util {
+
+namespace {
+
+// Counts reads, to tell lookups from resampling.
+class CountingDataSource : public QByteArrayDataSource {
+ public:
+  explicit CountingDataSource(const QByteArray& data)
+      : QByteArrayDataSource(data), reads(0) {}
+
+  void read(uint64_t offset, uint64_t size, char* out) const override {
+    ++reads;
+    QByteArrayDataSource::read(offset, size, out);
+  }
+  const char* contiguousData() const override { return nullptr; }
+
+  mutable std::atomic<int> reads;
+};
+
+void checkSample(PyramidSampler* sampler, const QByteArray& data) {
+  size_t size = sampler->getSampleSize();
+  auto range = sampler->getRange();
+  size_t prev = range.first;
+  for (size_t i = 1; i + 1 < size; ++i) {
+    size_t offset = sampler->getFileOffset(i);
+    ASSERT_LT(prev, offset);
+    ASSERT_LT(offset, range.second);
+    ASSERT_EQ(data[static_cast<int>(offset)], (*sampler)[i]);
+    ASSERT_EQ(i, sampler->getSampleOffset(offset));
+    prev = offset;
+  }
+}
+
+}  // namespace
+
+TEST(SamplePyramid, levels) {
+  auto data = prepare_data(10000000);
+  SamplePyramid pyramid(std::make_shared<QByteArrayDataSource>(data),
+                        1000000);
+  ASSERT_EQ(1000u, pyramid.windowSize());
+  ASSERT_EQ(1000u, pyramid.windows(0).size());
+  ASSERT_EQ(4u, pyramid.levels());
+  for (size_t level = 1; level < pyramid.levels(); ++level) {
+    ASSERT_EQ((pyramid.windows(level - 1).size() + 1) / 2,
+              pyramid.windows(level).size());
+    ASSERT_EQ(pyramid.windows(level - 1)[2], pyramid.windows(level)[1]);
+    ASSERT_EQ(0, memcmp(pyramid.data(level - 1) + 2 * 1000,
+                        pyramid.data(level) + 1000, 1000));
+  }
+  EXPECT_LT(pyramid.memorySize(), 2000000u);
+}
+
+TEST(PyramidSampler, lookup) {
+  auto data = prepare_data(10000000);
+  auto source = std::make_shared<CountingDataSource>(data);
+  auto pyramid = std::make_shared<SamplePyramid>(source, 1000000);
+  PyramidSampler sampler(pyramid);
+  sampler.setSampleSize(100000);
+  int reads = source->reads;
+
+  // Whole data - the level with 1/8 of the windows of level 0.
+  ASSERT_EQ(100000u, sampler.getSampleSize());
+  checkSample(&sampler, data);
+
+  // A quarter of data - the level with 1/2 of the windows.
+  sampler.setRange(2500000, 5000000);
+  ASSERT_EQ(100000u, sampler.getSampleSize());
+  checkSample(&sampler, data);
+  ASSERT_EQ(reads, source->reads);
+
+  std::unique_ptr<ISampler> clone(sampler.clone());
+  ASSERT_EQ(sampler.getSampleSize(), clone->getSampleSize());
+  ASSERT_EQ(reads, source->reads);
+}
+
+TEST(PyramidSampler, deepZoom) {
+  auto data = prepare_data(10000000);
+  auto source = std::make_shared<CountingDataSource>(data);
+  auto pyramid = std::make_shared<SamplePyramid>(source, 1000000);
+  PyramidSampler sampler(pyramid);
+  sampler.setSampleSize(100000);
+  int reads = source->reads;
+  sampler.setRange(1000000, 1500000);
+  ASSERT_LT(reads, source->reads);
+  ASSERT_EQ(316u * 316u, sampler.getSampleSize());
+  checkSample(&sampler, data);
+}
+
+}  // namespace util
+}  // namespace veles
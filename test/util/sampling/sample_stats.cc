@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/sampling/sample_stats.h"
+
+#include <memory>
+
+#include "mock_sampler.h"
+#include "util/sampling/fake_sampler.h"
+#include "util/sampling/uniform_sampler.h"
+
+namespace veles {
+namespace util {
+
+namespace {
+
+/** Check that stats are those of the sample they were updated to.  */
+void expectCounted(const SampleStats& stats) {
+  auto snapshot = stats.snapshot();
+  SampleStats expected;
+  expected.update(snapshot);
+  ASSERT_EQ(snapshot->getSampleSize(), stats.stats().size());
+  ASSERT_EQ(expected.stats().bytes(), stats.stats().bytes());
+  ASSERT_EQ(expected.stats().digrams(), stats.stats().digrams());
+  ASSERT_EQ(expected.stats().trigrams(), stats.stats().trigrams());
+}
+
+}  // namespace
+
+TEST(SampleStats, unsampledRange) {
+  auto data = prepare_data(1000000);
+  FakeSampler sampler(data);
+  SampleStats stats;
+  sampler.setRange(0, 500000);
+  ASSERT_FALSE(stats.update(sampler.snapshot()));
+  ASSERT_EQ(1u, stats.snapshot()->getWindowCount());
+  ASSERT_EQ(500000u, stats.stats().size());
+  for (size_t start : {1000, 5000, 2000, 100000}) {
+    sampler.setRange(start, start + 500000);
+    ASSERT_TRUE(stats.update(sampler.snapshot()));
+    expectCounted(stats);
+  }
+  sampler.setRange(500000, 1000000);
+  ASSERT_FALSE(stats.update(sampler.snapshot()));
+  expectCounted(stats);
+}
+
+TEST(SampleStats, incrementalSample) {
+  auto data = prepare_data(1000000);
+  UniformSampler sampler(data);
+  sampler.setIncrementalResampling(true);
+  sampler.setSampleSize(10000);
+  SampleStats stats;
+  stats.update(sampler.snapshot());
+  ASSERT_EQ(10000u, stats.stats().size());
+  for (size_t start : {1000, 5000, 2000, 10000}) {
+    sampler.setRange(start, start + 900000);
+    // Windows kept from the previous sample aren't counted again.
+    ASSERT_TRUE(stats.update(sampler.snapshot()));
+    expectCounted(stats);
+  }
+}
+
+TEST(SampleStats, otherData) {
+  auto data = prepare_data(1000);
+  FakeSampler sampler(data);
+  FakeSampler other(QByteArray(1000, 'a'));
+  SampleStats stats;
+  stats.update(sampler.snapshot());
+  ASSERT_FALSE(stats.update(other.snapshot()));
+  ASSERT_EQ(999u, stats.stats().digrams()['a' * 256 + 'a']);
+}
+
+}  // namespace util
+}  // namespace veles
@@ -17,6 +17,10 @@
 
 #include "util/sampling/uniform_sampler.h"
 
+#include <cstring>
+#include <set>
+#include <vector>
+
 #include "mock_sampler.h"
 
 namespace veles {
@@ -72,5 +76,136 @@ TEST(UniformSampler, testOffsets) {
   }
 }
 
+TEST(UniformSampler, testSeed) {
+  auto data = prepare_data(1000000);
+  UniformSampler first(data), second(data), other(data);
+  first.setSampleSize(50000);
+  second.setSampleSize(50000);
+  other.setSeed(1);
+  other.setSampleSize(50000);
+  ASSERT_EQ(first.getSampleSize(), second.getSampleSize());
+  ASSERT_EQ(first.getSampleSize(), other.getSampleSize());
+  bool all_equal = true;
+  for (size_t i = 0; i < first.getSampleSize(); ++i) {
+    ASSERT_EQ(first.getFileOffset(i), second.getFileOffset(i));
+    ASSERT_EQ(first[i], second[i]);
+    all_equal = all_equal && first.getFileOffset(i) == other.getFileOffset(i);
+  }
+  ASSERT_FALSE(all_equal);
+
+  second.setSeed(1);
+  for (size_t i = 1; i + 1 < other.getSampleSize(); ++i) {
+    ASSERT_EQ(other.getFileOffset(i), second.getFileOffset(i));
+    ASSERT_EQ(data[static_cast<int>(other.getFileOffset(i))], other[i]);
+  }
+}
+
+namespace {
+
+// Checks that sample bytes match the data at the reported file offsets and
+// returns the set of file offsets of window starts.
+std::set<size_t> checkSample(UniformSampler* sampler, const QByteArray& data,
+                             size_t window_size) {
+  std::set<size_t> starts;
+  auto range = sampler->getRange();
+  size_t size = sampler->getSampleSize();
+  for (size_t i = window_size; i + window_size < size; ++i) {
+    size_t offset = sampler->getFileOffset(i);
+    EXPECT_GE(offset, range.first);
+    EXPECT_LT(offset, range.second);
+    EXPECT_EQ(data[static_cast<int>(offset)], (*sampler)[i]);
+    if (i % window_size == 0) {
+      starts.insert(offset);
+    }
+  }
+  return starts;
+}
+
+}  // namespace
+
+TEST(UniformSampler, testIncrementalShift) {
+  auto data = prepare_data(1000000);
+  UniformSampler sampler(data);
+  sampler.setIncrementalResampling(true);
+  sampler.setWindowSize(10);
+  sampler.setSampleSize(20000);
+  sampler.setRange(0, 500000);
+  auto before = checkSample(&sampler, data, 10);
+  sampler.setRange(100000, 600000);
+  ASSERT_EQ(20000u, sampler.getSampleSize());
+  auto after = checkSample(&sampler, data, 10);
+
+  size_t common = 0, in_new_part = 0;
+  for (size_t offset : after) {
+    common += before.count(offset);
+    in_new_part += offset >= 500000;
+  }
+  // 4/5 of the windows are still in range and should be reused, the new
+  // part of the range should get its share of new windows.
+  EXPECT_GT(common, after.size() * 7 / 10);
+  EXPECT_GT(in_new_part, after.size() / 10);
+  EXPECT_LT(in_new_part, after.size() * 3 / 10);
+}
+
+TEST(UniformSampler, testIncrementalShrinkAndGrow) {
+  auto data = prepare_data(1000000);
+  UniformSampler sampler(data);
+  sampler.setIncrementalResampling(true);
+  sampler.setWindowSize(10);
+  sampler.setSampleSize(20000);
+  auto full = checkSample(&sampler, data, 10);
+  sampler.setRange(250000, 750000);
+  ASSERT_EQ(20000u, sampler.getSampleSize());
+  auto shrunk = checkSample(&sampler, data, 10);
+  size_t common = 0;
+  for (size_t offset : shrunk) {
+    common += full.count(offset);
+  }
+  EXPECT_GT(common, shrunk.size() * 4 / 10);
+  EXPECT_LT(common, shrunk.size() * 6 / 10);
+
+  sampler.setRange(0, 1000000);
+  ASSERT_EQ(20000u, sampler.getSampleSize());
+  auto grown = checkSample(&sampler, data, 10);
+  size_t in_middle = 0;
+  for (size_t offset : grown) {
+    in_middle += offset >= 250000 && offset < 750000;
+  }
+  EXPECT_GT(in_middle, grown.size() * 4 / 10);
+  EXPECT_LT(in_middle, grown.size() * 6 / 10);
+}
+
+TEST(UniformSampler, testSnapshot) {
+  auto data = prepare_data(10000);
+  UniformSampler sampler(data);
+  sampler.setSampleSize(400);
+  auto snapshot = sampler.snapshot();
+  ASSERT_EQ(sampler.getSampleSize(), snapshot->getSampleSize());
+  ASSERT_EQ(sampler.data(), snapshot->data());
+  for (size_t i = 0; i <= snapshot->getSampleSize(); ++i) {
+    ASSERT_EQ(sampler.getFileOffset(i), snapshot->getFileOffset(i));
+  }
+  for (size_t address = 0; address < 10000; address += 7) {
+    ASSERT_EQ(sampler.getSampleOffset(address),
+              snapshot->getSampleOffset(address));
+  }
+
+  // Old snapshots outlive resampling.
+  std::vector<char> old_sample(snapshot->data(),
+                               snapshot->data() + snapshot->getSampleSize());
+  sampler.setRange(5000, 5200);
+  ASSERT_EQ(0, memcmp(old_sample.data(), snapshot->data(), old_sample.size()));
+  ASSERT_EQ(10000u, snapshot->getRange().second);
+
+  // No sampling required - the snapshot is the input data.
+  auto small = sampler.snapshot();
+  ASSERT_EQ(5000u, small->getRange().first);
+  ASSERT_EQ(5200u, small->getRange().second);
+  ASSERT_EQ(200u, small->getSampleSize());
+  ASSERT_EQ(0, memcmp(data.constData() + 5000, small->data(), 200));
+  ASSERT_EQ(5100u, small->getFileOffset(100));
+  ASSERT_EQ(100u, small->getSampleOffset(5100));
+}
+
 }  // namespace util
 }  // namespace veles
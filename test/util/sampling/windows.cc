@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "util/sampling/windows.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace veles {
+namespace util {
+
+TEST(SamplingWindows, testAllocateWindows) {
+  auto counts = allocateWindows(100, {1, 1, 8, 0}, {50, 50, 40, 50});
+  ASSERT_EQ(4u, counts.size());
+  EXPECT_EQ(30u, counts[0]);
+  EXPECT_EQ(30u, counts[1]);
+  EXPECT_EQ(40u, counts[2]);
+  EXPECT_EQ(0u, counts[3]);
+
+  counts = allocateWindows(10, {1, 1, 1}, {10, 10, 10});
+  EXPECT_EQ(10u, counts[0] + counts[1] + counts[2]);
+  EXPECT_EQ(4u, counts[0]);
+
+  counts = allocateWindows(100, {1, 2}, {10, 20});
+  EXPECT_EQ(10u, counts[0]);
+  EXPECT_EQ(20u, counts[1]);
+}
+
+TEST(SamplingWindows, testDrawWindows) {
+  auto generator = windowsGenerator(0, 0);
+  std::vector<size_t> windows(100);
+  for (size_t length : {1000, 1001, 1500}) {
+    drawWindows(length, windows.size(), 10, &generator, windows.data());
+    for (size_t i = 1; i < windows.size(); ++i) {
+      ASSERT_GE(windows[i], windows[i - 1] + 10);
+    }
+    ASSERT_LE(windows.back() + 10, length);
+  }
+}
+
+TEST(SamplingWindows, testDrawWindowsInBlocks) {
+  std::vector<size_t> windows(100);
+  size_t length = 1500;
+  for (size_t block = 0; block < 4; ++block) {
+    auto generator = windowsGenerator(0, block);
+    drawWindowOffsets(length - windows.size() * 10, 25, &generator,
+                      windows.data() + block * 25);
+  }
+  spreadWindows(windows.size(), 10, windows.data());
+  for (size_t i = 1; i < windows.size(); ++i) {
+    ASSERT_GE(windows[i], windows[i - 1] + 10);
+  }
+  ASSERT_LE(windows.back() + 10, length);
+}
+
+TEST(SamplingWindows, testWindowsGenerator) {
+  EXPECT_EQ(windowsGenerator(1, 2, 3)(), windowsGenerator(1, 2, 3)());
+  EXPECT_EQ(windowsGenerator(1, 2)(), windowsGenerator(1, 2, 0)());
+  EXPECT_NE(windowsGenerator(1, 2)(), windowsGenerator(1, 2, 3)());
+  EXPECT_NE(windowsGenerator(1, 2)(), windowsGenerator(1, 3)());
+}
+
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/stats/byte_stats.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace veles {
+namespace util {
+namespace stats {
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t size, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::vector<uint8_t> res(size);
+  for (auto& byte : res) {
+    // Skewed, so that the counts differ between values.
+    byte = static_cast<uint8_t>(gen() % 256 & gen() % 256);
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST(ByteStats, Histogram) {
+  std::vector<uint8_t> data = {1, 2, 2, 3, 3, 3, 255, 0, 0, 0, 0};
+  ByteHistogram hist = histogram(data.data(), data.size());
+  EXPECT_EQ(hist[0], 4u);
+  EXPECT_EQ(hist[1], 1u);
+  EXPECT_EQ(hist[2], 2u);
+  EXPECT_EQ(hist[3], 3u);
+  EXPECT_EQ(hist[255], 1u);
+  EXPECT_EQ(hist[4], 0u);
+  accumulateHistogram(data.data(), 3, &hist);
+  EXPECT_EQ(hist[1], 2u);
+  EXPECT_EQ(hist[2], 4u);
+}
+
+TEST(ByteStats, LargeInputsMatchSerial) {
+  // Big enough to be split between threads.
+  std::vector<uint8_t> data = randomBytes(20 << 20, 1);
+  ByteHistogram expected_hist;
+  expected_hist.fill(0);
+  uint64_t expected_sum = 0;
+  for (uint8_t byte : data) {
+    expected_hist[byte]++;
+    expected_sum += byte;
+  }
+  EXPECT_EQ(histogram(data.data(), data.size()), expected_hist);
+  EXPECT_EQ(sum(data.data(), data.size()), expected_sum);
+  MinMax min_max = minMax(data.data(), data.size());
+  EXPECT_EQ(min_max.min, 0u);
+  EXPECT_EQ(min_max.max, 255u);
+}
+
+TEST(ByteStats, DigramHistogram) {
+  std::vector<uint8_t> data = {1, 2, 1, 2, 3};
+  std::vector<uint64_t> counts(256 * 256, 7);
+  std::vector<uint64_t> sums(256 * 256, 7);
+  digramHistogram(data.data(), data.size(), counts.data(), sums.data());
+  EXPECT_EQ(counts[1 * 256 + 2], 2u);
+  EXPECT_EQ(sums[1 * 256 + 2], 0u + 2u);
+  EXPECT_EQ(counts[2 * 256 + 1], 1u);
+  EXPECT_EQ(sums[2 * 256 + 1], 1u);
+  EXPECT_EQ(counts[2 * 256 + 3], 1u);
+  EXPECT_EQ(sums[2 * 256 + 3], 3u);
+  EXPECT_EQ(counts[0], 0u);
+  digramHistogram(data.data(), 1, counts.data());
+  EXPECT_EQ(counts[1 * 256 + 2], 0u);
+}
+
+TEST(ByteStats, LargeDigramMatchesSerial) {
+  std::vector<uint8_t> data = randomBytes(12 << 20, 2);
+  std::vector<uint64_t> expected_counts(256 * 256);
+  std::vector<uint64_t> expected_sums(256 * 256);
+  for (size_t i = 0; i + 1 < data.size(); i++) {
+    expected_counts[data[i] * 256 + data[i + 1]]++;
+    expected_sums[data[i] * 256 + data[i + 1]] += i;
+  }
+  std::vector<uint64_t> counts(256 * 256);
+  std::vector<uint64_t> sums(256 * 256);
+  digramHistogram(data.data(), data.size(), counts.data(), sums.data());
+  EXPECT_EQ(counts, expected_counts);
+  EXPECT_EQ(sums, expected_sums);
+}
+
+TEST(ByteStats, Entropy) {
+  std::vector<uint8_t> data(1024, 42);
+  EXPECT_EQ(entropy(data.data(), data.size()), 0.0);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  EXPECT_DOUBLE_EQ(entropy(data.data(), data.size()), 8.0);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i % 2);
+  }
+  EXPECT_DOUBLE_EQ(entropy(data.data(), data.size()), 1.0);
+  EXPECT_EQ(entropy(data.data(), 0), 0.0);
+}
+
+TEST(ByteStats, SumAndMean) {
+  std::vector<uint8_t> data = randomBytes(1000, 3);
+  uint64_t expected = 0;
+  for (uint8_t byte : data) {
+    expected += byte;
+  }
+  // Odd sizes and offsets exercise the scalar head and tail.
+  EXPECT_EQ(sum(data.data(), data.size()), expected);
+  EXPECT_EQ(sum(data.data() + 1, 0), 0u);
+  EXPECT_EQ(sum(data.data() + 3, 1), data[3]);
+  EXPECT_DOUBLE_EQ(mean(data.data(), data.size()),
+                   static_cast<double>(expected) / data.size());
+  EXPECT_EQ(mean(data.data(), 0), 0.0);
+}
+
+TEST(ByteStats, MinMax) {
+  std::vector<uint8_t> data(100, 50);
+  data[37] = 3;
+  data[99] = 200;
+  MinMax res = minMax(data.data(), data.size());
+  EXPECT_EQ(res.min, 3u);
+  EXPECT_EQ(res.max, 200u);
+  res = minMax(data.data() + 38, 5);
+  EXPECT_EQ(res.min, 50u);
+  EXPECT_EQ(res.max, 50u);
+}
+
+TEST(ByteStats, SlidingHistogram) {
+  std::vector<uint8_t> data = {0, 1, 0, 1, 7, 7, 7, 7};
+  SlidingHistogram window;
+  for (size_t i = 0; i < 4; i++) {
+    window.add(data[i]);
+  }
+  EXPECT_EQ(window.total(), 4u);
+  EXPECT_DOUBLE_EQ(window.entropy(), 1.0);
+  for (size_t i = 4; i < data.size(); i++) {
+    window.remove(data[i - 4]);
+    window.add(data[i]);
+  }
+  EXPECT_EQ(window.counts()[7], 4u);
+  EXPECT_EQ(window.entropy(), 0.0);
+  window.clear();
+  EXPECT_EQ(window.total(), 0u);
+  EXPECT_EQ(window.entropy(), 0.0);
+}
+
+TEST(ByteStats, EntropyTable) {
+  EntropyTable table(1000);
+  EXPECT_EQ(table.maxSize(), 1000u);
+  ByteHistogram hist;
+  hist.fill(0);
+  EXPECT_EQ(table.entropy(hist, 0), 0.0);
+  hist[3] = 1000;
+  EXPECT_EQ(table.entropy(hist, 1000), 0.0);
+  hist.fill(2);
+  EXPECT_NEAR(table.entropy(hist, 512), 8.0, 1e-9);
+  auto data = randomBytes(1000, 5);
+  for (size_t size : {1, 2, 17, 256, 999, 1000}) {
+    hist = histogram(data.data(), size);
+    EXPECT_NEAR(table.entropy(hist, size), entropy(hist, size), 1e-6);
+  }
+}
+
+TEST(ByteStats, SlidingEntropy) {
+  const size_t k = 257;
+  EntropyTable table(k);
+  auto data = randomBytes(1 << 16, 6);
+  SlidingEntropy window(&table);
+  SlidingHistogram expected;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (i >= k) {
+      window.remove(data[i - k]);
+      expected.remove(data[i - k]);
+    }
+    window.add(data[i]);
+    expected.add(data[i]);
+    ASSERT_NEAR(window.entropy(), expected.entropy(), 1e-6);
+  }
+  EXPECT_EQ(window.counts(), expected.counts());
+  // Fixed point sums don't drift: the slid window has exactly the entropy
+  // of one filled from scratch.
+  SlidingEntropy fresh(&table);
+  for (size_t i = data.size() - k; i < data.size(); ++i) {
+    fresh.add(data[i]);
+  }
+  EXPECT_EQ(window.entropy(), fresh.entropy());
+  EXPECT_EQ(window.entropy(), table.entropy(window.counts(), k));
+  window.clear();
+  EXPECT_EQ(window.total(), 0u);
+  EXPECT_EQ(window.entropy(), 0.0);
+}
+
+}  // namespace stats
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "util/stats/ngram_stats.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace veles {
+namespace util {
+namespace stats {
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t size, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::vector<uint8_t> res(size);
+  for (auto& byte : res) {
+    byte = static_cast<uint8_t>(gen() % 256 & gen() % 256);
+  }
+  return res;
+}
+
+NgramStats::Window window(const std::vector<uint8_t>& data, uint64_t offset,
+                          size_t size) {
+  return NgramStats::Window{offset, data.data() + offset, size};
+}
+
+void expectSame(const NgramStats& expected, const NgramStats& stats) {
+  EXPECT_EQ(expected.size(), stats.size());
+  EXPECT_EQ(expected.bytes(), stats.bytes());
+  EXPECT_EQ(expected.digrams(), stats.digrams());
+  EXPECT_EQ(expected.digramOffsetSums(), stats.digramOffsetSums());
+  EXPECT_EQ(expected.trigrams(), stats.trigrams());
+}
+
+}  // namespace
+
+TEST(NgramStats, counts) {
+  std::vector<uint8_t> data = {4, 8, 4, 8, 12, 99, 99, 4, 8, 13};
+  NgramStats stats;
+  // Windows [0, 5) and [7, 10) - n-grams across them are not counted.
+  EXPECT_FALSE(stats.setWindows({window(data, 0, 5), window(data, 7, 3)}));
+  EXPECT_EQ(stats.size(), 8u);
+  EXPECT_EQ(stats.bytes()[4], 3u);
+  EXPECT_EQ(stats.bytes()[99], 0u);
+  EXPECT_EQ(stats.digrams()[4 * 256 + 8], 3u);
+  EXPECT_EQ(stats.digramOffsetSums()[4 * 256 + 8].toDouble(), 0.0 + 2.0 + 7.0);
+  EXPECT_EQ(stats.digrams()[12 * 256 + 4], 0u);
+  EXPECT_EQ(stats.digrams()[8 * 256 + 12], 1u);
+  EXPECT_EQ(stats.trigrams()[NgramStats::trigramCell(4, 8, 4)], 1u);
+  // 4, 8, 12 and 4, 8, 13 are in the same cell.
+  EXPECT_EQ(stats.trigrams()[NgramStats::trigramCell(4, 8, 12)], 2u);
+
+  stats.clear();
+  EXPECT_EQ(stats.size(), 0u);
+  EXPECT_EQ(stats.digrams()[4 * 256 + 8], 0u);
+}
+
+TEST(NgramStats, slidingWindow) {
+  std::vector<uint8_t> data = randomBytes(1 << 20, 1);
+  NgramStats stats;
+  stats.setWindows({window(data, 1000, 200000)});
+  for (uint64_t offset : {1001, 1500, 700, 0, 60000, 59000}) {
+    EXPECT_TRUE(stats.setWindows({window(data, offset, 200000)}));
+    NgramStats expected;
+    expected.setWindows({window(data, offset, 200000)});
+    expectSame(expected, stats);
+  }
+  // A jump with no overlap.
+  EXPECT_FALSE(stats.setWindows({window(data, 700000, 200000)}));
+  // Growing and shrinking.
+  EXPECT_TRUE(stats.setWindows({window(data, 650000, 300000)}));
+  EXPECT_TRUE(stats.setWindows({window(data, 660000, 250000)}));
+  NgramStats expected;
+  expected.setWindows({window(data, 660000, 250000)});
+  expectSame(expected, stats);
+}
+
+TEST(NgramStats, changingWindows) {
+  std::vector<uint8_t> data = randomBytes(1 << 20, 2);
+  std::mt19937 gen(3);
+  // About 64 windows of 1000 bytes, sharing most of them with the previous
+  // set.
+  std::vector<uint64_t> offsets;
+  NgramStats stats;
+  for (int i = 0; i < 20; ++i) {
+    std::vector<uint64_t> next;
+    for (uint64_t offset : offsets) {
+      if (gen() % 8 != 0) {
+        next.push_back(offset);
+      }
+    }
+    while (next.size() < 64) {
+      next.push_back(gen() % 1000 * 1000);
+    }
+    std::sort(next.begin(), next.end());
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+    offsets = next;
+    std::vector<NgramStats::Window> windows;
+    for (uint64_t offset : offsets) {
+      windows.push_back(window(data, offset, 1000));
+    }
+    stats.setWindows(windows);
+    NgramStats expected;
+    expected.setWindows(windows);
+    expectSame(expected, stats);
+  }
+}
+
+TEST(NgramStats, offsetSums) {
+  NgramStats::OffsetSum sum = {0, 0};
+  sum.addProduct(~uint64_t(0), ~uint64_t(0), false);
+  EXPECT_EQ(sum.high, ~uint64_t(0) - 1);
+  EXPECT_EQ(sum.low, 1u);
+  sum.add(~uint64_t(0));
+  EXPECT_EQ(sum.high, ~uint64_t(0));
+  EXPECT_EQ(sum.low, 0u);
+  sum.subtract(1);
+  sum.addProduct(~uint64_t(0), ~uint64_t(0), true);
+  EXPECT_EQ(sum.high, 0u);
+  EXPECT_EQ(sum.low, ~uint64_t(1));
+
+  // Windows far into the data, moved back and forth many times - the sums
+  // must not drift from those counted from scratch.
+  std::vector<uint8_t> data = randomBytes(1 << 20, 5);
+  const uint64_t base = uint64_t(1) << 62;
+  auto far_window = [&data, base](uint64_t offset, size_t size) {
+    return NgramStats::Window{base + offset, data.data() + offset, size};
+  };
+  NgramStats stats;
+  stats.setWindows({far_window(1000, 100000)});
+  for (int i = 0; i < 100; ++i) {
+    stats.setWindows({far_window(i % 2 == 0 ? 3000 : 1000, 100000)});
+  }
+  NgramStats expected;
+  expected.setWindows({far_window(1000, 100000)});
+  expectSame(expected, stats);
+  NgramStats::OffsetSum first = {0, 0};
+  size_t digram = data[1000] * 256 + data[1001];
+  for (uint64_t i = 1000; i + 1 < 101000; ++i) {
+    if (data[i] * 256u + data[i + 1] == digram) {
+      first.add(base + i);
+    }
+  }
+  EXPECT_EQ(first, stats.digramOffsetSums()[digram]);
+}
+
+TEST(NgramStats, maxOrder) {
+  std::vector<uint8_t> data = randomBytes(1 << 20, 6);
+  NgramStats all, bytes(1), digrams(2);
+  EXPECT_EQ(all.maxOrder(), 3);
+  EXPECT_EQ(digrams.maxOrder(), 2);
+  for (uint64_t offset : {1000, 1200}) {
+    all.setWindows({window(data, offset, 100000)});
+    bytes.setWindows({window(data, offset, 100000)});
+    digrams.setWindows({window(data, offset, 100000)});
+    EXPECT_EQ(bytes.size(), all.size());
+    EXPECT_EQ(bytes.bytes(), all.bytes());
+    EXPECT_TRUE(bytes.digrams().empty());
+    EXPECT_TRUE(bytes.trigrams().empty());
+    EXPECT_EQ(digrams.bytes(), all.bytes());
+    EXPECT_EQ(digrams.digrams(), all.digrams());
+    EXPECT_EQ(digrams.digramOffsetSums(), all.digramOffsetSums());
+    EXPECT_TRUE(digrams.trigrams().empty());
+  }
+}
+
+TEST(NgramStats, manySmallWindows) {
+  // Like a sample - counted again from scratch, split between threads.
+  std::vector<uint8_t> data = randomBytes(16 << 20, 7);
+  std::vector<NgramStats::Window> windows;
+  for (uint64_t offset = 0; offset < data.size(); offset += 8 << 10) {
+    windows.push_back(window(data, offset + 100, 2 << 10));
+  }
+  NgramStats stats;
+  EXPECT_FALSE(stats.setWindows(windows));
+  ByteHistogram bytes;
+  bytes.fill(0);
+  std::vector<uint64_t> digrams(256 * 256);
+  std::vector<NgramStats::OffsetSum> offset_sums(256 * 256);
+  std::vector<uint64_t> trigrams(stats.trigrams().size());
+  for (const auto& w : windows) {
+    for (uint64_t i = w.offset; i < w.offset + w.size; ++i) {
+      bytes[data[i]]++;
+      if (i + 1 < w.offset + w.size) {
+        digrams[data[i] * 256 + data[i + 1]]++;
+        offset_sums[data[i] * 256 + data[i + 1]].add(i);
+      }
+      if (i + 2 < w.offset + w.size) {
+        trigrams[NgramStats::trigramCell(data[i], data[i + 1],
+                                         data[i + 2])]++;
+      }
+    }
+  }
+  EXPECT_EQ(stats.size(), windows.size() * (2 << 10));
+  EXPECT_EQ(stats.bytes(), bytes);
+  EXPECT_EQ(stats.digrams(), digrams);
+  EXPECT_EQ(stats.digramOffsetSums(), offset_sums);
+  EXPECT_EQ(stats.trigrams(), trigrams);
+}
+
+TEST(NgramStats, largeWindows) {
+  // Big enough to be counted with the byte_stats kernels and split between
+  // threads.
+  std::vector<uint8_t> data = randomBytes(24 << 20, 4);
+  NgramStats stats;
+  stats.setWindows({window(data, 0, 16 << 20)});
+  EXPECT_TRUE(stats.setWindows({window(data, 6 << 20, 16 << 20)}));
+  std::vector<uint64_t> digrams(256 * 256);
+  std::vector<uint64_t> trigrams(stats.trigrams().size());
+  for (size_t i = 6 << 20; i + 1 < 22 << 20; ++i) {
+    digrams[data[i] * 256 + data[i + 1]]++;
+    if (i + 2 < 22 << 20) {
+      trigrams[NgramStats::trigramCell(data[i], data[i + 1], data[i + 2])]++;
+    }
+  }
+  EXPECT_EQ(stats.bytes(), histogram(data.data() + (6 << 20), 16 << 20));
+  EXPECT_EQ(stats.digrams(), digrams);
+  EXPECT_EQ(stats.trigrams(), trigrams);
+}
+
+}  // namespace stats
+}  // namespace util
+}  // namespace veles
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "visualization/image_renderer.h"
+
+#include <QByteArray>
+#include <QColor>
+#include <QImage>
+
+#include "gtest/gtest.h"
+#include "util/sampling/fake_sampler.h"
+#include "util/sampling/sample_stats.h"
+
+namespace veles {
+namespace visualization {
+
+namespace {
+
+int litPixels(const QImage& image) {
+  int res = 0;
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      if (image.pixel(x, y) != qRgb(0, 0, 0)) {
+        res++;
+      }
+    }
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST(ImageRenderer, digram) {
+  QByteArray data;
+  for (int i = 0; i < 500; ++i) {
+    data.append("ab");
+  }
+  util::FakeSampler sampler(data);
+  util::SampleStats stats;
+  stats.update(sampler.snapshot());
+  QImage image = renderDigram(stats);
+  ASSERT_EQ(image.size(), QSize(256, 256));
+  // Only "ab" and "ba" pairs, the first byte going up.
+  EXPECT_EQ(litPixels(image), 2);
+  EXPECT_NE(image.pixel('b', 255 - 'a'), qRgb(0, 0, 0));
+  EXPECT_NE(image.pixel('a', 255 - 'b'), qRgb(0, 0, 0));
+}
+
+TEST(ImageRenderer, minimap) {
+  util::FakeSampler sampler(QByteArray(100000, '\xff'));
+  auto snapshot = sampler.snapshot();
+  QImage value = renderMinimap(*snapshot,
+                               VisualizationMinimap::MinimapMode::VALUE,
+                               VisualizationMinimap::MinimapColor::GREEN,
+                               20, 100);
+  ASSERT_EQ(value.size(), QSize(20, 100));
+  EXPECT_EQ(value.pixel(0, 0), qRgb(0, 255, 0));
+  EXPECT_EQ(value.pixel(19, 99), qRgb(0, 255, 0));
+  // All bytes are the same, so entropy is 0 everywhere.
+  QImage entropy = renderMinimap(*snapshot,
+                                 VisualizationMinimap::MinimapMode::ENTROPY,
+                                 VisualizationMinimap::MinimapColor::RED,
+                                 20, 100);
+  ASSERT_EQ(entropy.size(), QSize(20, 100));
+  EXPECT_EQ(litPixels(entropy), 0);
+}
+
+TEST(ImageRenderer, trigram) {
+  util::FakeSampler sampler(QByteArray(1000, 'x'));
+  QImage image = renderTrigram(*sampler.snapshot(), 64, 50, Qt::red,
+                               Qt::blue);
+  ASSERT_EQ(image.size(), QSize(64, 64));
+  // Every point is at ('x', 'x', 'x').
+  EXPECT_EQ(litPixels(image), 1);
+  EXPECT_TRUE(renderTrigram(*sampler.snapshot(), 0, 50, Qt::red, Qt::blue)
+                  .isNull());
+}
+
+}  // namespace visualization
+}  // namespace veles
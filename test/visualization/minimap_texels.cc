@@ -0,0 +1,254 @@
+/*
+ * Copyright 2018 CodiLime
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "visualization/minimap_texels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <QByteArray>
+
+#include "gtest/gtest.h"
+#include "util/sampling/fake_sampler.h"
+
+namespace veles {
+namespace visualization {
+namespace minimap {
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t size, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::vector<uint8_t> res(size);
+  for (size_t i = 0; i < size; ++i) {
+    // Skewed, and in runs of varying entropy, so that the texels differ.
+    res[i] = static_cast<uint8_t>((gen() % 256 & gen() % 256) >> (i >> 12) % 8);
+  }
+  return res;
+}
+
+// The straightforward, serial way of calculating the texels: one pass over
+// the sample, byte i belonging to pixel floor(i / point_size), the last
+// pixel taking the rest.
+
+std::vector<std::vector<uint8_t>> naivePixels(const std::vector<uint8_t>& data,
+                                              size_t texture_size) {
+  TextureInput in = textureInput(data.data(), data.size(), texture_size);
+  std::vector<std::vector<uint8_t>> res(texture_size);
+  for (size_t i = 0; i < data.size(); ++i) {
+    auto index = static_cast<size_t>(std::floor(i / in.point_size));
+    res[std::min(index, texture_size - 1)].push_back(data[i]);
+  }
+  return res;
+}
+
+double naiveEntropy(const uint8_t* data, size_t size) {
+  std::vector<uint64_t> counts(256);
+  for (size_t i = 0; i < size; ++i) {
+    counts[data[i]]++;
+  }
+  double res = 0;
+  for (uint64_t count : counts) {
+    if (count != 0) {
+      double p = static_cast<double>(count) / size;
+      res -= p * std::log2(p);
+    }
+  }
+  return res * 32;
+}
+
+std::vector<float> naiveValue(const std::vector<uint8_t>& data,
+                              size_t texture_size) {
+  std::vector<float> res;
+  for (const auto& pixel : naivePixels(data, texture_size)) {
+    uint64_t sum = 0;
+    for (uint8_t byte : pixel) {
+      sum += byte;
+    }
+    res.push_back(pixel.empty() ? 0.0f : sum / pixel.size());
+  }
+  return res;
+}
+
+std::vector<float> naivePerPixelEntropy(const std::vector<uint8_t>& data,
+                                        size_t texture_size) {
+  std::vector<float> res;
+  for (const auto& pixel : naivePixels(data, texture_size)) {
+    res.push_back(
+        static_cast<float>(naiveEntropy(pixel.data(), pixel.size())));
+  }
+  return res;
+}
+
+std::vector<float> naiveSingleWindowEntropy(const std::vector<uint8_t>& data,
+                                            size_t texture_size) {
+  std::vector<uint64_t> counts(256);
+  for (uint8_t byte : data) {
+    counts[byte]++;
+  }
+  std::vector<float> res;
+  for (const auto& pixel : naivePixels(data, texture_size)) {
+    double sum = 0;
+    for (uint8_t byte : pixel) {
+      sum -= std::log2(static_cast<double>(counts[byte]) / data.size());
+    }
+    res.push_back(pixel.empty() ? 0.0f
+                                : static_cast<float>(sum / pixel.size() * 32));
+  }
+  return res;
+}
+
+// A window of k_minimum_entropy_window + 1 bytes (clipped to the sample)
+// slides over the sample one byte per step, and a pixel gets entropy of
+// the last window whose middle is the first byte of the pixel.
+std::vector<float> naiveSlidingWindowEntropy(const std::vector<uint8_t>& data,
+                                             size_t texture_size) {
+  TextureInput in = textureInput(data.data(), data.size(), texture_size);
+  std::vector<float> res(texture_size);
+  size_t start = 0, end = 0;
+  while (start < data.size()) {
+    size_t mid = (start + end) / 2;
+    if (mid > 0 && std::floor(mid / in.point_size) !=
+                       std::floor((mid - 1) / in.point_size)) {
+      res[static_cast<size_t>(mid / in.point_size)] = static_cast<float>(
+          naiveEntropy(data.data() + start, end - start));
+    }
+    if (end > k_minimum_entropy_window || end >= data.size()) {
+      start++;
+    }
+    if (end < data.size()) {
+      end++;
+    }
+  }
+  return res;
+}
+
+void expectNear(const std::vector<float>& expected,
+                const std::vector<float>& texels) {
+  ASSERT_EQ(expected.size(), texels.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], texels[i], 0.01) << "pixel " << i;
+  }
+}
+
+std::vector<float> texels(const std::vector<uint8_t>& data, MinimapMode mode,
+                          size_t texture_size) {
+  QByteArray bytes(reinterpret_cast<const char*>(data.data()),
+                   static_cast<int>(data.size()));
+  util::FakeSampler sampler(bytes);
+  std::vector<float> res;
+  calculateTexels(*sampler.snapshot(), mode, texture_size, &res);
+  return res;
+}
+
+/** Calculates the texture with func, in segments split at random pixels.  */
+template <typename Func>
+std::vector<float> inSegments(const TextureInput& in, Func func) {
+  std::mt19937 gen(7);
+  std::vector<float> res(in.texture_size, -1.0f);
+  size_t first = 0;
+  while (first < in.texture_size) {
+    size_t last = std::min<size_t>(in.texture_size, first + gen() % 100 + 1);
+    func(first, last, res.data());
+    first = last;
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST(MinimapTexels, pixelStart) {
+  TextureInput in = textureInput(nullptr, 1000, 300);
+  size_t previous = 0;
+  for (size_t index = 0; index <= in.texture_size; ++index) {
+    size_t start = pixelStart(index, in.point_size, 1000, 300);
+    EXPECT_GE(start, previous);
+    if (index < in.texture_size) {
+      EXPECT_GE(start / in.point_size, index);
+    }
+    if (start > 0 && index < in.texture_size) {
+      EXPECT_LT((start - 1) / in.point_size, index);
+    }
+    previous = start;
+  }
+  EXPECT_EQ(pixelStart(0, in.point_size, 1000, 300), 0u);
+  EXPECT_EQ(pixelStart(300, in.point_size, 1000, 300), 1000u);
+}
+
+TEST(MinimapTexels, value) {
+  std::vector<uint8_t> small = randomBytes(1000, 1);
+  expectNear(naiveValue(small, 300), texels(small, MinimapMode::VALUE, 300));
+  // Split between several segments.
+  std::vector<uint8_t> big = randomBytes(3 << 20, 2);
+  expectNear(naiveValue(big, 1000), texels(big, MinimapMode::VALUE, 1000));
+  TextureInput in = textureInput(big.data(), big.size(), 1000);
+  expectNear(naiveValue(big, 1000),
+             inSegments(in, [&](size_t first, size_t last, float* out) {
+               calculateAverageValueTexture(in, first, last, out);
+             }));
+}
+
+TEST(MinimapTexels, perPixelEntropy) {
+  std::vector<uint8_t> data = randomBytes(1 << 20, 3);
+  // Pixels longer than the minimum entropy window.
+  expectNear(naivePerPixelEntropy(data, 1000),
+             texels(data, MinimapMode::ENTROPY, 1000));
+  TextureInput in = textureInput(data.data(), data.size(), 1000);
+  util::stats::EntropyTable table(
+      static_cast<size_t>(std::ceil(in.point_size)) + 1);
+  expectNear(naivePerPixelEntropy(data, 1000),
+             inSegments(in, [&](size_t first, size_t last, float* out) {
+               calculateEntropyTexturePerPixel(in, &table, first, last, out);
+             }));
+  expectNear(naivePerPixelEntropy(data, 1000),
+             inSegments(in, [&](size_t first, size_t last, float* out) {
+               calculateEntropyTexturePerPixel(in, nullptr, first, last, out);
+             }));
+}
+
+TEST(MinimapTexels, singleWindowEntropy) {
+  // Smaller than two minimum entropy windows.
+  std::vector<uint8_t> data = randomBytes(400, 4);
+  expectNear(naiveSingleWindowEntropy(data, 150),
+             texels(data, MinimapMode::ENTROPY, 150));
+  expectNear(naiveSingleWindowEntropy(data, 400),
+             texels(data, MinimapMode::ENTROPY, 400));
+}
+
+TEST(MinimapTexels, slidingWindowEntropy) {
+  std::vector<uint8_t> data = randomBytes(1 << 20, 5);
+  expectNear(naiveSlidingWindowEntropy(data, 30000),
+             texels(data, MinimapMode::ENTROPY, 30000));
+  std::vector<uint8_t> small = randomBytes(600, 6);
+  expectNear(naiveSlidingWindowEntropy(small, 600),
+             texels(small, MinimapMode::ENTROPY, 600));
+  expectNear(naiveSlidingWindowEntropy(small, 250),
+             texels(small, MinimapMode::ENTROPY, 250));
+
+  TextureInput in = textureInput(data.data(), data.size(), 30000);
+  util::stats::EntropyTable table(k_minimum_entropy_window + 1);
+  expectNear(naiveSlidingWindowEntropy(data, 30000),
+             inSegments(in, [&](size_t first, size_t last, float* out) {
+               calculateEntropyTextureSlidingWindow(in, table, first, last,
+                                                    out);
+             }));
+}
+
+}  // namespace minimap
+}  // namespace visualization
+}  // namespace veles